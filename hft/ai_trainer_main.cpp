@@ -21,10 +21,16 @@
 #include <cstring>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
 
 #include <boost/program_options.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/algorithm/string/replace.hpp>
 
 #include <easylogging++.h>
 
@@ -32,6 +38,8 @@
 #include <hft_utils.hpp>
 #include <text_file_reader.hpp>
 #include <train_stat.hpp>
+#include <validation_engine.hpp>
+#include <hftr_samples.hpp>
 
 namespace prog_opts = boost::program_options;
 namespace fs = boost::filesystem;
@@ -46,9 +54,27 @@ static struct hft_ai_trainer_options_type
     double train_break_condition;
     size_t collector_size;
     bool json_report;
+    unsigned int histogram_bins;
+    int ncores;
+    bool overlap_validation;
+    std::vector<std::string> ensemble;
+    std::vector<std::string> sweep_arch;
+    std::vector<std::string> sweep_schedule;
+    unsigned int sweep_random;
+    unsigned int sweep_seed;
+    std::string sweep_dir;
+    std::string leaderboard_file_name;
+    hft::activation_accuracy activation_accuracy;
 
 } hft_ai_trainer_options;
 
+//
+// Number of samples parsed at once in ensemble mode.
+// Next block is parsed while networks train on current one.
+//
+
+#define ENSEMBLE_BLOCK_SIZE 2048
+
 
 #define hftOption(__X__) \
     hft_ai_trainer_options.__X__
@@ -56,6 +82,731 @@ static struct hft_ai_trainer_options_type
 #define hft_log(__X__) \
     CLOG(__X__, "ai_trainer")
 
+static std::pair<double, unsigned int> parse_train_suite_item(const std::string &item)
+{
+    boost::char_separator<char> sep(":");
+    std::pair<double, unsigned int> suite;
+    boost::tokenizer<boost::char_separator<char> > tokens(item, sep);
+
+    auto iterator = tokens.begin();
+
+    if (iterator == tokens.end())
+    {
+        std::string err_msg = std::string("No learn coefficient specified in „")
+                              + item + std::string("”");
+
+        throw std::runtime_error(err_msg);
+    }
+
+    suite.first = boost::lexical_cast<double>(*iterator);
+    iterator++;
+
+    if (iterator == tokens.end())
+    {
+        std::string err_msg = std::string("No epochs number specified in „")
+                              + item + std::string("”");
+
+        throw std::runtime_error(err_msg);
+    }
+
+    suite.second = boost::lexical_cast<unsigned int>(*iterator);
+
+    return suite;
+}
+
+//
+// Ensemble mode: all networks are trained on the same samples.
+// Training file is parsed once per epoch in blocks, each worker
+// thread trains its own subset of networks on the block.
+//
+
+struct ensemble_member
+{
+    std::string file_name;
+    neural_network::layers_architecture arch;
+    std::shared_ptr<basic_artifical_inteligence> bai;
+    unsigned int nid;
+    train_stat train_statistics;
+    std::shared_ptr<validation_engine> validator;
+    bool finished;
+};
+
+struct ensemble_worker_data
+{
+    std::vector<ensemble_member *> members;
+    std::exception_ptr error;
+
+    std::shared_ptr<std::thread> thread;
+};
+
+typedef std::vector<ensemble_worker_data> ensemble_workers;
+
+//
+// Ensemble workers are started once for the whole training
+// and handed blocks of samples: „dispatch” wakes all of them
+// on a new block, „wait” returns when every worker is done
+// with it. Workers are stopped and joined on destruction.
+//
+
+class ensemble_pool
+{
+public:
+
+    ensemble_pool(ensemble_workers &workers)
+        : workers_(workers), block_(nullptr), generation_(0), pending_(0), stop_(false)
+    {
+        for (auto &w : workers_)
+        {
+            w.thread.reset(new std::thread(&ensemble_pool::thread_funct, this, &w));
+        }
+    }
+
+    ~ensemble_pool(void)
+    {
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+            stop_ = true;
+        }
+
+        start_cv_.notify_all();
+
+        for (auto &w : workers_)
+        {
+            w.thread -> join();
+            w.thread.reset();
+        }
+    }
+
+    void dispatch(const hftr_samples *block)
+    {
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+
+            block_ = block;
+            pending_ = workers_.size();
+            generation_++;
+        }
+
+        start_cv_.notify_all();
+    }
+
+    void wait(void)
+    {
+        std::unique_lock<std::mutex> lck(mtx_);
+
+        done_cv_.wait(lck, [this]() { return pending_ == 0; });
+
+        for (auto &w : workers_)
+        {
+            if (w.error)
+            {
+                std::exception_ptr error = w.error;
+                w.error = nullptr;
+
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+private:
+
+    void thread_funct(ensemble_worker_data *self);
+
+    ensemble_workers &workers_;
+    const hftr_samples *block_;
+    unsigned long generation_;
+    size_t pending_;
+    bool stop_;
+
+    std::mutex mtx_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+};
+
+static void train_ensemble_block(ensemble_worker_data *self, const hftr_samples &block)
+{
+    for (auto member : self -> members)
+    {
+        if (member -> finished)
+        {
+            continue;
+        }
+
+        basic_artifical_inteligence &bai = *(member -> bai);
+
+        for (size_t i = 0; i < block.size(); i++)
+        {
+            bai.import_input_bus(block.get_pins(i), block.get_inputs());
+            bai.fireup_networks();
+
+            member -> train_statistics.store(bai.get_network_output(member -> nid), block.get_expected(i));
+
+            bai.feedback(block.get_expected(i));
+        }
+    }
+}
+
+void ensemble_pool::thread_funct(ensemble_worker_data *self)
+{
+    unsigned long seen = 0;
+
+    for (;;)
+    {
+        const hftr_samples *block;
+
+        {
+            std::unique_lock<std::mutex> lck(mtx_);
+
+            start_cv_.wait(lck, [this, seen]() { return stop_ || generation_ != seen; });
+
+            if (stop_)
+            {
+                return;
+            }
+
+            seen = generation_;
+            block = block_;
+        }
+
+        try
+        {
+            train_ensemble_block(self, *block);
+        }
+        catch (...)
+        {
+            self -> error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lck(mtx_);
+
+            if (--pending_ == 0)
+            {
+                done_cv_.notify_one();
+            }
+        }
+    }
+}
+
+static int ensemble_training(void)
+{
+    std::vector<ensemble_member> members(hftOption(ensemble).size());
+    std::shared_ptr<hftr_samples> validation_samples;
+
+    if (hftOption(validate_hftr_file_name) != "none")
+    {
+        hft_log(INFO) << "Loading HFTR for validation ["
+                      << hftOption(validate_hftr_file_name)
+                      << "].";
+
+        validation_samples.reset(new hftr_samples(hftOption(validate_hftr_file_name)));
+
+        hft_log(INFO) << "Validation set loaded, ["
+                      << validation_samples -> size()
+                      << "] samples.";
+    }
+
+    unsigned int ncores = hftOption(ncores) > 0 ? hftOption(ncores) : 1;
+
+    for (size_t i = 0; i < members.size(); i++)
+    {
+        ensemble_member &m = members[i];
+        const std::string &item = hftOption(ensemble).at(i);
+        size_t pos = item.rfind(':');
+
+        if (pos == std::string::npos || pos == 0)
+        {
+            throw std::runtime_error(std::string("Invalid ensemble network „") + item + std::string("”, expected <network-file>:<arch>"));
+        }
+
+        m.file_name = item.substr(0, pos);
+        m.arch = neural_network::parse_layers_architecture_from_string(item.substr(pos + 1));
+        m.finished = false;
+
+        if (hftOption(histogram_bins) > 0)
+        {
+            m.train_statistics.enable_histogram(hftOption(histogram_bins));
+        }
+
+        m.bai.reset(new basic_artifical_inteligence());
+        m.bai -> set_opt(basic_artifical_inteligence::AI_OPTION_NEVER_HFTR_EXPORT, true);
+        m.bai -> set_opt(basic_artifical_inteligence::AI_OPTION_HFT_MULTICORE, false);
+        m.bai -> set_opt(basic_artifical_inteligence::AI_OPTION_VERBOSE, false);
+        m.nid = m.bai -> add_neural_network(m.arch, hftOption(activation_accuracy));
+
+        if (! fs::exists(m.file_name))
+        {
+            hft_log(INFO) << "File name: [" << m.file_name
+                          << "] represents new network.";
+        }
+        else
+        {
+            hft_log(INFO) << "Loading neural network ["
+                          << m.file_name
+                          << "].";
+
+            m.bai -> load_network(m.nid, m.file_name);
+        }
+
+        if (validation_samples)
+        {
+            m.validator.reset(new validation_engine(validation_samples, m.arch, ncores,
+                                                    hftOption(histogram_bins),
+                                                    hftOption(activation_accuracy)));
+        }
+    }
+
+    //
+    // Networks are assigned to workers in round robin.
+    //
+
+    ensemble_workers thread_workers(std::min(static_cast<size_t>(ncores), members.size()));
+
+    for (size_t i = 0; i < members.size(); i++)
+    {
+        thread_workers[i % thread_workers.size()].members.push_back(&members[i]);
+    }
+
+    hft_log(INFO) << "Ensemble of [" << members.size()
+                  << "] networks will be trained by ["
+                  << thread_workers.size() << "] threads.";
+
+    text_file_reader train_hftr(hftOption(train_hftr_file_name));
+    hftr_samples blocks[2];
+    unsigned int remain = members.size();
+
+    ensemble_pool pool(thread_workers);
+
+    for (auto &suite : hftOption(train_suite))
+    {
+        unsigned int epochs = suite.second;
+        double learn_coefficient = suite.first;
+
+        hft_log(INFO) << "Starting suite: epochs [" << epochs
+                      << "], learn coefficient [" << learn_coefficient
+                      << "].";
+
+        for (auto &m : members)
+        {
+            m.bai -> set_learn_coefficient(learn_coefficient);
+        }
+
+        for (unsigned int i = 0; i < epochs; i++)
+        {
+            hft_log(INFO) << "Starting epoch [" << i+1 << "] of [" << epochs
+                          << "], learn coefficient [" << learn_coefficient
+                          << "].";
+
+            train_hftr.rewind();
+
+            hft_log(INFO) << "Now training...";
+
+            unsigned int current = 0;
+
+            blocks[current].clear();
+            blocks[current].load(train_hftr, ENSEMBLE_BLOCK_SIZE);
+
+            while (blocks[current].size())
+            {
+                pool.dispatch(&blocks[current]);
+
+                blocks[1 - current].clear();
+                blocks[1 - current].load(train_hftr, ENSEMBLE_BLOCK_SIZE);
+
+                pool.wait();
+
+                current = 1 - current;
+            }
+
+            for (auto &m : members)
+            {
+                if (m.finished)
+                {
+                    continue;
+                }
+
+                m.bai -> save_network(m.nid, m.file_name);
+
+                hft_log(INFO) << "Training statistics [" << m.file_name << "]:\n"
+                              << m.train_statistics.generate_report(hftOption(json_report) ? train_stat::report_type::JSON : train_stat::report_type::HUMAN_READABLE);
+
+                if (m.validator)
+                {
+                    train_stat validate_statistics = m.validator -> validate(m.bai -> export_network(m.nid));
+
+                    hft_log(INFO) << "Validation statistics [" << m.file_name << "]:\n"
+                                  << validate_statistics.generate_report(hftOption(json_report) ? train_stat::report_type::JSON : train_stat::report_type::HUMAN_READABLE);
+
+                    double vpri = validate_statistics.get_pessimistic_ratio_indicator();
+                    double tpri = m.train_statistics.get_pessimistic_ratio_indicator();
+
+                    if (fabs(vpri - tpri) <= hftOption(train_break_condition))
+                    {
+                        hft_log(WARNING) << "Network [" << m.file_name
+                                         << "] finished training because of option --train-break-if : "
+                                         << fabs(vpri - tpri) << "≤" << hftOption(train_break_condition);
+
+                        m.finished = true;
+                        remain--;
+                    }
+                }
+
+                m.train_statistics.clear();
+            }
+
+            if (remain == 0)
+            {
+                return 0;
+            }
+        }
+    }
+
+    return 0;
+}
+
+//
+// Sweep mode: trials are combinations of hidden layers architecture
+// and train schedule. Train and validation sets are parsed once and
+// shared by all trials, trials are taken by worker threads one by
+// one. Trial stops early when --train-break-if condition is met.
+// Weights from epoch with the best validation pessimistic ratio
+// indicator are saved. Initial weights of every trial come from
+// its own generator seeded with --sweep-seed and trial number,
+// so trials are reproducible. Trial which throws is marked as
+// failed and ranked last, the rest of the sweep goes on.
+//
+
+typedef std::vector<std::pair<double, unsigned int>> train_schedule;
+
+struct sweep_trial
+{
+    unsigned int id;
+    std::string arch_str;
+    neural_network::layers_architecture arch;
+    std::string schedule_str;
+    train_schedule schedule;
+    std::string file_name;
+
+    unsigned int epochs;
+    unsigned int best_epoch;
+    bool early_stopped;
+    double best_vpri;
+    double best_vratio;
+    double best_tpri;
+
+    bool failed;
+    std::string error;
+};
+
+struct sweep_worker_data
+{
+    std::vector<sweep_trial> *trials;
+    std::shared_ptr<const hftr_samples> train_samples;
+    std::shared_ptr<const hftr_samples> validate_samples;
+
+    std::shared_ptr<std::thread> thread;
+};
+
+typedef std::vector<sweep_worker_data> sweep_workers;
+
+static std::mutex sweep_mtx;
+static size_t next_sweep_trial = 0;
+
+static void run_sweep_trial(sweep_trial &trial,
+                            std::shared_ptr<const hftr_samples> train_samples,
+                            std::shared_ptr<const hftr_samples> validate_samples)
+{
+    trial.epochs = 0;
+    trial.best_epoch = 0;
+    trial.early_stopped = false;
+    trial.best_vpri = -1.0;
+    trial.best_vratio = 0.0;
+    trial.best_tpri = 0.0;
+    trial.failed = false;
+
+    std::seed_seq seed { hftOption(sweep_seed), trial.id };
+    std::mt19937 rng(seed);
+
+    basic_artifical_inteligence bai;
+    bai.set_opt(basic_artifical_inteligence::AI_OPTION_NEVER_HFTR_EXPORT, true);
+    bai.set_opt(basic_artifical_inteligence::AI_OPTION_HFT_MULTICORE, false);
+    bai.set_opt(basic_artifical_inteligence::AI_OPTION_VERBOSE, false);
+    unsigned int nid = bai.add_neural_network(trial.arch, hftOption(activation_accuracy), &rng);
+
+    validation_engine validator(validate_samples, trial.arch, 1, 0, hftOption(activation_accuracy));
+    train_stat train_statistics;
+    std::string best_snapshot = bai.export_network(nid);
+
+    for (auto &suite : trial.schedule)
+    {
+        bai.set_learn_coefficient(suite.first);
+
+        for (unsigned int i = 0; i < suite.second && ! trial.early_stopped; i++)
+        {
+            train_statistics.clear();
+
+            for (size_t j = 0; j < train_samples -> size(); j++)
+            {
+                bai.import_input_bus(train_samples -> get_pins(j), train_samples -> get_inputs());
+                bai.fireup_networks();
+                train_statistics.store(bai.get_network_output(nid), train_samples -> get_expected(j));
+                bai.feedback(train_samples -> get_expected(j));
+            }
+
+            trial.epochs++;
+
+            std::string snapshot = bai.export_network(nid);
+            train_stat validate_statistics = validator.validate(snapshot);
+
+            double vpri = validate_statistics.get_pessimistic_ratio_indicator();
+            double tpri = train_statistics.get_pessimistic_ratio_indicator();
+
+            hft_log(INFO) << "Trial [" << trial.id << "] " << trial.arch_str
+                          << " epoch [" << trial.epochs
+                          << "], train PRI [" << tpri
+                          << "], validation PRI [" << vpri << "].";
+
+            if (vpri > trial.best_vpri)
+            {
+                trial.best_vpri = vpri;
+                trial.best_tpri = tpri;
+                trial.best_vratio = validate_statistics.get_ratio();
+                trial.best_epoch = trial.epochs;
+                best_snapshot = snapshot;
+            }
+
+            if (fabs(vpri - tpri) <= hftOption(train_break_condition))
+            {
+                trial.early_stopped = true;
+            }
+        }
+    }
+
+    bai.load_network_from_buffer(nid, best_snapshot);
+    bai.save_network(nid, trial.file_name);
+}
+
+static void thread_funct_sweep(sweep_worker_data *self)
+{
+    for (;;)
+    {
+        size_t n;
+
+        {
+            std::lock_guard<std::mutex> lck(sweep_mtx);
+
+            if (next_sweep_trial >= self -> trials -> size())
+            {
+                return;
+            }
+
+            n = next_sweep_trial++;
+        }
+
+        sweep_trial &trial = self -> trials -> at(n);
+
+        try
+        {
+            run_sweep_trial(trial, self -> train_samples, self -> validate_samples);
+        }
+        catch (const std::exception &e)
+        {
+            trial.failed = true;
+            trial.error = e.what();
+
+            hft_log(ERROR) << "Trial [" << trial.id << "] " << trial.arch_str
+                           << " schedule [" << trial.schedule_str
+                           << "] failed: " << e.what();
+        }
+    }
+}
+
+static int sweep_training(void)
+{
+    if (hftOption(sweep_arch).empty() || hftOption(sweep_schedule).empty())
+    {
+        hft_log(ERROR) << "Sweep mode requires at least one architecture and one schedule";
+
+        return 1;
+    }
+
+    if (hftOption(validate_hftr_file_name) == "none")
+    {
+        hft_log(ERROR) << "Sweep mode requires validation HFTR file to rank trials";
+
+        return 1;
+    }
+
+    //
+    // Build grid of trials.
+    //
+
+    std::vector<sweep_trial> trials;
+    boost::char_separator<char> sep(",");
+
+    for (auto &arch : hftOption(sweep_arch))
+    {
+        for (auto &schedule : hftOption(sweep_schedule))
+        {
+            sweep_trial trial;
+
+            trial.arch_str = arch;
+            trial.arch = neural_network::parse_layers_architecture_from_string(arch);
+            trial.schedule_str = schedule;
+
+            boost::tokenizer<boost::char_separator<char> > tokens(schedule, sep);
+
+            for (auto &item : tokens)
+            {
+                trial.schedule.push_back(parse_train_suite_item(item));
+            }
+
+            if (trial.schedule.empty())
+            {
+                throw std::runtime_error(std::string("Empty train schedule „") + schedule + std::string("”"));
+            }
+
+            trials.push_back(trial);
+        }
+    }
+
+    if (hftOption(sweep_random) > 0 && hftOption(sweep_random) < trials.size())
+    {
+        std::mt19937 generator(hftOption(sweep_seed));
+
+        std::shuffle(trials.begin(), trials.end(), generator);
+        trials.resize(hftOption(sweep_random));
+    }
+
+    //
+    // Create output directory up front, so trials
+    // don't fail one by one on saving networks.
+    //
+
+    boost::system::error_code ec;
+    fs::create_directories(hftOption(sweep_dir), ec);
+
+    if (! fs::is_directory(hftOption(sweep_dir)))
+    {
+        hft_log(ERROR) << "Unable to create sweep directory „"
+                       << hftOption(sweep_dir) << "”"
+                       << (ec ? std::string(": ") + ec.message() : std::string());
+
+        return 1;
+    }
+
+    for (size_t i = 0; i < trials.size(); i++)
+    {
+        trials[i].id = i;
+        trials[i].file_name = (fs::path(hftOption(sweep_dir)) / (std::string("trial_") + boost::lexical_cast<std::string>(i) + std::string(".json"))).string();
+    }
+
+    hft_log(INFO) << "Loading HFTR for training ["
+                  << hftOption(train_hftr_file_name)
+                  << "].";
+
+    std::shared_ptr<const hftr_samples> train_samples(new hftr_samples(hftOption(train_hftr_file_name)));
+
+    hft_log(INFO) << "Loading HFTR for validation ["
+                  << hftOption(validate_hftr_file_name)
+                  << "].";
+
+    std::shared_ptr<const hftr_samples> validate_samples(new hftr_samples(hftOption(validate_hftr_file_name)));
+
+    //
+    // Run trials.
+    //
+
+    unsigned int ncores = hftOption(ncores) > 0 ? hftOption(ncores) : 1;
+    sweep_workers thread_workers(std::min(static_cast<size_t>(ncores), trials.size()));
+
+    hft_log(INFO) << "Running [" << trials.size() << "] trials on ["
+                  << thread_workers.size() << "] threads.";
+
+    next_sweep_trial = 0;
+
+    for (auto &w : thread_workers)
+    {
+        w.trials = &trials;
+        w.train_samples = train_samples;
+        w.validate_samples = validate_samples;
+        w.thread.reset(new std::thread(thread_funct_sweep, &w));
+    }
+
+    for (auto &w : thread_workers)
+    {
+        w.thread -> join();
+    }
+
+    //
+    // Leaderboard.
+    //
+
+    std::stable_sort(trials.begin(), trials.end(), [](const sweep_trial &a, const sweep_trial &b)
+    {
+        if (a.failed != b.failed)
+        {
+            return b.failed;
+        }
+
+        return a.best_vpri > b.best_vpri;
+    });
+
+    std::ofstream leaderboard(hftOption(leaderboard_file_name));
+
+    if (! leaderboard)
+    {
+        hft_log(ERROR) << "Unable to open file for write: „"
+                       << hftOption(leaderboard_file_name) << "”";
+
+        return 1;
+    }
+
+    leaderboard << "[\n";
+
+    for (size_t i = 0; i < trials.size(); i++)
+    {
+        const sweep_trial &t = trials[i];
+        std::string error = t.error;
+
+        boost::replace_all(error, "\\", "\\\\");
+        boost::replace_all(error, "\"", "\\\"");
+
+        leaderboard << "\t{\"rank\":" << i + 1
+                    << ",\"trial\":" << t.id
+                    << ",\"arch\":\"" << t.arch_str << "\""
+                    << ",\"schedule\":\"" << t.schedule_str << "\""
+                    << ",\"network_file\":\"" << t.file_name << "\""
+                    << ",\"epochs\":" << t.epochs
+                    << ",\"early_stopped\":" << (t.early_stopped ? "true" : "false")
+                    << ",\"best_epoch\":" << t.best_epoch
+                    << ",\"validation_pri\":" << t.best_vpri
+                    << ",\"validation_ratio\":" << t.best_vratio
+                    << ",\"train_pri\":" << t.best_tpri
+                    << ",\"failed\":" << (t.failed ? "true" : "false");
+
+        if (t.failed)
+        {
+            leaderboard << ",\"error\":\"" << error << "\"";
+        }
+
+        leaderboard << (i + 1 < trials.size() ? "},\n" : "}\n");
+    }
+
+    leaderboard << "]\n";
+
+    hft_log(INFO) << "Leaderboard saved to [" << hftOption(leaderboard_file_name) << "].";
+
+    if (trials.size() && ! trials[0].failed)
+    {
+        hft_log(INFO) << "Best trial [" << trials[0].id << "] " << trials[0].arch_str
+                      << " schedule [" << trials[0].schedule_str
+                      << "], validation PRI [" << trials[0].best_vpri << "].";
+    }
+
+    return 0;
+}
+
 int hft_trainer_main(int argc, char *argv[])
 {
     //
@@ -99,6 +850,17 @@ int hft_trainer_main(int argc, char *argv[])
         ("collector-size,C", prog_opts::value<size_t>(&hftOption(collector_size) ) -> default_value(220), "Market collector size")
         ("train-suite,s",  prog_opts::value< std::vector<std::string> >(), "list of train settings in format <lc>:<en>, where <lc> is learn coefficient, <en> is epoch number")
         ("json-report,j", prog_opts::value<bool>(&hftOption(json_report)) -> default_value(false), "Wheather train statistics should be displayed in human readable format or JSON")
+        ("response-histogram,H", prog_opts::value<unsigned int>(&hftOption(histogram_bins)) -> default_value(0), "Amount of bins for histogram of network responses in statistics, 0 disables histogram")
+        ("threads,T", prog_opts::value<int>(&hftOption(ncores)) -> default_value(std::thread::hardware_concurrency()), "Define number of threads")
+        ("overlap-validation,O", prog_opts::value<bool>(&hftOption(overlap_validation)) -> default_value(false), "Validate network from previous epoch in background while training next one")
+        ("ensemble,E", prog_opts::value<std::vector<std::string>>(&hftOption(ensemble)) -> composing(), "Ensemble mode, network in format <network-file>:<arch>, e.g. „net1.json:[7 5]”. Option may be repeated, all networks are trained in one pass over data")
+        ("sweep-arch,A", prog_opts::value<std::vector<std::string>>(&hftOption(sweep_arch)) -> composing(), "Sweep mode, hidden layers architecture to be examined, e.g. „[7 5]”. Option may be repeated")
+        ("sweep-schedule,S", prog_opts::value<std::vector<std::string>>(&hftOption(sweep_schedule)) -> composing(), "Sweep mode, train schedule to be examined in format <lc>:<en>[,<lc>:<en>…]. Option may be repeated")
+        ("sweep-random,R", prog_opts::value<unsigned int>(&hftOption(sweep_random)) -> default_value(0), "Sweep mode, number of trials randomly chosen from grid of architectures and schedules, 0 means full grid")
+        ("sweep-seed", prog_opts::value<unsigned int>(&hftOption(sweep_seed)) -> default_value(0), "Sweep mode, seed for random trials selection and initial weights of trials")
+        ("sweep-dir,D", prog_opts::value<std::string>(&hftOption(sweep_dir)) -> default_value("."), "Sweep mode, directory for trained networks")
+        ("leaderboard,l", prog_opts::value<std::string>(&hftOption(leaderboard_file_name)) -> default_value("leaderboard.json"), "Sweep mode, output JSON file with trials ranked by validation pessimistic ratio indicator")
+        ("activation-accuracy,x", prog_opts::value<std::string>() -> default_value("exact"), "Accuracy of network activate functions: exact (reference), fine or coarse (tabulated, faster)")
     ;
 
     prog_opts::options_description cmdline_options;
@@ -129,6 +891,16 @@ int hft_trainer_main(int argc, char *argv[])
 
     el::Logger *logger = el::Loggers::getLogger("ai_trainer", true);
 
+    if (! hft::parse_activation_accuracy(vm["activation-accuracy"].as<std::string>(), hftOption(activation_accuracy)))
+    {
+        throw std::runtime_error("Unknown activation accuracy „" + vm["activation-accuracy"].as<std::string>() + "”");
+    }
+
+    if (hftOption(sweep_arch).size() || hftOption(sweep_schedule).size())
+    {
+        return sweep_training();
+    }
+
     //
     // Parse train suite informations.
     //
@@ -138,36 +910,11 @@ int hft_trainer_main(int argc, char *argv[])
         throw std::runtime_error("No train suite information specified");
     }
 
-    boost::char_separator<char> sep(":");
     const std::vector<std::string> &ustp = vm["train-suite"].as<std::vector<std::string>>();
 
     for (auto &item : ustp)
     {
-        std::pair<double, unsigned int> suite;
-        boost::tokenizer<boost::char_separator<char> > tokens(item, sep);
-
-        auto iterator = tokens.begin();
-
-        if (iterator == tokens.end())
-        {
-            std::string err_msg = std::string("No learn coefficient specified in „")
-                                  + item + std::string("”");
-
-            throw std::runtime_error(err_msg);
-        }
-
-        suite.first = boost::lexical_cast<double>(*iterator);
-        iterator++;
-
-        if (iterator == tokens.end())
-        {
-            std::string err_msg = std::string("No epochs number specified in „")
-                                  + item + std::string("”");
-
-            throw std::runtime_error(err_msg);
-        }
-
-        suite.second = boost::lexical_cast<unsigned int>(*iterator);
+        std::pair<double, unsigned int> suite = parse_train_suite_item(item);
 
         hft_log(INFO) << "Network(s) will be train [" << suite.second
                       << "] times with learn coefficient ["
@@ -176,6 +923,11 @@ int hft_trainer_main(int argc, char *argv[])
         hftOption(train_suite).push_back(suite);
     }
 
+    if (hftOption(ensemble).size())
+    {
+        return ensemble_training();
+    }
+
     //
     // Stuff configuration and setup.
     //
@@ -183,34 +935,48 @@ int hft_trainer_main(int argc, char *argv[])
     train_stat train_statistics;
     train_stat validate_statistics;
     std::shared_ptr<text_file_reader> train_hftr;
-    std::shared_ptr<text_file_reader> validate_hftr;
+    std::shared_ptr<validation_engine> validator;
     std::shared_ptr<basic_artifical_inteligence> bai;
 
+    if (hftOption(histogram_bins) > 0)
+    {
+        train_statistics.enable_histogram(hftOption(histogram_bins));
+    }
+
     hft_log(INFO) << "Loading HFTR for training ["
                   << hftOption(train_hftr_file_name)
                   << "].";
 
     train_hftr.reset(new text_file_reader(hftOption(train_hftr_file_name)));
 
+    hftOption(arch) = neural_network::parse_layers_architecture_from_string(vm["network-arch"].as<std::string>());
+
     if (hftOption(validate_hftr_file_name) != "none")
     {
         hft_log(INFO) << "Loading HFTR for validation ["
                       << hftOption(validate_hftr_file_name)
                       << "].";
 
-        validate_hftr.reset(new text_file_reader(hftOption(validate_hftr_file_name)));
+        validator.reset(new validation_engine(hftOption(validate_hftr_file_name),
+                                              hftOption(arch),
+                                              hftOption(ncores) > 0 ? hftOption(ncores) : 1,
+                                              hftOption(histogram_bins),
+                                              hftOption(activation_accuracy)));
+
+        hft_log(INFO) << "Validation set loaded, ["
+                      << validator -> get_samples_number()
+                      << "] samples.";
     }
 
     std::string line;
     double net_response, expected;
     hftr h;
-    hftOption(arch) = neural_network::parse_layers_architecture_from_string(vm["network-arch"].as<std::string>());
     bai.reset(new basic_artifical_inteligence());
     bai -> create_collector(hftOption(collector_size));
     bai -> set_opt(basic_artifical_inteligence::AI_OPTION_NEVER_HFTR_EXPORT, true);
     bai -> set_opt(basic_artifical_inteligence::AI_OPTION_HFT_MULTICORE, false);
     bai -> set_opt(basic_artifical_inteligence::AI_OPTION_VERBOSE, false);
-    unsigned int nid = bai -> add_neural_network(hftOption(arch));
+    unsigned int nid = bai -> add_neural_network(hftOption(arch), hftOption(activation_accuracy));
 
     if (! fs::exists(hftOption(neural_network_file_name)))
     {
@@ -226,6 +992,34 @@ int hft_trainer_main(int argc, char *argv[])
         bai -> load_network(nid, hftOption(neural_network_file_name ));
     }
 
+    //
+    // Collects result of validation started after epoch, displays
+    // it and checks break condition. Returns true if training
+    // should be interrupted.
+    //
+
+    double validated_tpri = 0.0;
+
+    auto finish_validation = [&](void) -> bool
+    {
+        validate_statistics = validator -> wait();
+
+        hft_log(INFO) << "Validation statistics:\n"
+                      << validate_statistics.generate_report(hftOption(json_report) ? train_stat::report_type::JSON : train_stat::report_type::HUMAN_READABLE);
+
+        double vpri = validate_statistics.get_pessimistic_ratio_indicator();
+
+        if (fabs(vpri - validated_tpri) <= hftOption(train_break_condition))
+        {
+            hft_log(WARNING) << "Breaking training because of option --train-break-if : "
+                             << fabs(vpri - validated_tpri) << "≤" << hftOption(train_break_condition);
+
+            return true;
+        }
+
+        return false;
+    };
+
     //
     // Proceed training.
     //
@@ -276,45 +1070,6 @@ int hft_trainer_main(int argc, char *argv[])
                 train_statistics.store(net_response, expected);
             }
 
-            //
-            // If validation available, proceed one.
-            //
-
-            if (hftOption(validate_hftr_file_name) != "none")
-            {
-                hft_log(INFO) << "Now verification...";
-
-                validate_hftr-> rewind();
-
-                while (validate_hftr -> read_line(line))
-                {
-                    h.clear();
-                    h.import_from_text_line(line);
-                    bai -> import_input_bus_from_hftr(h);
-                    bai -> fireup_networks();
-
-                    net_response = bai -> get_network_output(nid);
-
-                    switch (h.get_output())
-                    {
-                        case hftr::INCREASE:
-                            expected = 1.0;
-                            break;
-                        case hftr::DECREASE:
-                            expected = -1.0;
-                            break;
-                        default:
-                            throw std::runtime_error("Bad HFTR, unrecognized output");
-                    }
-
-                    validate_statistics.store(net_response, expected);
-                }
-            }
-            else
-            {
-                hft_log(INFO) << "(verification skipped)";
-            }
-
             //
             // After each epoch, we have to save neurons to the file
             // and display stats.
@@ -325,29 +1080,50 @@ int hft_trainer_main(int argc, char *argv[])
             hft_log(INFO) << "Training statistics:\n"
                           << train_statistics.generate_report(hftOption(json_report) ? train_stat::report_type::JSON : train_stat::report_type::HUMAN_READABLE);
 
+            //
+            // If validation available, proceed one on snapshot
+            // of weights. In overlap mode validation of previous
+            // epoch has been running during this epoch training,
+            // so collect it first. If it breaks training, restore
+            // network validated.
+            //
 
-            if (hftOption(validate_hftr_file_name) != "none")
+            if (validator)
             {
-                hft_log(INFO) << "Validation statistics:\n"
-                              << validate_statistics.generate_report(hftOption(json_report) ? train_stat::report_type::JSON : train_stat::report_type::HUMAN_READABLE);
+                if (validator -> is_running())
+                {
+                    if (finish_validation())
+                    {
+                        bai -> load_network_from_buffer(nid, validator -> get_snapshot());
+                        bai -> save_network(nid, hftOption(neural_network_file_name ));
+
+                        return 0;
+                    }
+                }
 
-                double vpri = validate_statistics.get_pessimistic_ratio_indicator();
-                double tpri = train_statistics.get_pessimistic_ratio_indicator();
+                hft_log(INFO) << "Now verification...";
 
-                if (fabs(vpri - tpri) <= hftOption(train_break_condition))
-                {
-                    hft_log(WARNING) << "Breaking training because of option --train-break-if : "
-                                     << fabs(vpri - tpri) << "≤" << hftOption(train_break_condition);
+                validated_tpri = train_statistics.get_pessimistic_ratio_indicator();
+                validator -> start(bai -> export_network(nid));
 
+                if (! hftOption(overlap_validation) && finish_validation())
+                {
                     return 0;
                 }
-
-                validate_statistics.clear();
+            }
+            else
+            {
+                hft_log(INFO) << "(verification skipped)";
             }
 
             train_statistics.clear();
         }
     }
 
+    if (validator && validator -> is_running())
+    {
+        finish_validation();
+    }
+
     return 0;
 }
@@ -58,18 +58,27 @@ auto_deallocator::resource::~resource(void)
 
 void auto_deallocator::resource::cleanup(void)
 {
-    std::set<void *>::iterator it;
+    void *obj;
 
     while (true)
     {
-        it = registered_.begin();
-
-        if (it == registered_.end())
         {
-            break;
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            if (registered_.empty())
+            {
+                break;
+            }
+
+            obj = *registered_.begin();
         }
 
-        delete reinterpret_cast<auto_deallocator *>(*it);
+        //
+        // Deleting unregisters object, so it can't
+        // be done with the lock held.
+        //
+
+        delete reinterpret_cast<auto_deallocator *>(obj);
     }
 }
 
@@ -80,6 +89,8 @@ void auto_deallocator::resource::register_object(void *obj)
               << obj << "]\n";
     #endif
 
+    std::lock_guard<std::mutex> lock(mutex_);
+
     registered_.insert(obj);
 }
 
@@ -90,5 +101,7 @@ void auto_deallocator::resource::unregister_object(void *obj)
               << obj << "]\n";
     #endif
 
+    std::lock_guard<std::mutex> lock(mutex_);
+
     registered_.erase(obj);
 }
@@ -100,7 +100,19 @@ void basic_artifical_inteligence::initialize_approximator_from_buffer(const std:
 // sieci neuronowej.
 //
 
-unsigned int basic_artifical_inteligence::add_neural_network(const neural_network::layers_architecture &la)
+unsigned int basic_artifical_inteligence::add_neural_network(const neural_network::layers_architecture &la,
+                                                             hft::activation_accuracy acc,
+                                                             std::mt19937 *rng)
+{
+    neural_networks_.push_back(create_neural_network(la, acc, rng));
+    quantized_networks_.push_back(nullptr);
+
+    return neural_networks_.size() - 1;
+}
+
+std::shared_ptr<neural_network> basic_artifical_inteligence::create_neural_network(const neural_network::layers_architecture &la,
+                                                                                  hft::activation_accuracy acc,
+                                                                                  std::mt19937 *rng)
 {
     std::shared_ptr<neural_network> net;
 
@@ -118,7 +130,7 @@ unsigned int basic_artifical_inteligence::add_neural_network(const neural_networ
 
     arch.push_back(1);
 
-    net.reset(new neural_network(11*20, arch));
+    net.reset(new neural_network(11*20, arch, 0.0, rng));
 
     //
     // Setup bipolar activate function
@@ -130,9 +142,56 @@ unsigned int basic_artifical_inteligence::add_neural_network(const neural_networ
         net -> set_activate_function(i, neuron::activate_function_class::SIGMOID_BIPOLAR);
     }
 
-    neural_networks_.push_back(net);
+    net -> set_activation_accuracy(acc);
 
-    return neural_networks_.size() - 1;
+    return net;
+}
+
+void basic_artifical_inteligence::replace_neural_network(unsigned int nid, std::shared_ptr<neural_network> net)
+{
+    neural_networks_.at(nid) = net;
+    network_input_bus_loaded_ = false;
+
+    //
+    // Quantized copy has been made of previous weights.
+    //
+
+    if (quantized_networks_.at(nid))
+    {
+        hft_log(WARNING) << "Network #" << nid << " replaced, quantized "
+                         << "copy detached, using floating point.";
+
+        quantized_networks_.at(nid).reset();
+    }
+}
+
+void basic_artifical_inteligence::attach_quantized_network(unsigned int nid, std::shared_ptr<quantized_network> qnet)
+{
+    if (qnet)
+    {
+        const neural_network &net = *neural_networks_.at(nid);
+
+        bool match = (qnet -> get_number_of_inputs() == net.get_number_of_inputs() &&
+                      qnet -> get_number_of_layers() == net.get_number_of_layers());
+
+        for (unsigned int l = 0; match && l < net.get_number_of_layers(); l++)
+        {
+            match = (qnet -> get_layer_size(l) == net.get_layer_size(l));
+        }
+
+        if (! match)
+        {
+            throw exception("Quantized network architecture mismatch");
+        }
+
+        if (qnet -> get_source_fingerprint() != net.weights_fingerprint())
+        {
+            throw exception("Quantized network was made of different weights than "
+                            "float network, re-run „hft nn-quantize”");
+        }
+    }
+
+    quantized_networks_.at(nid) = qnet;
 }
 
 //
@@ -162,8 +221,23 @@ void basic_artifical_inteligence::save_network(unsigned int nid, const std::stri
     neural_networks_.at(nid) -> save_network(file_name);
 }
 
+std::string basic_artifical_inteligence::export_network(unsigned int nid) const
+{
+    return neural_networks_.at(nid) -> export_to_json();
+}
+
+void basic_artifical_inteligence::load_network_from_buffer(unsigned int nid, const std::string &buffer)
+{
+    neural_networks_.at(nid) -> load_network_from_buffer(buffer.c_str());
+}
+
 double basic_artifical_inteligence::get_network_output(unsigned int nid)
 {
+    if (quantized_networks_.at(nid))
+    {
+        return quantized_networks_[nid] -> get_output(0);
+    }
+
     return neural_networks_.at(nid) -> get_output(0);
 }
 
@@ -207,6 +281,8 @@ void basic_artifical_inteligence::load_input_bus(void)
     int quantity, offset;
     double value;
 
+    input_pins_.resize(220);
+
     /*
     for (int i = 0; i < 20; i++)
     {
@@ -235,6 +311,7 @@ void basic_artifical_inteligence::load_input_bus(void)
         quantity = i2q(i);
 
         value  = collector().get_btfa(quantity, 0);
+        input_pins_[i] = value;
 
         for (auto &net : neural_networks_)
         {
@@ -267,15 +344,27 @@ void basic_artifical_inteligence::feed_data(unsigned int data)
 }
 
 void basic_artifical_inteligence::fireup_networks(void)
+{
+    for (unsigned int nid = 0; nid < neural_networks_.size(); nid++)
+    {
+        fireup_network(nid);
+    }
+}
+
+void basic_artifical_inteligence::fireup_network(unsigned int nid)
 {
     if (! network_input_bus_loaded_)
     {
         load_input_bus();
     }
 
-    for (auto &net : neural_networks_)
+    if (quantized_networks_.at(nid))
     {
-        net -> fire();
+        quantized_networks_[nid] -> fire(input_pins_.data());
+    }
+    else
+    {
+        neural_networks_.at(nid) -> fire();
     }
 }
 
@@ -297,6 +386,13 @@ void basic_artifical_inteligence::import_input_bus_from_hftr(const hftr &h)
         throw exception("Bus error. No neural network applied to the system");
     }
 
+    input_pins_.resize(h.get_size());
+
+    for (size_t i = 0; i < h.get_size(); i++)
+    {
+        input_pins_[i] = h.get_pin(i);
+    }
+
     for (auto &net : neural_networks_)
     {
         if (net -> get_number_of_inputs() != h.get_size())
@@ -327,6 +423,43 @@ void basic_artifical_inteligence::import_input_bus_from_hftr(const hftr &h)
     network_input_bus_loaded_ = true;
 }
 
+void basic_artifical_inteligence::import_input_bus(const double *pins, size_t size)
+{
+    if (neural_networks_.empty())
+    {
+        hft_log(ERROR) << "Unable to load input bus: no neural network "
+                          "applied to the system.";
+
+        throw exception("Bus error. No neural network applied to the system");
+    }
+
+    input_pins_.assign(pins, pins + size);
+
+    for (auto &net : neural_networks_)
+    {
+        if (net -> get_number_of_inputs() != size)
+        {
+            hft_log(ERROR) << "Incompatibile input bus. Size of input (="
+                           << size
+                           << ") not match with with size of neural "
+                           << "network input bus (="
+                           << net -> get_number_of_inputs()
+                           << ").";
+
+            throw exception("Bus incompatibility error");
+        }
+
+        net -> reset_input_bus();
+
+        for (size_t i = 0; i < size; i++)
+        {
+            net -> set_pin(i, pins[i]);
+        }
+    }
+
+    network_input_bus_loaded_ = true;
+}
+
 hftr basic_artifical_inteligence::export_input_bus_to_hftr(void) const
 {
     if (option_never_hftr_export_)
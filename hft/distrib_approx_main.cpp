@@ -19,6 +19,10 @@
 #include <fstream>
 #include <map>
 #include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <limits>
 
 #include <boost/program_options.hpp>
 #include <boost/lexical_cast.hpp>
@@ -40,6 +44,7 @@ static struct hft_distribution_approximation_config_type
     double       precision;
     std::string  output_fmt;
     std::string  output_file;
+    int          ncores;
 
 } hft_distribution_approximation_config;
 
@@ -59,26 +64,81 @@ struct preapprox_record
 #define hftOption(__X__) \
     hft_distribution_approximation_config.__X__
 
+//
+// Table of log(i!) extended on demand. Values are accumulated
+// in the same order as former per call sums, so binomial
+// coefficients stay bit-identical. Every thread has own table.
+//
+
+class log_factorial_cache
+{
+public:
+
+    log_factorial_cache(void) : lf_(1, 0.0) {}
+
+    //
+    // Returns table covering at least log(0!) … log(n!).
+    //
+
+    const double *table(unsigned int n)
+    {
+        while (lf_.size() <= n)
+        {
+            lf_.push_back(lf_.back() + log(lf_.size()));
+        }
+
+        return lf_.data();
+    }
+
+private:
+
+    std::vector<double> lf_;
+};
+
+typedef std::vector<double> binomial_row;
+
+//
+// Scratch state owned by a search worker.
+//
+
+struct worker_data
+{
+    log_factorial_cache lf;
+    binomial_row row;
+    std::vector<preapprox_record> result;
+
+    std::shared_ptr<std::thread> thread;
+};
+
+typedef std::vector<worker_data> workers;
+
 static std::map<unsigned int, double> distribution;
 static std::vector<preapprox_record>  preaprox;
 
-static double binomial(unsigned int N, unsigned int k)
+//
+// Trials scheduling shared by worker threads.
+//
+
+static std::mutex   trials_mtx;
+static unsigned int next_trial_n = 0;
+static unsigned int best_n = std::numeric_limits<unsigned int>::max();
+
+//
+// Evaluates binomial(N, k) for all k ∈ [from, N] at once.
+//
+
+static void evaluate_binomial_row(unsigned int N, unsigned int from,
+                                      binomial_row &row, log_factorial_cache &lf)
 {
-    double S1, S2, S3;
-    S1 = S2 = S3 = 0.0;
-    for (unsigned int i = 1; i <= k; i++) {
-        S1 += log(i);
-    }
+    row.resize(N + 1);
 
-    for (unsigned int i = 1; i <= (N-k); i++) {
-        S2 += log(i);
-    }
+    const double *lft = lf.table(N);
+    const double nlog2 = N*log(2);
 
-    for (unsigned int i = 1; i <= N; i++) {
-        S3 += log(i);
+    for (unsigned int k = from; k <= N; k++)
+    {
+        row[k] = exp(lft[N] - lft[N - k] - lft[k] - nlog2);
     }
-
-    return exp(S3 - S2 - S1 - N*log(2));
 }
 
 static void load_distribution_from_json(const std::string &file_name)
@@ -174,20 +234,18 @@ static void load_distribution_from_json(const std::string &file_name)
     distribution = std::map<unsigned int, double>(tmp_distribution.begin(), it2);
 }
 
-static bool approx(unsigned int n, unsigned int start_index,
+static bool approx(const binomial_row &row, unsigned int n, unsigned int start_index,
                        unsigned int &end_index, double goal)
 {
     double s = 0.0;
 
     for (unsigned int i = start_index; i <= n; i++)
     {
-        s += binomial(n, i);
+        s += row[i];
 
         if (fabs(s - goal) < hftOption(precision))
         {
             end_index = i;
-            std::cout << "Success: indexes from [" << start_index << ".." << end_index << "], result is ";
-            printf("%0.6f goal was %0.6f\n", s, goal);
 
             return true;
         }
@@ -210,7 +268,77 @@ static unsigned int logarithmic_incrementation(unsigned int n)
     return 2;
 }
 
-static std::string compute_average_amount(unsigned int n,
+//
+// Called concurrently by search workers, thus distribution
+// is accessed read only. Its keys are consecutive from 1.
+//
+
+static bool trial(unsigned int n, const std::map<unsigned int, double> &dist,
+                      std::vector<preapprox_record> &result,
+                      binomial_row &row, log_factorial_cache &lf)
+{
+    unsigned int start_index = n / 2;
+    unsigned int end_index;
+
+    result.clear();
+    evaluate_binomial_row(n, start_index, row, lf);
+
+    for (auto &d : dist)
+    {
+        if (approx(row, n, start_index, end_index, d.second) == false)
+        {
+            return false;
+        }
+
+        result.push_back(preapprox_record(d.first, start_index, end_index));
+
+        start_index = end_index + 1;
+    }
+
+    return true;
+}
+
+//
+// Workers take consecutive N values and stop once every N
+// smaller than the best successful one has been probed, so
+// result is the same as for sequential search.
+//
+
+static void thread_funct_search(worker_data *self)
+{
+    unsigned int n;
+
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lck(trials_mtx);
+
+            if (next_trial_n > best_n)
+            {
+                break;
+            }
+
+            n = next_trial_n;
+            next_trial_n += hftOption(increment) == 0 ? logarithmic_incrementation(next_trial_n) : hftOption(increment);
+        }
+
+        hft_log(INFO) << "-------- New trial for N = "
+                      << n << " --------------";
+
+        if (trial(n, distribution, self -> result, self -> row, self -> lf))
+        {
+            std::lock_guard<std::mutex> lck(trials_mtx);
+
+            if (n < best_n)
+            {
+                best_n = n;
+                preaprox = self -> result;
+            }
+        }
+    }
+}
+
+static std::string compute_average_amount(const binomial_row &row,
                                               unsigned int minimum,
                                                   unsigned int maximum)
 {
@@ -226,7 +354,7 @@ static std::string compute_average_amount(unsigned int n,
 
     for (unsigned int i = minimum; i <= maximum; i++)
     {
-        w = binomial(n, i);
+        w = row[i];
         sw += w;
         numerator += i*w;
     }
@@ -238,6 +366,11 @@ static std::string compute_average_amount(unsigned int n,
 
 static void print_approximation(std::ostream &file, unsigned int n)
 {
+    log_factorial_cache lf;
+    binomial_row row;
+
+    evaluate_binomial_row(n, 0, row, lf);
+
     if (hftOption(output_fmt) == "simple")
     {
         file << "[n] => " << n << "\n";
@@ -245,7 +378,7 @@ static void print_approximation(std::ostream &file, unsigned int n)
         for (auto it = preaprox.begin(); it != preaprox.end(); it++)
         {
             file << "[" << (it -> x) << "] => "
-                 << compute_average_amount(n, it -> start_index, it -> end_index)
+                 << compute_average_amount(row, it -> start_index, it -> end_index)
                  << "\n";
         }
     }
@@ -277,7 +410,7 @@ static void print_approximation(std::ostream &file, unsigned int n)
             }
 
             file << "\t\t\"" << (it -> x) << "\" : "
-                 << compute_average_amount(n, it -> start_index, it -> end_index);
+                 << compute_average_amount(row, it -> start_index, it -> end_index);
         }
 
         file << "\n\t}\n}\n";
@@ -333,6 +466,7 @@ int hft_distribution_approximation_generator_main(int argc, char *argv[])
                                                                               "Available formats: „simple” or „json”. Default is „simple”")
         ("approx-file-name,a", prog_opts::value<std::string>(&hftOption(output_file)) -> default_value(""), "File name for save generated distribution approximation."
                                                                               " If unspecified, distribution approximation is printed to STDOUT.")
+        ("threads,u", prog_opts::value<int>(&hftOption(ncores)) -> default_value(std::thread::hardware_concurrency()), "Define number of threads")
     ;
 
     prog_opts::options_description cmdline_options;
@@ -386,45 +520,34 @@ int hft_distribution_approximation_generator_main(int argc, char *argv[])
     // Generating approximation.
     //
 
-    unsigned int n = ((hftOption(startn) % 2) == 0 ? hftOption(startn) : hftOption(startn) + 1);
-    unsigned int start_index = n / 2;
-    unsigned int end_index;
-    int maximum = distribution.size();
-    bool completed = false;
-
-    while (true)
+    if (distribution.empty())
     {
-        hft_log(INFO) << "-------- New trial for N = "
-                      << n << " --------------";
+        hft_log(ERROR) << "Empty distribution";
 
-        for (int i = 1; i <= maximum; i++)
-        {
-            std::cout << "[" << i << "]: ";
-            if (approx(n, start_index, end_index, distribution[i]) == false)
-            {
-                std::cout << "\n";
-                break;
-            }
+        return 1;
+    }
 
-            preaprox.push_back(preapprox_record(i, start_index, end_index));
+    next_trial_n = ((hftOption(startn) % 2) == 0 ? hftOption(startn) : hftOption(startn) + 1);
 
-            start_index = end_index + 1;
+    workers thread_workers(hftOption(ncores) > 0 ? hftOption(ncores) : 1);
 
-            if (i == maximum)
-            {
-                completed = true;
-                break;
-            }
-        }
+    for (auto &x : thread_workers)
+    {
+        x.thread.reset(new std::thread(thread_funct_search, &x));
+    }
 
-        if (completed)
-        {
-            break;
-        }
+    for (auto &x : thread_workers)
+    {
+        x.thread -> join();
+    }
+
+    unsigned int n = best_n;
 
-        n += hftOption(increment) == 0 ? logarithmic_incrementation(n) : hftOption(increment);
-        start_index = n / 2;
-        preaprox.clear();
+    for (auto &record : preaprox)
+    {
+        hft_log(INFO) << "[" << record.x << "]: indexes from ["
+                      << record.start_index << ".." << record.end_index
+                      << "], goal was " << distribution.at(record.x);
     }
 
     //
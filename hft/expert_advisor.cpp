@@ -16,6 +16,8 @@
 
 #include <vector>
 #include <fstream>
+#include <chrono>
+#include <algorithm>
 
 #include <expert_advisor.hpp>
 #include <overnight_swaps.hpp>
@@ -26,22 +28,110 @@
 
 expert_advisor::expert_advisor(const std::string &instrument)
     : instrument_(instrument),
+      instrument_id_(hft::instrument2type(instrument)),
       dpips_limit_loss_(0),
       dpips_limit_profit_(0),
       mutable_networks_(false),
       vote_ratio_(0.0),
+      lazy_voting_(false),
+      votes_required_(0),
+      lazy_decisions_(0),
+      lazy_short_circuits_(0),
+      lazy_evaluations_(0),
       decision_compensate_inverter_enabled_(false),
       ai_decision_(NO_DECISION),
+      activation_accuracy_(hft::ACTIVATION_EXACT),
+      networks_reloaded_(false),
       trade_on_positive_swaps_only_(false)
 {
     el::Loggers::getLogger("expert_advisor", true);
 
     factory_advisor();
+
+    if (trade_on_positive_swaps_only_)
+    {
+        hft::init_overnight_swaps();
+    }
 }
 
 expert_advisor::~expert_advisor(void)
 {
     hft_log(WARNING) << "Destroying expert_advisor";
+
+    if (lazy_voting_ && lazy_decisions_ > 0)
+    {
+        hft_log(INFO) << "Lazy voting summary: short-circuited ["
+                      << lazy_short_circuits_ << "/" << lazy_decisions_
+                      << "] decisions, evaluated [" << lazy_evaluations_ << "/"
+                      << lazy_decisions_ * get_neural_networks_number()
+                      << "] networks.";
+    }
+
+    for (auto id : subscriptions_)
+    {
+        file_watch_service::instance().unsubscribe(id);
+    }
+}
+
+void expert_advisor::watch_networks(const std::string &manifest_file_name)
+{
+    reloaded_networks_.resize(network_files_.size());
+
+    for (unsigned int nid = 0; nid < network_files_.size(); nid++)
+    {
+        subscriptions_.push_back(file_watch_service::instance().subscribe(network_files_[nid], [this, nid](const std::string &file_name)
+        {
+            hft_log(INFO) << "Neural network file ["
+                          << file_name
+                          << "] has changed, reloading.";
+
+            std::shared_ptr<neural_network> net = basic_artifical_inteligence::create_neural_network(arch_, activation_accuracy_);
+
+            try
+            {
+                net -> load_network(file_name);
+            }
+            catch (const std::exception &e)
+            {
+                hft_log(ERROR) << "Failed to reload neural network ["
+                               << file_name << "]: " << e.what()
+                               << ", keeping previous one.";
+
+                return;
+            }
+
+            std::atomic_store(&reloaded_networks_[nid], net);
+            networks_reloaded_ = true;
+        }));
+    }
+
+    subscriptions_.push_back(file_watch_service::instance().subscribe(manifest_file_name, [](const std::string &file_name)
+    {
+        hft_log(WARNING) << "Manifest [" << file_name
+                         << "] has changed, restart required to apply.";
+    }));
+}
+
+void expert_advisor::apply_reloaded_networks(void)
+{
+    if (! networks_reloaded_.exchange(false))
+    {
+        return;
+    }
+
+    for (unsigned int nid = 0; nid < reloaded_networks_.size(); nid++)
+    {
+        std::shared_ptr<neural_network> net = std::atomic_exchange(&reloaded_networks_[nid], std::shared_ptr<neural_network>());
+
+        if (net)
+        {
+            replace_neural_network(nid, net);
+
+            hft_log(INFO) << "Neural network file ["
+                          << network_files_[nid]
+                          << "] reloaded.";
+        }
+    }
 }
 
 bool expert_advisor::has_sufficient_data(void) const
@@ -93,14 +183,14 @@ bool expert_advisor::should_close_position(int current_price)
         switch (si.position)
         {
             case position_control::position_type::LONG:
-                if (! hft::is_positive_swap_long(instrument_))
+                if (! hft::is_positive_swap_long(instrument_id_))
                 {
                     return true;
                 }
 
                 break;
             case position_control::position_type::SHORT:
-                if (! hft::is_positive_swap_short(instrument_))
+                if (! hft::is_positive_swap_short(instrument_id_))
                 {
                     return true;
                 }
@@ -145,27 +235,14 @@ decision_type expert_advisor::provide_advice(void)
     }
     else if (! is_valid_bus())
     {
-        const unsigned int networks_number = get_neural_networks_number();
-
         if (mutable_networks_)
         {
             //
-            // Check if networks has changed.
+            // Swap in networks already reloaded in background,
+            // if any. No filesystem access here.
             //
 
-            for (unsigned int nid = 0; nid < networks_number; nid++)
-            {
-                if (net_info_.has_changed(nid))
-                {
-                    hft_log(INFO) << "Neural network file ["
-                                  << net_info_.get_name(nid)
-                                  << "] has changed, reloading.";
-
-                    load_network(nid, net_info_.get_name(nid));
-
-                    net_info_.notify_change(nid);
-                }
-            }
+            apply_reloaded_networks();
         }
 
         //
@@ -173,41 +250,7 @@ decision_type expert_advisor::provide_advice(void)
         // based on Artifical Inteligence.
         //
 
-        fireup_networks();
-
-        unsigned int voting[2] = {0, 0};
-
-        for (unsigned int nid = 0; nid < networks_number; nid++)
-        {
-            hft_log(INFO) << "Network #" << nid << " respond ["
-                          << get_network_output(nid) << "]";
-
-            switch ((*decision_)(get_network_output(nid)))
-            {
-                case DECISION_SHORT:
-                    voting[0]++;
-                    break;
-                case DECISION_LONG:
-                    voting[1]++;
-                    break;
-            }
-        }
-
-        hft_log(INFO) << "Voting result shorts [" << voting[0] << "/" << networks_number << "], "
-                      << "longs [" << voting[1] << "/" << networks_number << "].";
-
-        if (static_cast<double>(voting[0]) / static_cast<double>(networks_number) >= vote_ratio_)
-        {
-            ai_decision_ = DECISION_SHORT;
-        }
-        else if (static_cast<double>(voting[1]) / static_cast<double>(networks_number) >= vote_ratio_)
-        {
-            ai_decision_ = DECISION_LONG;
-        }
-        else
-        {
-            ai_decision_ = NO_DECISION;
-        }
+        ai_decision_ = lazy_voting_ ? lazy_vote() : full_vote();
     }
 
     decision_type final_decision = ai_decision_;
@@ -233,8 +276,8 @@ decision_type expert_advisor::provide_advice(void)
 
     if (trade_on_positive_swaps_only_)
     {
-        if ( (final_decision == DECISION_LONG && !hft::is_positive_swap_long(instrument_)) ||
-             (final_decision == DECISION_SHORT && !hft::is_positive_swap_short(instrument_)))
+        if ( (final_decision == DECISION_LONG && !hft::is_positive_swap_long(instrument_id_)) ||
+             (final_decision == DECISION_SHORT && !hft::is_positive_swap_short(instrument_id_)))
         {
             final_decision = NO_DECISION;
         }
@@ -259,6 +302,155 @@ decision_type expert_advisor::provide_advice(void)
     return final_decision;
 }
 
+decision_type expert_advisor::full_vote(void)
+{
+    const unsigned int networks_number = get_neural_networks_number();
+
+    fireup_networks();
+
+    unsigned int voting[2] = {0, 0};
+
+    for (unsigned int nid = 0; nid < networks_number; nid++)
+    {
+        hft_log(INFO) << "Network #" << nid << " respond ["
+                      << get_network_output(nid) << "]";
+
+        switch ((*decision_)(get_network_output(nid)))
+        {
+            case DECISION_SHORT:
+                voting[0]++;
+                break;
+            case DECISION_LONG:
+                voting[1]++;
+                break;
+        }
+    }
+
+    hft_log(INFO) << "Voting result shorts [" << voting[0] << "/" << networks_number << "], "
+                  << "longs [" << voting[1] << "/" << networks_number << "].";
+
+    if (static_cast<double>(voting[0]) / static_cast<double>(networks_number) >= vote_ratio_)
+    {
+        return DECISION_SHORT;
+    }
+    else if (static_cast<double>(voting[1]) / static_cast<double>(networks_number) >= vote_ratio_)
+    {
+        return DECISION_LONG;
+    }
+
+    return NO_DECISION;
+}
+
+decision_type expert_advisor::lazy_vote(void)
+{
+    const unsigned int networks_number = get_neural_networks_number();
+
+    //
+    // Networks most likely to abstain end voting early
+    // (in quiet market most decisions are NO_DECISION),
+    // thus order is by expected cost of one abstention.
+    // Until statistics are gathered manifest order is kept.
+    //
+
+    auto cost_per_abstention = [this](unsigned int nid)
+    {
+        const network_voting_stats &st = voting_stats_[nid];
+
+        return st.cost * (st.evaluations + 2) / (st.abstentions + 1);
+    };
+
+    std::stable_sort(voting_order_.begin(), voting_order_.end(), [&](unsigned int a, unsigned int b)
+    {
+        return cost_per_abstention(a) < cost_per_abstention(b);
+    });
+
+    unsigned int voting[2] = {0, 0};
+    unsigned int evaluated = 0;
+    decision_type result = NO_DECISION;
+    bool determined = false;
+
+    while (! determined)
+    {
+        unsigned int nid = voting_order_[evaluated++];
+        network_voting_stats &st = voting_stats_[nid];
+
+        auto start = std::chrono::steady_clock::now();
+
+        fireup_network(nid);
+        double output = get_network_output(nid);
+
+        double cost = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        st.cost = (st.evaluations == 0) ? cost : st.cost + (cost - st.cost) / 16.0;
+        st.evaluations++;
+
+        hft_log(INFO) << "Network #" << nid << " respond [" << output << "]";
+
+        switch ((*decision_)(output))
+        {
+            case DECISION_SHORT:
+                voting[0]++;
+                break;
+            case DECISION_LONG:
+                voting[1]++;
+                break;
+            default:
+                st.abstentions++;
+        }
+
+        //
+        // Outcome is determined if shorts already won (they are
+        // checked first), or shorts cannot win any more and
+        // longs either already won or cannot win too. When all
+        // networks voted, this is exactly the full voting.
+        //
+
+        unsigned int remain = networks_number - evaluated;
+
+        if (voting[0] >= votes_required_)
+        {
+            result = DECISION_SHORT;
+            determined = true;
+        }
+        else if (voting[0] + remain < votes_required_)
+        {
+            if (voting[1] >= votes_required_)
+            {
+                result = DECISION_LONG;
+                determined = true;
+            }
+            else if (voting[1] + remain < votes_required_)
+            {
+                result = NO_DECISION;
+                determined = true;
+            }
+        }
+    }
+
+    lazy_decisions_++;
+    lazy_evaluations_ += evaluated;
+
+    if (evaluated < networks_number)
+    {
+        lazy_short_circuits_++;
+    }
+
+    hft_log(INFO) << "Voting result shorts [" << voting[0] << "/" << networks_number << "], "
+                  << "longs [" << voting[1] << "/" << networks_number << "], "
+                  << "evaluated [" << evaluated << "/" << networks_number << "].";
+
+    if (lazy_decisions_ % 1000 == 0)
+    {
+        hft_log(INFO) << "Lazy voting short-circuited ["
+                      << 100.0 * lazy_short_circuits_ / lazy_decisions_
+                      << "%] of [" << lazy_decisions_ << "] decisions, "
+                      << "skipped [" << 100.0 - 100.0 * lazy_evaluations_ / (lazy_decisions_ * networks_number)
+                      << "%] of network evaluations.";
+    }
+
+    return result;
+}
+
 void expert_advisor::factory_advisor(void)
 {
     //
@@ -329,7 +521,13 @@ void expert_advisor::factory_advisor(void)
                      "net2.json",
                      "net3.json"
                    ],
+      "quantized_networks" : [ "net1.nnq",
+                               "net2.nnq",
+                               "net3.nnq"
+                             ],
       "mutable_networks" : true,
+      "lazy_voting" : true,
+      "activation_accuracy" : "fine",
       "collector_size" : 220,
       "vote_ratio" : 0.7,
       "dpips_limit_profit" : 500,
@@ -508,8 +706,7 @@ void expert_advisor::factory_advisor(void)
             throw exception(err_msg);
         }
 
-        neural_network::layers_architecture arch;
-        arch = neural_network::parse_layers_architecture_from_string(std::string(architecture_json -> valuestring));
+        arch_ = neural_network::parse_layers_architecture_from_string(std::string(architecture_json -> valuestring));
 
         //
         // „vote_ratio” attribute.
@@ -557,6 +754,28 @@ void expert_advisor::factory_advisor(void)
             throw exception(err_msg);
         }
 
+        //
+        // „activation_accuracy” attribute (optional) - „exact”
+        // (default), „fine” or „coarse”, see „fast_activation.hpp”.
+        //
+
+        cJSON *activation_accuracy_json = cJSON_GetObjectItem(json, "activation_accuracy");
+
+        if (activation_accuracy_json != nullptr)
+        {
+            if (activation_accuracy_json -> type != cJSON_String ||
+                ! hft::parse_activation_accuracy(activation_accuracy_json -> valuestring, activation_accuracy_))
+            {
+                std::string err_msg = std::string("Illegal value of „activation_accuracy” attribute in ")
+                                      + file_name;
+
+                throw exception(err_msg);
+            }
+
+            hft_log(INFO) << "Networks use [" << hft::activation_accuracy_to_string(activation_accuracy_)
+                          << "] activate functions.";
+        }
+
         std::string network_file_name;
         unsigned int nid;
 
@@ -566,9 +785,42 @@ void expert_advisor::factory_advisor(void)
 
             network_file_name = path + std::string("/") + std::string(subitem -> valuestring);
 
-            nid = add_neural_network(arch);
+            nid = add_neural_network(arch_, activation_accuracy_);
             load_network(nid, network_file_name);
-            net_info_.register_file(nid, network_file_name);
+            network_files_.push_back(network_file_name);
+        }
+
+        //
+        // „quantized_networks” attribute (optional) - integer copies
+        // of „networks” made by „hft nn-quantize”, in the same order.
+        // Used for inference until float network is reloaded.
+        //
+
+        cJSON *quantized_networks_json = cJSON_GetObjectItem(json, "quantized_networks");
+
+        if (quantized_networks_json != nullptr)
+        {
+            if (cJSON_GetArraySize(quantized_networks_json) != cJSON_GetArraySize(networks_json))
+            {
+                std::string err_msg = std::string("Number of „quantized_networks” differs from number of „networks” in ")
+                                      + file_name;
+
+                throw exception(err_msg);
+            }
+
+            for (int i = 0; i < cJSON_GetArraySize(quantized_networks_json); i++)
+            {
+                cJSON *subitem = cJSON_GetArrayItem(quantized_networks_json, i);
+
+                network_file_name = path + std::string("/") + std::string(subitem -> valuestring);
+
+                std::shared_ptr<quantized_network> qnet = std::make_shared<quantized_network>();
+                qnet -> load(network_file_name);
+                attach_quantized_network(i, qnet);
+
+                hft_log(INFO) << "Network #" << i << " uses quantized inference ["
+                              << network_file_name << "].";
+            }
         }
 
         //
@@ -603,6 +855,65 @@ void expert_advisor::factory_advisor(void)
             throw exception(err_msg);
         }
 
+        //
+        // „lazy_voting” attribute (optional) - networks are
+        // evaluated only until outcome of voting is known.
+        //
+
+        cJSON *lazy_voting_json = cJSON_GetObjectItem(json, "lazy_voting");
+
+        if (lazy_voting_json == nullptr || lazy_voting_json -> type == cJSON_False)
+        {
+            lazy_voting_ = false;
+        }
+        else if (lazy_voting_json -> type == cJSON_True)
+        {
+            lazy_voting_ = true;
+        }
+        else if (lazy_voting_json -> type == cJSON_Number)
+        {
+            lazy_voting_ = (lazy_voting_json -> valueint == 0) ? false : true;
+        }
+        else
+        {
+            std::string err_msg = std::string("Illegal type of „lazy_voting” attribute")
+                                  + file_name;
+
+            throw exception(err_msg);
+        }
+
+        //
+        // Least number of votes passing „vote_ratio_”, found
+        // with the same comparison as full voting uses.
+        //
+
+        const unsigned int networks_number = get_neural_networks_number();
+
+        votes_required_ = networks_number;
+
+        for (unsigned int v = 0; v <= networks_number; v++)
+        {
+            if (static_cast<double>(v) / static_cast<double>(networks_number) >= vote_ratio_)
+            {
+                votes_required_ = v;
+                break;
+            }
+        }
+
+        voting_stats_.assign(networks_number, network_voting_stats());
+        voting_order_.resize(networks_number);
+
+        for (unsigned int nid = 0; nid < networks_number; nid++)
+        {
+            voting_order_[nid] = nid;
+        }
+
+        if (lazy_voting_)
+        {
+            hft_log(INFO) << "Lazy voting enabled, [" << votes_required_ << "/"
+                          << networks_number << "] votes required.";
+        }
+
         //
         // Position controller informations.
         //
@@ -743,6 +1054,16 @@ void expert_advisor::factory_advisor(void)
     cJSON_Delete(json);
     set_learn_coefficient(0.0);
 
+    //
+    // Network files are watched only if advisor
+    // has been successfully created.
+    //
+
+    if (mutable_networks_)
+    {
+        watch_networks(file_name);
+    }
+
     hft_log(INFO) << "Expert Advisor [" << path
                   << "] initialization completed.";
 }
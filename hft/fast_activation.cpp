@@ -0,0 +1,102 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <cmath>
+
+#include <fast_activation.hpp>
+
+namespace hft {
+
+bool parse_activation_accuracy(const std::string &s, activation_accuracy &acc)
+{
+    if (s == "exact")
+    {
+        acc = ACTIVATION_EXACT;
+    }
+    else if (s == "fine")
+    {
+        acc = ACTIVATION_FINE;
+    }
+    else if (s == "coarse")
+    {
+        acc = ACTIVATION_COARSE;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+std::string activation_accuracy_to_string(activation_accuracy acc)
+{
+    switch (acc)
+    {
+        case ACTIVATION_FINE:
+            return "fine";
+        case ACTIVATION_COARSE:
+            return "coarse";
+        default:
+            return "exact";
+    }
+}
+
+sigmoid_table::sigmoid_table(double range, unsigned int resolution)
+    : range_(range), resolution_(resolution)
+{
+    size_t n = static_cast<size_t>(2.0 * range * resolution) + 1;
+
+    nodes_.resize(n);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        double x = static_cast<double>(i) / resolution - range;
+
+        nodes_[i].value = 1.0 / (1.0 + exp(-1.0*x));
+    }
+
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        nodes_[i].slope = nodes_[i + 1].value - nodes_[i].value;
+    }
+
+    nodes_.back().slope = 0.0;
+    last_ = static_cast<double>(n - 1);
+}
+
+const sigmoid_table *sigmoid_table::get(activation_accuracy acc)
+{
+    //
+    // Beyond ±16 sigmoid differs from its
+    // limit by less than 1.2·10⁻⁷.
+    //
+
+    static const sigmoid_table fine(16.0, 256);
+    static const sigmoid_table coarse(16.0, 32);
+
+    switch (acc)
+    {
+        case ACTIVATION_FINE:
+            return &fine;
+        case ACTIVATION_COARSE:
+            return &coarse;
+        default:
+            return nullptr;
+    }
+}
+
+} /* namespace hft */
@@ -0,0 +1,257 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <poll.h>
+
+#include <set>
+#include <sstream>
+
+#include <easylogging++.h>
+#include <boost/filesystem.hpp>
+
+#include <file_watch_service.hpp>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "file_watch")
+
+#define FILE_WATCH_EVENT_SIZE    (sizeof(struct inotify_event))
+#define FILE_WATCH_EVENT_BUF_LEN (1024 * (FILE_WATCH_EVENT_SIZE + 16))
+
+//
+// Poll timeout, limits time of waiting
+// for thread termination.
+//
+
+#define FILE_WATCH_POLL_TIMEOUT_MS 250
+
+file_watch_service &file_watch_service::instance(void)
+{
+    static file_watch_service service;
+
+    return service;
+}
+
+file_watch_service::file_watch_service(void)
+    : next_id_(0), stop_(false)
+{
+    el::Loggers::getLogger("file_watch", true);
+
+    //
+    // Creating the INOTIFY instance.
+    //
+
+    fd_ = ::inotify_init();
+
+    if (fd_ == -1)
+    {
+        std::ostringstream err_msg;
+
+        err_msg << "Failed to initialize file watch service: "
+                << "inotify_init failed with system error [";
+
+        switch (errno)
+        {
+            case EMFILE:
+                err_msg << "EMFILE] - The user limit on the total number of inotify instances has been reached.";
+                break;
+            case ENFILE:
+                err_msg << "ENFILE] - The system limit on the total number of file descriptors has been reached.";
+                break;
+            case ENOMEM:
+                err_msg << "ENOMEM] - Insufficient kernel memory is available.";
+                break;
+            default:
+                /* Should never happen. */
+                err_msg << "?] - Unknown";
+        }
+
+        throw exception(err_msg.str());
+    }
+}
+
+file_watch_service::~file_watch_service(void)
+{
+    stop_ = true;
+
+    if (thread_)
+    {
+        thread_ -> join();
+    }
+
+    for (auto &w : watches_)
+    {
+        ::inotify_rm_watch(fd_, w.first);
+    }
+
+    ::close(fd_);
+}
+
+int file_watch_service::add_watch(const std::string &dir)
+{
+    int wd = ::inotify_add_watch(fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+    if (wd == -1)
+    {
+        std::ostringstream err_msg;
+
+        err_msg << "Failed to watch directory ["
+                << dir << "]: inotify_add_watch failed with system error [";
+
+        switch (errno)
+        {
+            case EACCES:
+                err_msg << "EACCES] - Read access to the given file is not permitted.";
+                break;
+            case EBADF:
+                err_msg << "EBADF] - The given file descriptor is not valid.";
+                break;
+            case EFAULT:
+                err_msg << "EFAULT] - Pathname points outside of the process's accessible address space.";
+                break;
+            case EINVAL:
+                err_msg << "EINVAL] - The given event mask contains no valid events; or fd is not an inotify file descriptor.";
+                break;
+            case ENOENT:
+                err_msg << "ENOENT] - A directory component in pathname does not exist or is a dangling symbolic link.";
+                break;
+            case ENOMEM:
+                err_msg << "ENOMEM] - Insufficient kernel memory was available.";
+                break;
+            case ENOSPC:
+                err_msg << "ENOSPC] - The user limit on the total number of inotify watches was "
+                        << "reached or the kernel failed to allocate a needed resource.";
+                break;
+            default:
+                /* Should never happen. */
+                err_msg << "?] - Unknown";
+        }
+
+        throw exception(err_msg.str());
+    }
+
+    //
+    // The same directory gives the same
+    // watch descriptor.
+    //
+
+    if (watches_.find(wd) == watches_.end())
+    {
+        hft_log(INFO) << "Watching directory [" << dir << "]";
+
+        watches_[wd] = dir;
+    }
+
+    return wd;
+}
+
+file_watch_service::subscription_id file_watch_service::subscribe(const std::string &file_name, handler h)
+{
+    boost::filesystem::path p(file_name);
+    std::string dir = p.has_parent_path() ? p.parent_path().string() : std::string(".");
+
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    subscription s;
+    s.wd = add_watch(dir);
+    s.name = p.filename().string();
+    s.path = file_name;
+    s.h = h;
+
+    subscription_id id = next_id_++;
+    subscriptions_[id] = s;
+
+    if (! thread_)
+    {
+        thread_.reset(new std::thread(&file_watch_service::thread_funct, this));
+    }
+
+    return id;
+}
+
+void file_watch_service::unsubscribe(subscription_id id)
+{
+    std::lock_guard<std::mutex> lck(mtx_);
+
+    subscriptions_.erase(id);
+}
+
+void file_watch_service::thread_funct(void)
+{
+    char buffer[FILE_WATCH_EVENT_BUF_LEN] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pfd;
+
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    while (! stop_)
+    {
+        if (::poll(&pfd, 1, FILE_WATCH_POLL_TIMEOUT_MS) != 1)
+        {
+            continue;
+        }
+
+        int length = ::read(fd_, buffer, FILE_WATCH_EVENT_BUF_LEN);
+
+        if (length <= 0)
+        {
+            continue;
+        }
+
+        //
+        // Several events for the same file in one
+        // read are delivered to handlers once.
+        //
+
+        std::set<std::pair<int, std::string> > changed;
+
+        for (int i = 0; i < length; )
+        {
+            struct inotify_event *event = (struct inotify_event *) &buffer[i];
+
+            if (event -> len)
+            {
+                changed.insert(std::make_pair(event -> wd, std::string(event -> name)));
+            }
+
+            i += FILE_WATCH_EVENT_SIZE + event -> len;
+        }
+
+        std::lock_guard<std::mutex> lck(mtx_);
+
+        for (auto &s : subscriptions_)
+        {
+            if (changed.find(std::make_pair(s.second.wd, s.second.name)) == changed.end())
+            {
+                continue;
+            }
+
+            try
+            {
+                s.second.h(s.second.path);
+            }
+            catch (const std::exception &e)
+            {
+                hft_log(ERROR) << "Handler for file [" << s.second.path
+                               << "] failed: " << e.what();
+            }
+        }
+    }
+}
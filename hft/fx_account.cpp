@@ -18,6 +18,7 @@
 #include <hft_utils.hpp>
 
 #include <iostream>
+#include <limits>
 #include <unistd.h>
 
 #include <boost/tokenizer.hpp>
@@ -107,11 +108,24 @@ void fx_account::forcibly_close_position(const csv_loader::csv_record &market_in
 }
 
 std::string fx_account::get_position_status(const csv_loader::csv_record &market_info) const
+{
+    if (position_ == NONE)
+    {
+        return "N/A";
+    }
+
+    return boost::lexical_cast<std::string>(get_position_pips(market_info));
+}
+
+//
+// Current position result in pips, NaN if there is no position.
+//
+
+double fx_account::get_position_pips(const csv_loader::csv_record &market_info) const
 {
     std::string open_price_str  = boost::lexical_cast<std::string>(open_price_);
     std::string current_price_str;
 
-    std::string ret;
     double value;
 
     switch (position_)
@@ -119,18 +133,16 @@ std::string fx_account::get_position_status(const csv_loader::csv_record &market
         case LONG:
              current_price_str = boost::lexical_cast<std::string>(market_info.bid);
              value = (double(hft::floating2dpips(current_price_str, itype_)) - double(hft::floating2dpips(open_price_str, itype_)))/10.0;
-             ret = boost::lexical_cast<std::string>(value);
              break;
         case SHORT:
              current_price_str = boost::lexical_cast<std::string>(market_info.ask);
              value = (double(hft::floating2dpips(open_price_str, itype_)) - double(hft::floating2dpips(current_price_str, itype_)))/10.0;
-             ret = boost::lexical_cast<std::string>(value);
              break;
         default:
-             ret = "N/A";
+             value = std::numeric_limits<double>::quiet_NaN();
     }
 
-    return ret;
+    return value;
 }
 
 void fx_account::open_long(const csv_loader::csv_record &market_info)
@@ -20,6 +20,8 @@
 #include <boost/asio.hpp>
 #include <boost/lexical_cast.hpp>
 #include <fx_account.hpp>
+#include <hft_bin_proto.hpp>
+#include <hft_shm_client.h>
 #include <boost/program_options.hpp>
 #include <easylogging++.h>
 
@@ -27,6 +29,8 @@ namespace prog_opts = boost::program_options;
 
 using boost::asio::ip::tcp;
 
+typedef boost::asio::generic::stream_protocol::socket stream_socket;
+
 enum { max_length = 1024 };
 
 static struct fxemulator_options_type
@@ -35,6 +39,9 @@ static struct fxemulator_options_type
     std::string port;
     std::string instrument;
     bool invert_hft_decision;
+    bool binary_protocol;
+    std::string shm_channel;
+    std::string unix_socket;
 
 } fxemulator_options;
 
@@ -44,20 +51,74 @@ static struct fxemulator_options_type
 #define hft_log(__X__) \
     CLOG(__X__, "fxemulator")
 
-static bool subscribe_instrument(tcp::socket &server_connection)
+//
+// Binary protocol counterpart of request/response exchange.
+// Response is translated to text form, so the rest of
+// emulator does not care which protocol is in use.
+//
+
+static hft_shm_client *shm_connection = nullptr;
+
+static std::string bin_exchange(stream_socket &server_connection, const std::string &request)
+{
+    hft::bin_frame_header header;
+    std::vector<unsigned char> payload;
+
+    if (shm_connection != nullptr)
+    {
+        payload.resize(sizeof(header) + hft::BIN_PROTO_MAX_PAYLOAD);
+
+        long length = hft_shm_request(shm_connection, request.data(), request.length(),
+                                      payload.data(), payload.size(), 5000);
+
+        if (length < long(sizeof(header)))
+        {
+            throw std::runtime_error(std::string("Shared memory transport error: ") + hft_shm_last_error());
+        }
+
+        std::memcpy(&header, payload.data(), sizeof(header));
+
+        return hft::bin_decode_response(header, payload.data() + sizeof(header));
+    }
+
+    boost::asio::write(server_connection, boost::asio::buffer(request.data(), request.length()));
+    boost::asio::read(server_connection, boost::asio::buffer(&header, sizeof(header)));
+
+    payload.resize(header.length);
+
+    if (header.length > 0)
+    {
+        boost::asio::read(server_connection, boost::asio::buffer(payload.data(), payload.size()));
+    }
+
+    return hft::bin_decode_response(header, payload.data());
+}
+
+static bool subscribe_instrument(stream_socket &server_connection)
 {
     std::string reply;
-    std::string data_to_server = std::string("SUBSCRIBE;")
-                                 + hftOption(instrument) + std::string("\n");
 
     hft_log(INFO) << "Subscribe instrument [" << hftOption(instrument) << "]";
 
-    boost::asio::write(server_connection, boost::asio::buffer(data_to_server.c_str(),data_to_server.length()));
+    if (hftOption(binary_protocol))
+    {
+        std::string data_to_server;
+
+        hft::bin_encode_subscribe({ hft::instrument2type(hftOption(instrument)) }, data_to_server);
+        reply = bin_exchange(server_connection, data_to_server);
+    }
+    else
+    {
+        std::string data_to_server = std::string("SUBSCRIBE;")
+                                     + hftOption(instrument) + std::string("\n");
 
-    boost::asio::streambuf data_from_server;
-    size_t reply_length = boost::asio::read_until(server_connection, data_from_server, '\n');
-    std::istream str(&data_from_server); 
-    std::getline(str, reply);
+        boost::asio::write(server_connection, boost::asio::buffer(data_to_server.c_str(),data_to_server.length()));
+
+        boost::asio::streambuf data_from_server;
+        size_t reply_length = boost::asio::read_until(server_connection, data_from_server, '\n');
+        std::istream str(&data_from_server); 
+        std::getline(str, reply);
+    }
 
     if (reply != "OK")
     {
@@ -75,7 +136,7 @@ static bool subscribe_instrument(tcp::socket &server_connection)
     return true;
 }
 
-static void emulatefx(tcp::socket &server_connection, const std::string &csv_file, fx_account &account)
+static void emulatefx(stream_socket &server_connection, const std::string &csv_file, fx_account &account)
 {
     csv_loader::csv_record tick_record;
     csv_loader csv_data(csv_file);
@@ -83,8 +144,34 @@ static void emulatefx(tcp::socket &server_connection, const std::string &csv_fil
     std::string data_to_server;
     std::string reply;
 
+    hft::instrument_type itype = hft::instrument2type(hftOption(instrument));
+    hft::bin_tick_payload bin_tick;
+
+    std::memset(&bin_tick, 0, sizeof(bin_tick));
+    bin_tick.instrument_id = itype;
+
     while (csv_data.get_record(tick_record))
     {
+        if (hftOption(binary_protocol))
+        {
+            if (! hft::datetime_str_to_epoch_usec(tick_record.request_time, bin_tick.request_time))
+            {
+                throw std::runtime_error(std::string("Bad request time: ") + tick_record.request_time);
+            }
+
+            bin_tick.ask             = hft::floating2dpips(boost::lexical_cast<std::string>(tick_record.ask), itype);
+            bin_tick.bankroll        = 0.0;
+            bin_tick.position_status = account.get_position_pips(tick_record);
+
+            data_to_server.clear();
+            hft::bin_encode_tick(bin_tick, data_to_server);
+
+            reply = bin_exchange(server_connection, data_to_server);
+            account.proceed_operation(reply, tick_record);
+
+            continue;
+        }
+
         data_to_server = std::string("TICK;") + hftOption(instrument)
                          + std::string(";")
                          + tick_record.request_time
@@ -149,6 +236,9 @@ int hft_fxemulator_main(int argc, char *argv[])
         ("host,H", prog_opts::value<std::string>(&hftOption(host)) -> default_value("localhost"), "HFT server hostname or ip address. Defaut is localhost.")
         ("port,P", prog_opts::value<std::string>(&hftOption(port)) -> default_value("8137"), "HFT server listen port. Default is 8137.")
         ("invert-hft-decision,I", prog_opts::value<bool>(&hftOption(invert_hft_decision)) -> default_value(false), "Trade based on inverted HFT decision.")
+        ("binary-protocol,B", prog_opts::value<bool>(&hftOption(binary_protocol)) -> default_value(false), "Talk to HFT server using binary protocol.")
+        ("shm-channel,S", prog_opts::value<std::string>(&hftOption(shm_channel)) -> default_value(""), "Talk to HFT server through shared memory channel instead of TCP (implies binary protocol).")
+        ("unix-socket,U", prog_opts::value<std::string>(&hftOption(unix_socket)) -> default_value(""), "Connect to HFT server through Unix domain socket instead of TCP.")
         ("instrument,i", prog_opts::value<std::string>(&hftOption(instrument)))
         ("csv-files,f", prog_opts::value< std::vector<std::string> >(), "CSV file name(s) with dukascopy history data.")
     ;
@@ -194,9 +284,57 @@ int hft_fxemulator_main(int argc, char *argv[])
 
     boost::asio::io_context ioctx;
 
-    tcp::socket socket(ioctx);
-    tcp::resolver resolver(ioctx);
-    boost::asio::connect(socket, resolver.resolve({hftOption(host), hftOption(port)}));
+    stream_socket socket(ioctx);
+
+    if (hftOption(shm_channel).length())
+    {
+        shm_connection = hft_shm_connect(hftOption(shm_channel).c_str(), 5000);
+
+        if (shm_connection == nullptr)
+        {
+            hft_log(ERROR) << hft_shm_last_error();
+
+            return 1;
+        }
+
+        hft_log(INFO) << "Connected to shared memory channel [" << hftOption(shm_channel) << "]";
+
+        hftOption(binary_protocol) = true;
+    }
+    else if (hftOption(unix_socket).length())
+    {
+        socket.connect(boost::asio::local::stream_protocol::endpoint(hftOption(unix_socket)));
+
+        hft_log(INFO) << "Connected to Unix socket [" << hftOption(unix_socket) << "]";
+    }
+    else
+    {
+        tcp::resolver resolver(ioctx);
+        boost::system::error_code error = boost::asio::error::host_not_found;
+
+        for (auto &entry : resolver.resolve(hftOption(host), hftOption(port)))
+        {
+            socket.close();
+            socket.connect(entry.endpoint(), error);
+
+            if (! error)
+            {
+                break;
+            }
+        }
+
+        if (error)
+        {
+            throw boost::system::system_error(error);
+        }
+    }
+
+    if (hftOption(binary_protocol) && shm_connection == nullptr)
+    {
+        hft_log(INFO) << "Using binary protocol";
+
+        boost::asio::write(socket, boost::asio::buffer(&hft::BIN_PROTO_MAGIC, 1));
+    }
 
     if (! subscribe_instrument(socket))
     {
@@ -224,6 +362,8 @@ int hft_fxemulator_main(int argc, char *argv[])
 
     account.dispaly_statistics();
 
+    hft_shm_disconnect(shm_connection);
+
     hft_log(INFO) << "** Done.";
 
     return 0;
@@ -15,9 +15,15 @@
 \**********************************************************************/
 
 #include <iostream>
+#include <sstream>
 #include <cmath>
+#include <vector>
+#include <memory>
+#include <thread>
 
 #include <boost/program_options.hpp>
+#include <boost/tokenizer.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <easylogging++.h>
 
@@ -29,51 +35,262 @@ static struct _hft_bcalc_config
     unsigned int n;
     unsigned int k;
     bool json_report;
+    bool table;
+    std::string p_grid;
+    std::string n_grid;
+    double vote_ratio;
+    int ncores;
 } hft_bcalc_config;
 
+typedef std::vector<double> probability_table;
+
+struct bcalc_result
+{
+    double p;
+    unsigned int n;
+    unsigned int k;
+    double game_probability;
+    double prediction_probability;
+};
+
+struct worker_data
+{
+    std::vector<bcalc_result> results;
+
+    std::shared_ptr<std::thread> thread;
+};
+
+typedef std::vector<worker_data> workers;
+
 #define hftOption(__X__) \
     hft_bcalc_config.__X__
 
 #define hft_log(__X__) \
     CLOG(__X__, "hft_bcalc")
 
-static double bernoulli(double p, unsigned int n, unsigned int k)
+//
+// Probability mass function of binomial distribution
+// for all k ∈ [0, n]. Each term is computed directly
+// in logarithmic domain, so table is built in O(n)
+// with no error accumulated along k.
+//
+
+static void pmf_table(double p, unsigned int n, probability_table &pmf)
 {
-    if (k > n)
+    pmf.assign(n + 1, 0.0);
+
+    if (p <= 0.0)
+    {
+        pmf[0] = 1.0;
+
+        return;
+    }
+
+    if (p >= 1.0)
+    {
+        pmf[n] = 1.0;
+
+        return;
+    }
+
+    const double lp = log(p);
+    const double lq = log(1.0 - p);
+    const double lgn = lgamma(n + 1.0);
+
+    for (unsigned int k = 0; k <= n; k++)
     {
-        throw std::logic_error("k must be less than n");
+        pmf[k] = exp(lgn - lgamma(k + 1.0) - lgamma(n - k + 1.0) + lp*k + lq*(n - k));
     }
+}
 
-    double d = log(p)*k + log(1.0-p)*(n-k);
-    double s1 = 0.0, s2 = 0.0;
+static void cdf_table(const probability_table &pmf, probability_table &cdf)
+{
+    double s = 0.0;
+
+    cdf.resize(pmf.size());
 
-    if (k > n - k)
+    for (size_t k = 0; k < pmf.size(); k++)
     {
-        for (unsigned int i = k + 1; i <= n; i++)
-        {
-            s1 += log(i);
-        }
+        s += pmf[k];
+        cdf[k] = s;
+    }
+}
 
-        for (unsigned int i = 1; i <= n - k; i++)
-        {
-            s2 += log(i);
-        }
+//
+// P(X≥k) summed from the upper end, so small tails keep
+// their precision instead of cancelling in 1 - P(X<k).
+//
+
+static void tail_table(const probability_table &pmf, probability_table &tail)
+{
+    double s = 0.0;
+
+    tail.resize(pmf.size());
+
+    for (size_t k = pmf.size(); k-- > 0; )
+    {
+        s += pmf[k];
+        tail[k] = s;
+    }
+}
+
+//
+// Game probability is a chance that at least k of n predictors
+// agree (either correct or wrong), prediction probability is
+// a chance that agreeing predictors are correct.
+//
+
+static bcalc_result calculate(double p, unsigned int n, unsigned int k)
+{
+    bcalc_result r;
+    probability_table pmf;
+
+    pmf_table(p, n, pmf);
+
+    double pp = 0.0;
+    double wp = 0.0;
+
+    for (unsigned int i = k; i <= n; i++)
+    {
+        pp += pmf[i];
+    }
+
+    for (unsigned int i = 0; i <= n - k; i++)
+    {
+        wp += pmf[i];
+    }
+
+    r.p = p;
+    r.n = n;
+    r.k = k;
+    r.game_probability = pp + wp;
+    r.prediction_probability = pp / (pp + wp);
+
+    return r;
+}
+
+static std::string result2json(const bcalc_result &r)
+{
+    std::ostringstream oss;
+
+    oss << "{\"p\":" << r.p
+        << ",\"n\":" << r.n
+        << ",\"k\":" << r.k
+        << ",\"game_probability\":" << r.game_probability
+        << ",\"prediction_probability\":" << r.prediction_probability
+        << "}";
+
+    return oss.str();
+}
+
+//
+// Grid format is „<from>:<to>:<step>” or single value.
+//
+
+template <typename T>
+static std::vector<T> parse_grid(const std::string &grid)
+{
+    std::vector<T> values;
+    std::vector<T> ret;
+
+    boost::char_separator<char> sep(":");
+    boost::tokenizer<boost::char_separator<char> > tokens(grid, sep);
+
+    for (auto &token : tokens)
+    {
+        values.push_back(boost::lexical_cast<T>(token));
+    }
+
+    if (values.size() == 1)
+    {
+        return values;
+    }
+
+    if (values.size() != 3 || values[2] <= 0 || values[0] > values[1])
+    {
+        throw std::runtime_error(std::string("Invalid grid „") + grid + std::string("”"));
     }
-    else
+
+    for (unsigned int i = 0; values[0] + i*values[2] <= values[1] + values[2]*1e-9; i++)
     {
-        for (unsigned int i = n - k + 1; i <= n; i++)
+        ret.push_back(values[0] + i*values[2]);
+    }
+
+    return ret;
+}
+
+static void thread_funct_batch(worker_data *self, const std::vector<std::pair<double, unsigned int> > *jobs,
+                                   size_t first, size_t step)
+{
+    for (size_t i = first; i < jobs -> size(); i += step)
+    {
+        double p = jobs -> at(i).first;
+        unsigned int n = jobs -> at(i).second;
+        //
+        // Epsilon absorbs representation error of the ratio,
+        // e.g. 0.55·100 evaluates to 55.000…01.
+        //
+
+        unsigned int k = static_cast<unsigned int>(ceil(hftOption(vote_ratio) * n - 1e-9));
+
+        self -> results.push_back(calculate(p, n, k));
+    }
+}
+
+static int batch(void)
+{
+    std::vector<std::pair<double, unsigned int> > jobs;
+
+    for (auto p : parse_grid<double>(hftOption(p_grid)))
+    {
+        if (p < 0.0 || p > 1.0)
         {
-            s1 += log(i);
+            hft_log(ERROR) << "Invalid probability value " << p;
+
+            return 1;
         }
 
-        for (unsigned int i = 1; i <= k; i++)
+        for (auto n : parse_grid<unsigned int>(hftOption(n_grid)))
         {
-            s2 += log(i);
+            if (n == 0)
+            {
+                continue;
+            }
+
+            jobs.push_back(std::make_pair(p, n));
         }
+    }
+
+    size_t ncores = hftOption(ncores) > 0 ? hftOption(ncores) : 1;
+    workers thread_workers(std::max(static_cast<size_t>(1), std::min(ncores, jobs.size())));
 
+    for (size_t i = 0; i < thread_workers.size(); i++)
+    {
+        thread_workers[i].thread.reset(new std::thread(thread_funct_batch, &thread_workers[i], &jobs, i, thread_workers.size()));
     }
 
-    return exp(s1-s2+d);
+    for (auto &x : thread_workers)
+    {
+        x.thread -> join();
+    }
+
+    //
+    // Workers took jobs in round robin, restore grid order.
+    //
+
+    std::cout << "[\n";
+
+    for (size_t i = 0; i < jobs.size(); i++)
+    {
+        const worker_data &w = thread_workers[i % thread_workers.size()];
+
+        std::cout << "\t" << result2json(w.results[i / thread_workers.size()])
+                  << (i + 1 < jobs.size() ? ",\n" : "\n");
+    }
+
+    std::cout << "]\n";
+
+    return 0;
 }
 
 int hft_bcalc_main(int argc, char *argv[])
@@ -111,6 +328,11 @@ int hft_bcalc_main(int argc, char *argv[])
         ("predictors,n", prog_opts::value<unsigned int>(&hftOption(n) ), "total amount of predictors")
         ("amount,k", prog_opts::value<unsigned int>(&hftOption(k) ), "amount of predictors with equal predictions")
         ("json-report,j", prog_opts::value<bool>(&hftOption(json_report)) -> default_value(false), "Wheather report should be displayed in human readable format or JSON")
+        ("table,t", prog_opts::value<bool>(&hftOption(table)) -> default_value(false), "Display full PMF/CDF table for all amounts 0 … n")
+        ("batch-p,P", prog_opts::value<std::string>(&hftOption(p_grid)) -> default_value(""), "Batch mode: grid of probabilities in format <from>:<to>:<step>")
+        ("batch-n,N", prog_opts::value<std::string>(&hftOption(n_grid)) -> default_value(""), "Batch mode: grid of predictors amount in format <from>:<to>:<step>")
+        ("vote-ratio,r", prog_opts::value<double>(&hftOption(vote_ratio)) -> default_value(0.5), "Batch mode: amount of equal predictions as a ratio of predictors, k = ⌈ratio·n⌉")
+        ("threads,u", prog_opts::value<int>(&hftOption(ncores)) -> default_value(std::thread::hardware_concurrency()), "Define number of threads")
     ;
 
     prog_opts::options_description cmdline_options;
@@ -134,10 +356,40 @@ int hft_bcalc_main(int argc, char *argv[])
 
     el::Logger *logger = el::Loggers::getLogger("hft_bcalc", true);
 
+    //
+    // Batch mode.
+    //
+
+    if (hftOption(p_grid).length() || hftOption(n_grid).length())
+    {
+        if (hftOption(p_grid).length() == 0 || hftOption(n_grid).length() == 0)
+        {
+            hft_log(ERROR) << "Batch mode requires both probability and predictors grid";
+
+            return 1;
+        }
+
+        if (hftOption(vote_ratio) < 0.5 || hftOption(vote_ratio) > 1.0)
+        {
+            hft_log(ERROR) << "Vote ratio must be in range [0.5, 1]";
+
+            return 1;
+        }
+
+        return batch();
+    }
+
     //
     // Config validation.
     //
 
+    if (! vm.count("probability") || ! vm.count("predictors") || ! vm.count("amount"))
+    {
+        hft_log(ERROR) << "Unspecified probability, predictors or amount";
+
+        return 1;
+    }
+
     if (hftOption(p) < 0.0 || hftOption(p) > 1.0)
     {
         hft_log(ERROR) << "Invalid probability value";
@@ -159,22 +411,52 @@ int hft_bcalc_main(int argc, char *argv[])
         return 1;
     }
 
-    double gp = 0.0;
-
-    for (unsigned int i = hftOption(k); i <= hftOption(n); i++)
+    if (hftOption(table))
     {
-        gp += bernoulli(hftOption(p), hftOption(n), i);
+        probability_table pmf, cdf, tail;
+
+        pmf_table(hftOption(p), hftOption(n), pmf);
+        cdf_table(pmf, cdf);
+        tail_table(pmf, tail);
+
+        if (hftOption(json_report))
+        {
+            std::cout << "[\n";
+
+            for (unsigned int i = 0; i <= hftOption(n); i++)
+            {
+                std::cout << "\t{\"k\":" << i << ",\"pmf\":" << pmf[i]
+                          << ",\"cdf\":" << cdf[i] << ",\"tail\":" << tail[i]
+                          << (i < hftOption(n) ? "},\n" : "}\n");
+            }
+
+            std::cout << "]\n";
+        }
+        else
+        {
+            std::cout << "k\tP(X=k)\tP(X≤k)\tP(X≥k)\n";
+
+            for (unsigned int i = 0; i <= hftOption(n); i++)
+            {
+                std::cout << i << "\t" << pmf[i] << "\t" << cdf[i]
+                          << "\t" << tail[i] << "\n";
+            }
+        }
+
+        return 0;
     }
 
-    double pp = gp;
+    bcalc_result r = calculate(hftOption(p), hftOption(n), hftOption(k));
 
-    for (unsigned int i = 0; i <= hftOption(n) - hftOption(k); i++)
+    if (hftOption(json_report))
     {
-        gp += bernoulli(hftOption(p), hftOption(n), i);
+        std::cout << result2json(r) << "\n";
+
+        return 0;
     }
 
-    std::cout << "Game probability: " << gp << "\n";
-    std::cout << "Prediction probability: " << (pp/gp) << "\n";
+    std::cout << "Game probability: " << r.game_probability << "\n";
+    std::cout << "Prediction probability: " << r.prediction_probability << "\n";
 
     return 0;
 }
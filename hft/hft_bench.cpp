@@ -0,0 +1,736 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+
+//
+// Microbenchmarks of hot-path components. Every benchmark
+// reports nanoseconds and heap allocations per operation and
+// throughput. Results may be saved as JSON and compared later
+// against such a baseline, which flags regressions.
+//
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+#include <easylogging++.h>
+#include <cJSON/cJSON.h>
+
+#include <hft_utils.hpp>
+#include <hft_req_proto.hpp>
+#include <mdc.hpp>
+#include <binomial_approximation.hpp>
+#include <basic_artifical_inteligence.hpp>
+#include <csv_loader.hpp>
+#include <hci.hpp>
+#include <expert_advisor.hpp>
+#include <tracer.hpp>
+#include <quantized_network.hpp>
+
+INITIALIZE_EASYLOGGINGPP
+
+namespace prog_opts = boost::program_options;
+
+//
+// Heap allocations counter. Global operator new is replaced
+// in this executable only; counter is per thread, so threads
+// in the background (e.g. file watch service) do not disturb
+// measurements.
+//
+
+static thread_local unsigned long allocations_counter = 0;
+
+void *operator new(std::size_t size)
+{
+    allocations_counter++;
+
+    void *p = std::malloc(size == 0 ? 1 : size);
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+static struct hft_bench_options_type
+{
+    std::string filter;
+    std::string output_file_name;
+    std::string baseline_file_name;
+    std::string instrument;
+    double min_time;
+    double threshold;
+    bool json;
+
+} hft_bench_options;
+
+#define hftOption(__X__) \
+    hft_bench_options.__X__
+
+//
+// Keeps compiler from optimizing out benchmarked code.
+//
+
+template <typename T>
+inline void do_not_optimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct benchmark_result
+{
+    std::string name;
+    unsigned long iterations;
+    double ns_per_op;
+    double allocs_per_op;
+    double ops_per_sec;
+};
+
+static std::vector<benchmark_result> results;
+
+//
+// Runs „op” in batches. Batch size is calibrated to last at
+// least 10 ms, batches are repeated until „min_time” elapses.
+// Reported time is median of batches, which is insensitive
+// to occasional preemption.
+//
+
+static void run_benchmark(const std::string &name, const std::function<void(void)> &op)
+{
+    typedef std::chrono::steady_clock clock_type;
+
+    if (name.find(hftOption(filter)) == std::string::npos)
+    {
+        return;
+    }
+
+    unsigned long batch = 1;
+
+    while (true)
+    {
+        auto started = clock_type::now();
+
+        for (unsigned long i = 0; i < batch; i++)
+        {
+            op();
+        }
+
+        if (clock_type::now() - started >= std::chrono::milliseconds(10) || batch >= (1UL << 30))
+        {
+            break;
+        }
+
+        batch *= 2;
+    }
+
+    std::vector<double> samples;
+    unsigned long iterations = 0;
+    unsigned long allocations = 0;
+    double total_time = 0.0;
+
+    while (total_time < hftOption(min_time) || samples.size() < 5)
+    {
+        unsigned long allocations_before = allocations_counter;
+        auto started = clock_type::now();
+
+        for (unsigned long i = 0; i < batch; i++)
+        {
+            op();
+        }
+
+        double elapsed = std::chrono::duration<double>(clock_type::now() - started).count();
+
+        allocations += allocations_counter - allocations_before;
+        iterations += batch;
+        total_time += elapsed;
+
+        samples.push_back(elapsed * 1e9 / batch);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    benchmark_result result;
+
+    result.name          = name;
+    result.iterations    = iterations;
+    result.ns_per_op     = samples[samples.size() / 2];
+    result.allocs_per_op = double(allocations) / iterations;
+    result.ops_per_sec   = 1e9 / result.ns_per_op;
+
+    results.push_back(result);
+
+    if (! hftOption(json))
+    {
+        std::cout << std::left << std::setw(52) << name << std::right
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(12) << result.ns_per_op << " ns/op"
+                  << std::setprecision(2)
+                  << std::setw(10) << result.allocs_per_op << " allocs/op"
+                  << std::setprecision(0)
+                  << std::setw(14) << result.ops_per_sec << " ops/s\n";
+    }
+}
+
+//
+// Realistic inputs. Prices are random walk of EURUSD in
+// dpips (5 decimal places) with steps similar to real ticks.
+// Approximation comes from EURUSD instrument distribution.
+//
+
+static const char *eurusd_approximation =
+    "{ \"n\" : 31678, \"distribution\" : { \"1\" : 15857.220839, \"2\" : 15897.735422,"
+    " \"3\" : 15933.378792, \"4\" : 15959.505278 } }";
+
+static std::vector<unsigned int> random_walk(size_t size, unsigned int start, unsigned int seed)
+{
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> step(0.0, 3.0);
+    std::vector<unsigned int> ticks(size);
+    long price = start;
+
+    for (auto &t : ticks)
+    {
+        price += std::lround(step(generator));
+        t = price;
+    }
+
+    return ticks;
+}
+
+static std::string dpips_to_string(unsigned int dpips)
+{
+    char buffer[32];
+
+    std::snprintf(buffer, sizeof(buffer), "%u.%05u", dpips / 100000, dpips % 100000);
+
+    return buffer;
+}
+
+static void bench_market_data_collector(void)
+{
+    const size_t collector_size = 220;
+    std::vector<unsigned int> ticks = random_walk(65536, 110000, 2017);
+    size_t index = 0;
+
+    market_data_collector mdc(collector_size + 1);
+
+    mdc.set_btf_approximator_from_buffer(eurusd_approximation);
+
+    run_benchmark("market_data_collector::feed_data", [&]()
+    {
+        mdc.feed_data(ticks[index++ & 0xFFFF]);
+    });
+
+    //
+    // Loading input bus takes 220 statistics of growing
+    // sample size, see basic_artifical_inteligence.
+    //
+
+    const double c2ib_gain = 0.00456621 * (collector_size - 1);
+
+    run_benchmark("market_data_collector::get_btfa/input_bus", [&]()
+    {
+        for (unsigned int i = 0; i < 220; i++)
+        {
+            do_not_optimize(mdc.get_btfa(c2ib_gain * i + 1, 0));
+        }
+    });
+}
+
+static void bench_binomial_approximation(void)
+{
+    binomial_approximation approximation;
+    std::vector<unsigned int> ticks = random_walk(65537, 110000, 2018);
+    std::vector<int> oscillations(65536);
+    size_t index = 0;
+
+    approximation.load_data_from_string(eurusd_approximation);
+
+    for (size_t i = 0; i < oscillations.size(); i++)
+    {
+        oscillations[i] = int(ticks[i]) - int(ticks[i+1]);
+    }
+
+    run_benchmark("binomial_approximation::get_draw", [&]()
+    {
+        do_not_optimize(approximation.get_draw(oscillations[index++ & 0xFFFF]));
+    });
+}
+
+static void bench_neural_network(void)
+{
+    std::shared_ptr<neural_network> net = basic_artifical_inteligence::create_neural_network({ 7 });
+    std::mt19937 generator(2019);
+    std::normal_distribution<double> input(0.0, 1.0);
+
+    for (unsigned int i = 0; i < net -> get_number_of_inputs(); i++)
+    {
+        net -> set_pin(i, input(generator));
+    }
+
+    run_benchmark("neural_network::fire/[220 20 7 1]", [&]()
+    {
+        net -> fire();
+        do_not_optimize(net -> get_output(0));
+    });
+
+    //
+    // Tabulated activate functions, forward
+    // pass and training step.
+    //
+
+    for (auto acc : { hft::ACTIVATION_EXACT, hft::ACTIVATION_FINE, hft::ACTIVATION_COARSE })
+    {
+        std::string suffix = "/" + hft::activation_accuracy_to_string(acc);
+
+        net -> set_activation_accuracy(acc);
+
+        if (acc != hft::ACTIVATION_EXACT)
+        {
+            run_benchmark("neural_network::fire/[220 20 7 1]" + suffix, [&]()
+            {
+                net -> fire();
+                do_not_optimize(net -> get_output(0));
+            });
+        }
+
+        net -> set_learn_coefficient(1e-9);
+
+        run_benchmark("neural_network::feedback/[220 20 7 1]" + suffix, [&]()
+        {
+            net -> fire();
+            net -> feedback(1.0);
+        });
+
+        net -> set_learn_coefficient(0.0);
+    }
+
+    net -> set_activation_accuracy(hft::ACTIVATION_EXACT);
+
+    //
+    // Quantized copy calibrated on inputs
+    // of the same distribution.
+    //
+
+    hftr_samples calibration;
+    hftr h;
+
+    h.set_output(hftr::INCREASE);
+
+    for (int n = 0; n < 64; n++)
+    {
+        for (unsigned int i = 0; i < net -> get_number_of_inputs(); i++)
+        {
+            h.set_pin(i, input(generator));
+        }
+
+        calibration.append(h);
+    }
+
+    quantized_network qnet(*net, calibration);
+    const double *pins = calibration.get_pins(0);
+
+    run_benchmark("quantized_network::fire/[220 20 7 1]", [&]()
+    {
+        qnet.fire(pins);
+        do_not_optimize(qnet.get_output(0));
+    });
+}
+
+static void bench_protocol(void)
+{
+    std::vector<unsigned int> ticks = random_walk(4096, 110000, 2020);
+    std::vector<std::string> requests;
+    std::vector<std::string> prices;
+    size_t index = 0;
+
+    for (size_t i = 0; i < ticks.size(); i++)
+    {
+        std::ostringstream oss;
+
+        oss << "TICK;EURUSD;2015-09-01 " << std::setfill('0')
+            << std::setw(2) << (i / 3600) % 24 << ":"
+            << std::setw(2) << (i / 60) % 60 << ":"
+            << std::setw(2) << i % 60 << "."
+            << std::setw(3) << (i * 37) % 1000 << ";"
+            << dpips_to_string(ticks[i]) << ";1000.0;"
+            << ((i % 4 == 0) ? std::string("N/A") : std::to_string(int(i % 97) - 48) + ".5");
+
+        requests.push_back(oss.str());
+        prices.push_back(dpips_to_string(ticks[i]));
+    }
+
+    run_benchmark("hft::req_parse_message/TICK", [&]()
+    {
+        hft::generic_protocol_message msg = hft::req_parse_message(requests[index++ & 0xFFF]);
+        do_not_optimize(msg);
+    });
+
+    hft::instrument_type eurusd = hft::instrument2type("EURUSD");
+
+    run_benchmark("hft::floating2dpips", [&]()
+    {
+        do_not_optimize(hft::floating2dpips(prices[index++ & 0xFFF], eurusd));
+    });
+}
+
+static void bench_csv_loader(void)
+{
+    char file_name[] = "/tmp/hft-bench-XXXXXX";
+    int fd = ::mkstemp(file_name);
+
+    if (fd < 0)
+    {
+        throw std::runtime_error("Unable to create temporary CSV file");
+    }
+
+    ::close(fd);
+
+    {
+        std::ofstream csv(file_name);
+        std::vector<unsigned int> ticks = random_walk(100000, 110000, 2021);
+
+        csv << "Gmt time,Ask,Bid,AskVolume,BidVolume\n";
+
+        for (size_t i = 0; i < ticks.size(); i++)
+        {
+            csv << "01.09.2015 " << std::setfill('0')
+                << std::setw(2) << (i / 3600) % 24 << ":"
+                << std::setw(2) << (i / 60) % 60 << ":"
+                << std::setw(2) << i % 60 << "."
+                << std::setw(3) << (i * 37) % 1000 << ","
+                << dpips_to_string(ticks[i]) << ","
+                << dpips_to_string(ticks[i] - 10) << ",1.0,1.0\n";
+        }
+    }
+
+    csv_loader loader(file_name);
+    csv_loader::csv_record record;
+
+    run_benchmark("csv_loader::get_record", [&]()
+    {
+        if (! loader.get_record(record))
+        {
+            loader.set_record_position(0);
+            loader.get_record(record);
+        }
+
+        do_not_optimize(record.ask);
+    });
+
+    ::unlink(file_name);
+}
+
+static void bench_hci(void)
+{
+    hci regulator(15, -10.0, 10.0);
+    std::mt19937 generator(2022);
+    std::uniform_int_distribution<int> yield(-10, 50);
+    std::vector<int> yields(4096);
+    size_t index = 0;
+
+    for (auto &y : yields)
+    {
+        y = (yield(generator) > 20) ? 50 : -10;
+    }
+
+    run_benchmark("hci::insert_pips_yield/15", [&]()
+    {
+        regulator.insert_pips_yield(yields[index++ & 0xFFF]);
+    });
+}
+
+static void bench_value_tracer(void)
+{
+    value_tracer tracer;
+    std::vector<unsigned int> ticks = random_walk(65536, 110000, 2024);
+    size_t index = 0;
+
+    //
+    // Ranges as registered by AI predictor.
+    //
+
+    tracer.add_range(range<unsigned int>(0, 99999));
+
+    for (unsigned i = 100000; i <= 150000; i += 10)
+    {
+        tracer.add_range(range<unsigned int>(i, i+9));
+    }
+
+    tracer.add_range(range<unsigned int>(150010, 999999));
+
+    run_benchmark("value_tracer::put_value/5003", [&]()
+    {
+        tracer.put_value(ticks[index++ & 0xFFFF]);
+        do_not_optimize(tracer.get_trace());
+    });
+}
+
+static void bench_expert_advisor(void)
+{
+    std::unique_ptr<expert_advisor> advisor;
+
+    try
+    {
+        advisor.reset(new expert_advisor(hftOption(instrument)));
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Skipping expert_advisor benchmark: " << e.what() << "\n";
+
+        return;
+    }
+
+    std::vector<unsigned int> ticks = random_walk(65536, 110000, 2023);
+    size_t index = 0;
+
+    while (! advisor -> has_sufficient_data())
+    {
+        advisor -> poke_tick(ticks[index++ & 0xFFFF]);
+    }
+
+    //
+    // One operation is a tick followed by advice, as
+    // instrument handler does.
+    //
+
+    run_benchmark("expert_advisor::provide_advice/" + hftOption(instrument), [&]()
+    {
+        advisor -> poke_tick(ticks[index++ & 0xFFFF]);
+        do_not_optimize(advisor -> provide_advice());
+    });
+}
+
+static std::string results_to_json(void)
+{
+    cJSON *json = cJSON_CreateObject();
+    cJSON *benchmarks = cJSON_CreateArray();
+
+    cJSON_AddNumberToObject(json, "version", 1);
+    cJSON_AddNumberToObject(json, "min_time", hftOption(min_time));
+    cJSON_AddItemToObject(json, "benchmarks", benchmarks);
+
+    for (auto &r : results)
+    {
+        cJSON *item = cJSON_CreateObject();
+
+        cJSON_AddStringToObject(item, "name", r.name.c_str());
+        cJSON_AddNumberToObject(item, "iterations", r.iterations);
+        cJSON_AddNumberToObject(item, "ns_per_op", r.ns_per_op);
+        cJSON_AddNumberToObject(item, "allocs_per_op", r.allocs_per_op);
+        cJSON_AddNumberToObject(item, "ops_per_sec", r.ops_per_sec);
+        cJSON_AddItemToArray(benchmarks, item);
+    }
+
+    char *text = cJSON_Print(json);
+    std::string out(text);
+
+    std::free(text);
+    cJSON_Delete(json);
+
+    return out;
+}
+
+//
+// Compares results with baseline. Benchmark regressed if it
+// got slower by more than threshold percent or allocates
+// more. Returns number of regressions.
+//
+
+static int compare_with_baseline(const std::string &file_name)
+{
+    std::ifstream is(file_name);
+
+    if (! is)
+    {
+        throw std::runtime_error("Unable to open baseline file: " + file_name);
+    }
+
+    std::stringstream buffer;
+    buffer << is.rdbuf();
+
+    cJSON *json = cJSON_Parse(buffer.str().c_str());
+    cJSON *benchmarks = (json == nullptr) ? nullptr : cJSON_GetObjectItem(json, "benchmarks");
+
+    if (benchmarks == nullptr || benchmarks -> type != cJSON_Array)
+    {
+        cJSON_Delete(json);
+
+        throw std::runtime_error("Invalid baseline file: " + file_name);
+    }
+
+    std::map<std::string, std::pair<double, double>> baseline;
+
+    for (int i = 0; i < cJSON_GetArraySize(benchmarks); i++)
+    {
+        cJSON *item = cJSON_GetArrayItem(benchmarks, i);
+        cJSON *name = cJSON_GetObjectItem(item, "name");
+        cJSON *ns = cJSON_GetObjectItem(item, "ns_per_op");
+        cJSON *allocs = cJSON_GetObjectItem(item, "allocs_per_op");
+
+        if (name != nullptr && ns != nullptr && allocs != nullptr)
+        {
+            baseline[name -> valuestring] = std::make_pair(ns -> valuedouble, allocs -> valuedouble);
+        }
+    }
+
+    cJSON_Delete(json);
+
+    int regressions = 0;
+
+    std::ostream &os = hftOption(json) ? std::cerr : std::cout;
+
+    os << "\nComparison with baseline „" << file_name << "” (threshold "
+       << hftOption(threshold) << "%):\n";
+
+    for (auto &r : results)
+    {
+        auto it = baseline.find(r.name);
+
+        if (it == baseline.end())
+        {
+            os << "  " << std::left << std::setw(52) << r.name << std::right << "  (not in baseline)\n";
+
+            continue;
+        }
+
+        double delta = 100.0 * (r.ns_per_op - it -> second.first) / it -> second.first;
+        bool slower = delta > hftOption(threshold);
+        bool allocates = r.allocs_per_op > it -> second.second + 0.01;
+
+        os << "  " << std::left << std::setw(52) << r.name << std::right
+           << std::fixed << std::setprecision(1) << std::showpos
+           << std::setw(8) << delta << "%" << std::noshowpos
+           << std::setprecision(2)
+           << "  allocs " << it -> second.second << " -> " << r.allocs_per_op
+           << ((slower || allocates) ? "  REGRESSION" : "") << "\n";
+
+        if (slower || allocates)
+        {
+            regressions++;
+        }
+    }
+
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    //
+    // Logging is disabled, benchmarks measure computation
+    // and reports go to standard output.
+    //
+
+    el::Configurations logger_cfg;
+    logger_cfg.setToDefault();
+    logger_cfg.parseFromText("* GLOBAL:\n"
+                             " ENABLED              =  false\n"
+                             " TO_FILE              =  false\n"
+                             " TO_STANDARD_OUTPUT   =  false\n"
+                            );
+    el::Loggers::setDefaultConfigurations(logger_cfg, true);
+
+    prog_opts::options_description desc("Options for hft-bench");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("filter,f", prog_opts::value<std::string>(&hftOption(filter)) -> default_value(""), "Run only benchmarks which name contains given string.")
+        ("output,o", prog_opts::value<std::string>(&hftOption(output_file_name)) -> default_value(""), "Save results as JSON to file, e.g. to be used as baseline later.")
+        ("baseline,b", prog_opts::value<std::string>(&hftOption(baseline_file_name)) -> default_value(""), "Compare results with baseline JSON file, exit code 1 on regression.")
+        ("threshold,t", prog_opts::value<double>(&hftOption(threshold)) -> default_value(10.0), "Slowdown in percent considered as regression.")
+        ("min-time,m", prog_opts::value<double>(&hftOption(min_time)) -> default_value(0.5), "Minimal measurement time of a benchmark in seconds.")
+        ("instrument,i", prog_opts::value<std::string>(&hftOption(instrument)) -> default_value("EURUSD"), "Instrument configured in /etc/hft for expert advisor benchmark.")
+        ("json,j", prog_opts::bool_switch(&hftOption(json)), "Print results as JSON to standard output.")
+    ;
+
+    try
+    {
+        prog_opts::variables_map vm;
+        prog_opts::store(prog_opts::parse_command_line(argc, argv, desc), vm);
+        prog_opts::notify(vm);
+
+        if (vm.count("help"))
+        {
+            std::cout << desc << "\n";
+
+            return 0;
+        }
+
+        bench_market_data_collector();
+        bench_binomial_approximation();
+        bench_neural_network();
+        bench_protocol();
+        bench_csv_loader();
+        bench_hci();
+        bench_value_tracer();
+        bench_expert_advisor();
+
+        std::string json = results_to_json();
+
+        if (hftOption(json))
+        {
+            std::cout << json << "\n";
+        }
+
+        if (hftOption(output_file_name).length())
+        {
+            std::ofstream os(hftOption(output_file_name));
+
+            os << json << "\n";
+        }
+
+        if (hftOption(baseline_file_name).length())
+        {
+            return (compare_with_baseline(hftOption(baseline_file_name)) == 0 ? 0 : 1);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "fatal error: " << e.what() << "\n";
+
+        return 255;
+    }
+
+    return 0;
+}
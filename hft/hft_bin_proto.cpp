@@ -0,0 +1,267 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <cstring>
+#include <cmath>
+
+#include <boost/lexical_cast.hpp>
+
+#include <hft_bin_proto.hpp>
+
+namespace hft {
+
+//
+// Helper routines.
+//
+
+static instrument_type validate_instrument_id(std::uint16_t instrument_id);
+static void append_frame(std::uint8_t opcode, const void *payload, size_t length, std::string &out);
+
+template<typename T> static T payload_cast(const bin_frame_header &header, const unsigned char *payload)
+{
+    T ret;
+
+    if (header.length != sizeof(T))
+    {
+        throw protocol_violation_error(std::string("Bad payload length: ")
+                                       + boost::lexical_cast<std::string>(header.length)
+                                       + std::string(" for opcode ")
+                                       + boost::lexical_cast<std::string>(int(header.opcode)));
+    }
+
+    std::memcpy(&ret, payload, sizeof(T));
+
+    return ret;
+}
+
+//
+// Main binary protocol request parsing function. Produces
+// exactly the same messages as text protocol parser.
+//
+
+generic_protocol_message bin_parse_message(const bin_frame_header &header, const unsigned char *payload)
+{
+    generic_protocol_message message;
+
+    message.first = header.opcode;
+
+    switch (header.opcode)
+    {
+        case tick_message::OPCODE:
+        {
+            bin_tick_payload p = payload_cast<bin_tick_payload>(header, payload);
+            tick_message msg;
+
+            msg.instrument_id = validate_instrument_id(p.instrument_id);
+            msg.instrument    = get_instrument_name(msg.instrument_id);
+
+            if (p.ask == 0)
+            {
+                throw protocol_violation_error("Bad ASK value: 0");
+            }
+
+            if (! (p.bankroll >= 0.0))
+            {
+                throw protocol_violation_error(std::string("Bad bankroll value: ")
+                                               + boost::lexical_cast<std::string>(p.bankroll));
+            }
+
+            msg.request_time    = p.request_time;
+            msg.ask             = p.ask;
+            msg.bankroll        = p.bankroll;
+            msg.position_pips   = p.position_status;
+
+            message.second = msg;
+            break;
+        }
+        case historical_tick_message::OPCODE:
+        {
+            bin_historical_tick_payload p = payload_cast<bin_historical_tick_payload>(header, payload);
+            historical_tick_message msg;
+
+            msg.instrument_id = validate_instrument_id(p.instrument_id);
+            msg.instrument    = get_instrument_name(msg.instrument_id);
+
+            if (p.ask == 0)
+            {
+                throw protocol_violation_error("Bad ASK value: 0");
+            }
+
+            msg.ask = p.ask;
+
+            message.second = msg;
+            break;
+        }
+        case subscribe_instrument_message::OPCODE:
+        {
+            subscribe_instrument_message msg;
+            std::uint16_t instrument_id;
+
+            if (header.length == 0 || header.length % sizeof(std::uint16_t) != 0)
+            {
+                throw protocol_violation_error("Empty instrument set");
+            }
+
+            for (size_t i = 0; i < header.length; i += sizeof(std::uint16_t))
+            {
+                std::memcpy(&instrument_id, payload + i, sizeof(std::uint16_t));
+
+                msg.instruments.insert(get_instrument_name(validate_instrument_id(instrument_id)));
+            }
+
+            message.second = msg;
+            break;
+        }
+        case hci_setup_message::OPCODE:
+        {
+            bin_hci_setup_payload p = payload_cast<bin_hci_setup_payload>(header, payload);
+            hci_setup_message msg;
+
+            msg.instrument_id = validate_instrument_id(p.instrument_id);
+            msg.instrument    = get_instrument_name(msg.instrument_id);
+            msg.enable        = (p.enable != 0);
+
+            message.second = msg;
+            break;
+        }
+        default:
+            throw protocol_violation_error(std::string("Illegal code operation : ")
+                                           + boost::lexical_cast<std::string>(int(header.opcode)));
+    }
+
+    return message;
+}
+
+//
+// Handlers answer in text protocol, so translate
+// response to its binary counterpart.
+//
+
+void bin_encode_response(const std::string &text_response, std::string &out)
+{
+    static const struct
+    {
+        const char *text;
+        bin_response_code code;
+
+    } responses[] =
+    {
+        { "OK",    BIN_RESPONSE_OK    },
+        { "LONG",  BIN_RESPONSE_LONG  },
+        { "SHORT", BIN_RESPONSE_SHORT },
+        { "CLOSE", BIN_RESPONSE_CLOSE }
+    };
+
+    for (auto &r : responses)
+    {
+        if (text_response == r.text)
+        {
+            append_frame(r.code, nullptr, 0, out);
+
+            return;
+        }
+    }
+
+    //
+    // Anything else is an error, pass description
+    // without „ERROR;” prefix.
+    //
+
+    std::string description = text_response;
+
+    if (description.compare(0, 6, "ERROR;") == 0)
+    {
+        description.erase(0, 6);
+    }
+
+    if (description.length() > BIN_PROTO_MAX_PAYLOAD)
+    {
+        description.resize(BIN_PROTO_MAX_PAYLOAD);
+    }
+
+    append_frame(BIN_RESPONSE_ERROR, description.data(), description.length(), out);
+}
+
+void bin_encode_tick(const bin_tick_payload &tick, std::string &out)
+{
+    append_frame(tick_message::OPCODE, &tick, sizeof(tick), out);
+}
+
+void bin_encode_historical_tick(const bin_historical_tick_payload &tick, std::string &out)
+{
+    append_frame(historical_tick_message::OPCODE, &tick, sizeof(tick), out);
+}
+
+void bin_encode_subscribe(const std::vector<instrument_type> &instruments, std::string &out)
+{
+    std::vector<std::uint16_t> ids(instruments.begin(), instruments.end());
+
+    append_frame(subscribe_instrument_message::OPCODE, ids.data(), ids.size() * sizeof(std::uint16_t), out);
+}
+
+void bin_encode_hci_setup(const bin_hci_setup_payload &hci, std::string &out)
+{
+    append_frame(hci_setup_message::OPCODE, &hci, sizeof(hci), out);
+}
+
+std::string bin_decode_response(const bin_frame_header &header, const unsigned char *payload)
+{
+    switch (header.opcode)
+    {
+        case BIN_RESPONSE_OK:
+            return std::string("OK");
+        case BIN_RESPONSE_LONG:
+            return std::string("LONG");
+        case BIN_RESPONSE_SHORT:
+            return std::string("SHORT");
+        case BIN_RESPONSE_CLOSE:
+            return std::string("CLOSE");
+        case BIN_RESPONSE_ERROR:
+            return std::string("ERROR;") + std::string(reinterpret_cast<const char *>(payload), header.length);
+        default:
+            throw protocol_violation_error(std::string("Illegal response code : ")
+                                           + boost::lexical_cast<std::string>(int(header.opcode)));
+    }
+}
+
+instrument_type validate_instrument_id(std::uint16_t instrument_id)
+{
+    if (instrument_id >= get_instruments_number())
+    {
+        throw protocol_violation_error(std::string("Bad instrument id: ")
+                                       + boost::lexical_cast<std::string>(instrument_id));
+    }
+
+    return instrument_id;
+}
+
+void append_frame(std::uint8_t opcode, const void *payload, size_t length, std::string &out)
+{
+    bin_frame_header header;
+
+    header.length   = static_cast<std::uint16_t>(length);
+    header.opcode   = opcode;
+    header.reserved = 0;
+
+    out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    if (length > 0)
+    {
+        out.append(reinterpret_cast<const char *>(payload), length);
+    }
+}
+
+} /* namespace hft */
@@ -17,6 +17,9 @@
 #include <text_file_reader.hpp>
 
 #include <vector>
+#include <cmath>
+#include <array>
+#include <algorithm>
 
 #include <boost/program_options.hpp>
 #include <boost/tokenizer.hpp>
@@ -28,6 +31,17 @@ namespace prog_opts = boost::program_options;
 
 typedef std::vector<double> trade_yield_container;
 
+//
+// Number of alpha candidates evaluated together
+// during single pass over trade yields. Lanes are
+// kept in plain arrays so compiler is able to
+// vectorize inner loop.
+//
+
+#define OPTIMIZER_LANES 8
+
+typedef std::array<double, OPTIMIZER_LANES> lanes_type;
+
 static struct hft_dukascopy_optimizer_options_type
 {
     std::string filename;
@@ -35,6 +49,10 @@ static struct hft_dukascopy_optimizer_options_type
     double value_commission_1000;
     double pip_value_1000;
     double alpha_function;
+    std::string search_method;
+    double alpha_min;
+    double alpha_max;
+    double tolerance;
 
 } hft_dukascopy_optimizer_options;
 
@@ -108,6 +126,201 @@ static double overall_profit(const trade_yield_container &tyc, double alpha, boo
     return k;
 }
 
+//
+// Each trade changes bankroll by factor (1 + α·g), where
+// g = y·pip_value - 2·commission does not depend on α.
+// Factors are computed once and shared by all candidates.
+//
+
+static trade_yield_container growth_factors(const trade_yield_container &tyc)
+{
+    trade_yield_container ret;
+    ret.reserve(tyc.size());
+
+    for (auto y : tyc)
+    {
+        ret.push_back(y*hftOption(pip_value_1000) - 2.0*hftOption(value_commission_1000));
+    }
+
+    return ret;
+}
+
+//
+// Computes final bankroll for OPTIMIZER_LANES candidates
+// in single pass over growth factors. Candidate which went
+// bankrupt is frozen with its (non positive) bankroll and
+// the pass is stopped as soon as all candidates are ruined.
+// Alphas are expected already scaled (i.e. divided by 1000).
+//
+
+static lanes_type overall_profit_lanes(const trade_yield_container &gf, const lanes_type &alpha)
+{
+    lanes_type k;
+    lanes_type live;
+
+    k.fill(hftOption(bankroll));
+    live.fill(1.0);
+
+    const size_t block = 64;
+
+    for (size_t begin = 0; begin < gf.size(); begin += block)
+    {
+        size_t end = std::min(begin + block, gf.size());
+
+        for (size_t i = begin; i < end; i++)
+        {
+            const double g = gf[i];
+
+            for (int l = 0; l < OPTIMIZER_LANES; l++)
+            {
+                //
+                // Branch free update: ruined lane has live = 0.0
+                // and multiplies its bankroll by 1.0.
+                //
+
+                double nk = k[l] * (1.0 + live[l]*alpha[l]*g);
+                live[l] = (nk < 0.0) ? 0.0 : live[l];
+                k[l] = nk;
+            }
+        }
+
+        //
+        // Early termination on ruin checked per block.
+        //
+
+        double alive = 0.0;
+
+        for (int l = 0; l < OPTIMIZER_LANES; l++)
+        {
+            alive += live[l];
+        }
+
+        if (alive == 0.0)
+        {
+            break;
+        }
+    }
+
+    return k;
+}
+
+static void optimize_grid(const trade_yield_container &gf, double &best_alpha, double &best_yield)
+{
+    lanes_type alpha;
+    lanes_type yield;
+
+    best_yield = -10e7;
+    best_alpha = 0.0;
+
+    for (int i = 1; i < 1000; i += OPTIMIZER_LANES)
+    {
+        for (int l = 0; l < OPTIMIZER_LANES; l++)
+        {
+            //
+            // Lanes beyond the grid repeat its last point.
+            //
+
+            alpha[l] = static_cast<double>(std::min(i + l, 999)) / 100.0;
+        }
+
+        lanes_type scaled = alpha;
+
+        for (auto &a : scaled)
+        {
+            a /= 1000.0;
+        }
+
+        yield = overall_profit_lanes(gf, scaled);
+
+        for (int l = 0; l < OPTIMIZER_LANES; l++)
+        {
+            if (yield[l] > best_yield)
+            {
+                best_yield = yield[l];
+                best_alpha = alpha[l];
+            }
+        }
+    }
+}
+
+//
+// Section search over α ∈ [alpha_min, alpha_max], golden
+// section search generalized to all lanes. Kelly-style
+// growth is unimodal in α, so every pass evaluates
+// OPTIMIZER_LANES points spread evenly inside the bracket
+// and narrows it to neighbours of the best one, i.e. by
+// factor 2/(OPTIMIZER_LANES + 1), until it is shorter
+// than tolerance.
+//
+
+static void optimize_golden_section(const trade_yield_container &gf, double &best_alpha, double &best_yield)
+{
+    double a = hftOption(alpha_min);
+    double b = hftOption(alpha_max);
+
+    lanes_type alpha;
+    lanes_type yield;
+
+    best_alpha = (a + b) / 2.0;
+    best_yield = -10e7;
+
+    unsigned int iterations = 0;
+
+    while (b - a > hftOption(tolerance))
+    {
+        const double step = (b - a) / (OPTIMIZER_LANES + 1);
+
+        for (int l = 0; l < OPTIMIZER_LANES; l++)
+        {
+            alpha[l] = (a + (l + 1)*step) / 1000.0;
+        }
+
+        yield = overall_profit_lanes(gf, alpha);
+
+        int best = 0;
+
+        for (int l = 1; l < OPTIMIZER_LANES; l++)
+        {
+            if (yield[l] > yield[best])
+            {
+                best = l;
+            }
+        }
+
+        if (yield[best] > best_yield)
+        {
+            best_yield = yield[best];
+            best_alpha = alpha[best] * 1000.0;
+        }
+
+        //
+        // Maximum lies between neighbours of the best
+        // point (bracket ends for the outer lanes).
+        //
+
+        double new_a = a + best*step;
+        double new_b = a + (best + 2)*step;
+
+        a = new_a;
+        b = new_b;
+
+        iterations++;
+    }
+
+    alpha.fill((a + b) / 2.0 / 1000.0);
+
+    double mid_yield = overall_profit_lanes(gf, alpha)[0];
+
+    if (mid_yield >= best_yield)
+    {
+        best_alpha = (a + b) / 2.0;
+        best_yield = mid_yield;
+    }
+
+    hft_log(INFO) << "Golden section search finished after ["
+                  << iterations << "] iterations.";
+}
+
 int hft_dukascopy_optimizer_main(int argc, char *argv[])
 {
     //
@@ -143,6 +356,10 @@ int hft_dukascopy_optimizer_main(int argc, char *argv[])
         ("value-commission-1000,c", prog_opts::value<double>(&hftOption(value_commission_1000)), "Value commision for amount 1000 currency units")
         ("pip-value-1000,p", prog_opts::value<double>(&hftOption(pip_value_1000)), "Pips limit for amount 1000 currency units")
         ("alpha-function,a", prog_opts::value<double>(&hftOption(alpha_function)) -> default_value(-1.0), "Alpha function parameter. If negative, parameter will be optimized")
+        ("search-method,s", prog_opts::value<std::string>(&hftOption(search_method)) -> default_value("grid"), "Alpha optimization method. Available are ‘grid’ (fixed grid 0.01 … 9.99) or ‘golden’ (section search narrowing bracket around the best of parallel evaluated points)")
+        ("alpha-min,m", prog_opts::value<double>(&hftOption(alpha_min)) -> default_value(0.01), "Lower bound of alpha for golden section search")
+        ("alpha-max,M", prog_opts::value<double>(&hftOption(alpha_max)) -> default_value(9.99), "Upper bound of alpha for golden section search")
+        ("tolerance,t", prog_opts::value<double>(&hftOption(tolerance)) -> default_value(0.0001), "Alpha tolerance for golden section search")
     ;
 
     prog_opts::options_description cmdline_options;
@@ -187,24 +404,42 @@ int hft_dukascopy_optimizer_main(int argc, char *argv[])
         // Optimization.
         //
 
-        double best_yield = -10e7;
-        double best_alpha = 0.0;
-        double alpha;
-        double yield;
+        double best_yield;
+        double best_alpha;
+
+        trade_yield_container factors = growth_factors(trade_yields);
 
         hft_log(INFO) << "Optimizing...";
 
-        for (int i = 1; i < 1000; i++)
+        if (hftOption(search_method) == "grid")
         {
-            alpha = static_cast<double>(i) / 100.0;
+            optimize_grid(factors, best_alpha, best_yield);
+        }
+        else if (hftOption(search_method) == "golden")
+        {
+            if (hftOption(alpha_min) <= 0.0 || hftOption(alpha_min) >= hftOption(alpha_max))
+            {
+                hft_log(ERROR) << "Invalid alpha range [" << hftOption(alpha_min)
+                               << ", " << hftOption(alpha_max) << "]";
 
-            yield = overall_profit(trade_yields, alpha / 1000.0, true);
+                return 1;
+            }
 
-            if (yield > best_yield)
+            if (hftOption(tolerance) <= 0.0)
             {
-                best_yield = yield;
-                best_alpha = alpha;
+                hft_log(ERROR) << "Tolerance must be greater than 0";
+
+                return 1;
             }
+
+            optimize_golden_section(factors, best_alpha, best_yield);
+        }
+        else
+        {
+            hft_log(ERROR) << "Unrecognized search method ‘"
+                           << hftOption(search_method) << "’";
+
+            return 1;
         }
 
         hft_log(INFO) << "Bankroll after investition: " << overall_profit(trade_yields, best_alpha / 1000.0);
@@ -14,6 +14,8 @@
 **                                                                    **
 \**********************************************************************/
 
+#include <cmath>
+
 #include <boost/tokenizer.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -166,21 +168,13 @@ tick_message parse_tick_message(token_iterator begin, token_iterator end)
     hft::instrument_type itype = validate_instrument(instrument);
 
     msg.instrument = instrument;
+    msg.instrument_id = itype;
 
     //
     // Data validation for request date/time.
     //
 
-    try
-    {
-        msg.request_time = boost::posix_time::ptime(boost::posix_time::time_from_string(request_time));
-    }
-    catch (const std::exception &e)
-    {
-        throw protocol_violation_error(std::string("Bad request time: ") + request_time);
-    }
-
-    if (msg.request_time.is_not_a_date_time())
+    if (! hft::datetime_str_to_epoch_usec(request_time, msg.request_time))
     {
         throw protocol_violation_error(std::string("Bad request time: ") + request_time);
     }
@@ -222,6 +216,7 @@ tick_message parse_tick_message(token_iterator begin, token_iterator end)
 /*TODO: */
 
     msg.position_status = position_status;
+    msg.position_pips = std::nan("");
 
     return msg;
 }
@@ -261,6 +256,7 @@ historical_tick_message parse_historical_tick_message(token_iterator begin, toke
     validate_ask(ask);
 
     msg.instrument = instrument;
+    msg.instrument_id = itype;
     msg.ask = hft::floating2dpips(ask, itype);
 
     return msg;
@@ -301,9 +297,8 @@ hci_setup_message parse_hci_setup_message(token_iterator begin, token_iterator e
     // Validation.
     //
 
-    validate_instrument(instrument);
-
     msg.instrument = instrument;
+    msg.instrument_id = validate_instrument(instrument);
 
     if (hci_option == "hci_on")
     {
@@ -20,7 +20,9 @@
 #include <marketplace_gateway_process.hpp>
 #include <hft_session.hpp>
 #include <basic_tcp_server.hpp>
+#include <basic_shm_server.hpp>
 #include <auto_deallocator.hpp>
+#include <request_journal.hpp>
 #include "../caans/include/caans_client.hpp"
 
 #include <boost/asio.hpp>
@@ -31,6 +33,13 @@
 
 namespace prog_opts = boost::program_options;
 
+class hft_shm_server : public basic_shm_server<hft_session>
+{
+public:
+
+    using basic_shm_server<hft_session>::basic_shm_server;
+};
+
 class hft_server : public basic_tcp_server<hft_session>
 {
 public:
@@ -62,6 +71,38 @@ static struct hft_server_options_type
 
 static std::unique_ptr<daemon_process> server_daemon;
 
+//
+// Options of hftd.conf. Shared with tools running
+// sessions in-process, like replay.
+//
+
+void hft_server_config_options(prog_opts::options_description &server_config_desc)
+{
+    server_config_desc.add_options()
+        ("general.caans_integration_enabled", prog_opts::value<bool>() -> default_value(false))
+        ("networking.tcp_enabled", prog_opts::value<bool>() -> default_value(true))
+        ("networking.listen_port", prog_opts::value<short>() -> default_value(8137))
+        ("networking.unix_socket", prog_opts::value<std::string>() -> default_value(""))
+        ("networking.shm_channels", prog_opts::value<std::string>() -> default_value(""))
+        ("journal.enabled", prog_opts::value<bool>() -> default_value(false))
+        ("journal.file", prog_opts::value<std::string>() -> default_value("/var/log/hft/requests.journal"))
+        ("handlers.enable_cache", prog_opts::value<bool>() -> default_value(false))
+        ("handlers.prolong_position_to_next_setup", prog_opts::value<bool>() -> default_value(false))
+        ("handlers.trade_positive_swaps_only", prog_opts::value<bool>() -> default_value(false))
+        ("marketplace.enabled", prog_opts::value<bool>() -> default_value(false))
+        ("marketplace.bridges_config", prog_opts::value<std::string>() -> default_value(""))
+        ("trade_time_frame.enabled", prog_opts::value<bool>() -> default_value(false))
+        ("trade_time_frame.Mon", prog_opts::value<std::string>() -> default_value("00:00:00.000-23:59:59.999"))
+        ("trade_time_frame.Tue", prog_opts::value<std::string>() -> default_value("00:00:00.000-23:59:59.999"))
+        ("trade_time_frame.Wed", prog_opts::value<std::string>() -> default_value("00:00:00.000-23:59:59.999"))
+        ("trade_time_frame.Thu", prog_opts::value<std::string>() -> default_value("00:00:00.000-23:59:59.999"))
+        ("trade_time_frame.Fri", prog_opts::value<std::string>() -> default_value("00:00:00.000-23:59:59.999"))
+        ("trade_time_frame.Sat", prog_opts::value<std::string>() -> default_value(""))
+        ("trade_time_frame.Sun", prog_opts::value<std::string>() -> default_value(""))
+        ("trade_time_frame.holidays", prog_opts::value<std::string>() -> default_value(""))
+    ;
+}
+
 int hft_server_main(int argc, char *argv[])
 {
     //
@@ -141,21 +182,7 @@ int hft_server_main(int argc, char *argv[])
 
     prog_opts::variables_map server_config;
     prog_opts::options_description server_config_desc;
-    server_config_desc.add_options()
-        ("general.caans_integration_enabled", prog_opts::value<bool>() -> default_value(false))
-        ("networking.listen_port", prog_opts::value<short>() -> default_value(8137))
-        ("handlers.enable_cache", prog_opts::value<bool>() -> default_value(false))
-        ("handlers.prolong_position_to_next_setup", prog_opts::value<bool>() -> default_value(false))
-        ("handlers.trade_positive_swaps_only", prog_opts::value<bool>() -> default_value(false))
-        ("marketplace.enabled", prog_opts::value<bool>() -> default_value(false))
-        ("marketplace.bridges_config", prog_opts::value<std::string>() -> default_value(""))
-        ("trade_time_frame.enabled", prog_opts::value<bool>() -> default_value(false))
-        ("trade_time_frame.Mon", prog_opts::value<std::string>() -> default_value("0:00:00,00-23:59:59,99"))
-        ("trade_time_frame.Tue", prog_opts::value<std::string>() -> default_value("0:00:00,00-23:59:59,99"))
-        ("trade_time_frame.Wed", prog_opts::value<std::string>() -> default_value("0:00:00,00-23:59:59,99"))
-        ("trade_time_frame.Thu", prog_opts::value<std::string>() -> default_value("0:00:00,00-23:59:59,99"))
-        ("trade_time_frame.Fri", prog_opts::value<std::string>() -> default_value("0:00:00,00-23:59:59,99"))
-    ;
+    hft_server_config_options(server_config_desc);
     prog_opts::store(prog_opts::parse_config_file<char>(hftOption(config_file_name).c_str(), server_config_desc), server_config);
     prog_opts::notify(server_config);
 
@@ -187,6 +214,18 @@ int hft_server_main(int argc, char *argv[])
 
     try
     {
+        //
+        // Optional journal of all requests, for replay.
+        //
+
+        std::unique_ptr<request_journal> journal;
+
+        if (server_config["journal.enabled"].as<bool>())
+        {
+            journal.reset(new request_journal(server_config["journal.file"].as<std::string>()));
+            session_transport::attach_journal(journal.get());
+        }
+
         if (server_config["marketplace.enabled"].as<bool>())
         {
             //
@@ -198,6 +237,7 @@ int hft_server_main(int argc, char *argv[])
 
             marketplace_gateway_process gateway_process(ioctx, server_config);
             hft_server server(ioctx, server_config);
+            hft_shm_server shm_server(ioctx, server_config);
 
             if (hftOption(start_as_daemon))
             {
@@ -217,6 +257,7 @@ int hft_server_main(int argc, char *argv[])
             //
 
             hft_server server(ioctx, server_config);
+            hft_shm_server shm_server(ioctx, server_config);
 
             if (hftOption(start_as_daemon))
             {
@@ -229,6 +270,8 @@ int hft_server_main(int argc, char *argv[])
 
             ioctx.run();
         }
+
+        session_transport::attach_journal(nullptr);
     }
     catch (const std::exception &e)
     {
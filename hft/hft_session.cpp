@@ -14,8 +14,6 @@
 **                                                                    **
 \**********************************************************************/
 
-#include <boost/algorithm/string.hpp>
-
 #include <hft_session.hpp>
 
 #define hft_log(__X__) \
@@ -30,7 +28,8 @@
 hft_session::hft_session(boost::asio::io_service &io_service,
                              const boost::program_options::variables_map &config)
     : session_transport(io_service, config),
-      config_(config)
+      config_(config),
+      instrument_handlers_(hft::get_instruments_number())
 {
     el::Loggers::getLogger("session", true);
 }
@@ -45,13 +44,11 @@ hft_session::~hft_session(void)
 void hft_session::tick_notify(const hft::tick_message &msg,
                                   std::ostringstream &response)
 {
-    std::string instrument_format2 = boost::erase_all_copy(msg.instrument, "/");
-
     #ifdef HFT_DEBUG
     hft_log(DEBUG) << "Received tick notify :  Instrument ["
                    << msg.instrument << "], ask [" << msg.ask
                    << "], bankroll [" << msg.bankroll
-                   << "], position status [" << msg.position_status
+                   << "], position status [" << (msg.position_status.empty() ? boost::lexical_cast<std::string>(msg.position_pips) : msg.position_status)
                    << "].";
     #endif
 
@@ -59,9 +56,9 @@ void hft_session::tick_notify(const hft::tick_message &msg,
     // Find appropriate instrument handler, then dispatch notify to it.
     //
 
-    auto it = instrument_handlers_.find(instrument_format2);
+    instrument_handler *handler = find_handler(msg.instrument_id);
 
-    if (it == instrument_handlers_.end())
+    if (handler == nullptr)
     {
         response << "ERROR;Unsubscribed handler for instrument "
                  << msg.instrument;
@@ -69,14 +66,12 @@ void hft_session::tick_notify(const hft::tick_message &msg,
         return;
     }
 
-    it -> second -> on_tick(msg, response);
+    handler -> on_tick(msg, response);
 }
 
 void hft_session::historical_tick_notify(const hft::historical_tick_message &msg,
                                              std::ostringstream &response)
 {
-    std::string instrument_format2 = boost::erase_all_copy(msg.instrument, "/");
-
     #ifdef HFT_DEBUG
     hft_log(DEBUG) << "Received historical tick notify :  Instrument ["
                    << msg.instrument << "], ask [" << msg.ask
@@ -87,9 +82,9 @@ void hft_session::historical_tick_notify(const hft::historical_tick_message &msg
     // Find appropriate instrument handler, then dispatch notify to it.
     //
 
-    auto it = instrument_handlers_.find(instrument_format2);
+    instrument_handler *handler = find_handler(msg.instrument_id);
 
-    if (it == instrument_handlers_.end())
+    if (handler == nullptr)
     {
         response << "ERROR;Unsubscribed handler for instrument "
                  << msg.instrument;
@@ -97,29 +92,34 @@ void hft_session::historical_tick_notify(const hft::historical_tick_message &msg
         return;
     }
 
-    it -> second -> on_historical_tick(msg, response);
+    handler -> on_historical_tick(msg, response);
 
 }
 
 void hft_session::subscribe_notify(const hft::subscribe_instrument_message &msg,
                                        std::ostringstream &response)
 {
-    std::string instrument_format2;
-
     for (auto &instrument : msg.instruments)
     {
-        instrument_format2 = boost::erase_all_copy(instrument, "/");
+        hft::instrument_type instrument_id = hft::instrument2type(instrument);
+
+        if (instrument_id == hft::UNRECOGNIZED_INSTRUMENT)
+        {
+            hft_log(ERROR) << "Unrecognized instrument [" << instrument << "]";
+
+            continue;
+        }
 
-        if (instrument_handlers_.find(instrument_format2) == instrument_handlers_.end())
+        std::string instrument_format2 = hft::get_instrument_name(instrument_id);
+
+        if (find_handler(instrument_id) == nullptr)
         {
             hft_log(INFO) << "Creating handler for instrument ["
                           << instrument_format2 << "]";
 
             try
             {
-                std::shared_ptr<instrument_handler> handler;
-                handler.reset(new instrument_handler(config_, instrument_format2));
-                instrument_handlers_.insert(std::pair<std::string, std::shared_ptr<instrument_handler> >(instrument_format2, handler));
+                instrument_handlers_.at(instrument_id).reset(new instrument_handler(config_, instrument_format2));
             }
             catch (std::exception &e)
             {
@@ -140,8 +140,6 @@ void hft_session::subscribe_notify(const hft::subscribe_instrument_message &msg,
 void hft_session::hci_setup_notify(const hft::hci_setup_message &msg,
                                        std::ostringstream &response)
 {
-    std::string instrument_format2 = boost::erase_all_copy(msg.instrument, "/");
-
     #ifdef HFT_DEBUG
     hft_log(DEBUG) << "Received HCI setup notify :  Instrument ["
                    << msg.instrument << "], option ["
@@ -153,9 +151,9 @@ void hft_session::hci_setup_notify(const hft::hci_setup_message &msg,
     // Find appropriate instrument handler, then dispatch notify to it.
     //
 
-    auto it = instrument_handlers_.find(instrument_format2);
+    instrument_handler *handler = find_handler(msg.instrument_id);
 
-    if (it == instrument_handlers_.end())
+    if (handler == nullptr)
     {
         response << "ERROR;Unsubscribed handler for instrument "
                  << msg.instrument;
@@ -163,5 +161,5 @@ void hft_session::hci_setup_notify(const hft::hci_setup_message &msg,
         return;
     }
 
-    it -> second -> on_hci_setup(msg, response);
+    handler -> on_hci_setup(msg, response);
 }
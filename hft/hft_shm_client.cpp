@@ -0,0 +1,289 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <string>
+#include <new>
+#include <cerrno>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <hft_shm_ring.hpp>
+#include <hft_shm_client.h>
+
+struct hft_shm_client
+{
+    int fd;
+    hft::shm::region *region;
+
+    //
+    // Set when response didn't come in time. Late response
+    // would be taken as answer to the next request, so the
+    // client has to reconnect.
+    //
+
+    bool broken;
+};
+
+static thread_local std::string last_error;
+
+static int fail(const std::string &message)
+{
+    last_error = message;
+
+    return -1;
+}
+
+static void ring_doorbell(hft::shm::ring &r)
+{
+    r.doorbell.fetch_add(1, std::memory_order_seq_cst);
+    hft::shm::futex_wake(&r.doorbell);
+}
+
+static long elapsed_ms(const std::chrono::steady_clock::time_point &since)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - since).count();
+}
+
+static void detach(int fd, hft::shm::region *region)
+{
+    region -> state.store(hft::shm::CLOSING);
+    ring_doorbell(region -> requests);
+
+    munmap(region, sizeof(hft::shm::region));
+    close(fd);
+}
+
+static bool is_connected(const hft_shm_client *client)
+{
+    return client -> region -> state.load(std::memory_order_acquire) == hft::shm::CONNECTED;
+}
+
+extern "C" hft_shm_client *hft_shm_connect(const char *channel, int timeout_ms)
+{
+    struct stat st;
+    int fd = shm_open(channel, O_RDWR, 0);
+
+    if (fd < 0)
+    {
+        fail(std::string("Unable to open channel ") + channel + ": " + strerror(errno));
+
+        return nullptr;
+    }
+
+    if (fstat(fd, &st) < 0 || size_t(st.st_size) < sizeof(hft::shm::region))
+    {
+        close(fd);
+        fail(std::string("Channel ") + channel + " has invalid size");
+
+        return nullptr;
+    }
+
+    void *addr = mmap(nullptr, sizeof(hft::shm::region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (addr == MAP_FAILED)
+    {
+        close(fd);
+        fail(std::string("Unable to map channel ") + channel + ": " + strerror(errno));
+
+        return nullptr;
+    }
+
+    hft::shm::region *region = static_cast<hft::shm::region *>(addr);
+
+    if (region -> magic != hft::shm::REGION_MAGIC || region -> version != hft::shm::REGION_VERSION)
+    {
+        munmap(addr, sizeof(hft::shm::region));
+        close(fd);
+        fail(std::string("Channel ") + channel + " has incompatible layout");
+
+        return nullptr;
+    }
+
+    //
+    // Only one client at a time, rings are single producer
+    // and single consumer.
+    //
+
+    std::uint32_t expected = hft::shm::FREE;
+
+    if (! region -> state.compare_exchange_strong(expected, hft::shm::ATTACHING))
+    {
+        munmap(addr, sizeof(hft::shm::region));
+        close(fd);
+        fail(std::string("Channel ") + channel + " is busy");
+
+        return nullptr;
+    }
+
+    region -> client_pid.store(getpid());
+    ring_doorbell(region -> requests);
+
+    //
+    // Wait until server resets rings and creates session.
+    //
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (region -> state.load() == hft::shm::ATTACHING && elapsed_ms(start) < timeout_ms)
+    {
+        hft::shm::futex_wait(&region -> state, hft::shm::ATTACHING, 10);
+    }
+
+    if (region -> state.load() != hft::shm::CONNECTED)
+    {
+        //
+        // Pid is cleared first, once the channel is free
+        // next client may already be storing its own.
+        //
+
+        region -> client_pid.store(0);
+        expected = hft::shm::ATTACHING;
+
+        if (! region -> state.compare_exchange_strong(expected, hft::shm::FREE) && expected == hft::shm::CONNECTED)
+        {
+            //
+            // Server connected us just after the timeout,
+            // detach properly instead of leaking the channel.
+            //
+
+            detach(fd, region);
+            fail(std::string("Server does not serve channel ") + channel);
+
+            return nullptr;
+        }
+
+        munmap(addr, sizeof(hft::shm::region));
+        close(fd);
+        fail(std::string("Server does not serve channel ") + channel);
+
+        return nullptr;
+    }
+
+    hft_shm_client *client = new (std::nothrow) hft_shm_client;
+
+    if (client == nullptr)
+    {
+        detach(fd, region);
+        fail("Out of memory");
+
+        return nullptr;
+    }
+
+    client -> fd = fd;
+    client -> region = region;
+    client -> broken = false;
+
+    return client;
+}
+
+extern "C" void hft_shm_disconnect(hft_shm_client *client)
+{
+    if (client == nullptr)
+    {
+        return;
+    }
+
+    detach(client -> fd, client -> region);
+
+    delete client;
+}
+
+extern "C" int hft_shm_send(hft_shm_client *client, const void *frame, size_t length, int timeout_ms)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (client -> broken)
+    {
+        return fail("Connection broken by previous response timeout, reconnect");
+    }
+
+    if (length > hft::shm::RING_CAPACITY / 2)
+    {
+        return fail("Frame too long");
+    }
+
+    while (! client -> region -> requests.push(frame, static_cast<std::uint32_t>(length)))
+    {
+        if (! is_connected(client))
+        {
+            return fail("Disconnected by server");
+        }
+
+        if (elapsed_ms(start) >= timeout_ms)
+        {
+            return fail("Timeout while sending request");
+        }
+
+        hft::shm::cpu_relax();
+    }
+
+    return 0;
+}
+
+extern "C" long hft_shm_receive(hft_shm_client *client, void *frame, size_t capacity, int timeout_ms)
+{
+    auto start = std::chrono::steady_clock::now();
+    long length;
+
+    if (client -> broken)
+    {
+        return fail("Connection broken by previous response timeout, reconnect");
+    }
+
+    while ((length = client -> region -> responses.pop(frame, capacity)) == 0)
+    {
+        if (! is_connected(client))
+        {
+            return fail("Disconnected by server");
+        }
+
+        if (elapsed_ms(start) >= timeout_ms)
+        {
+            client -> broken = true;
+
+            return fail("Timeout while waiting for response");
+        }
+
+        client -> region -> responses.wait(std::min(timeout_ms, 100));
+    }
+
+    if (length < 0)
+    {
+        return fail("Response does not fit in buffer");
+    }
+
+    return length;
+}
+
+extern "C" long hft_shm_request(hft_shm_client *client, const void *request, size_t length,
+                                void *response, size_t capacity, int timeout_ms)
+{
+    if (hft_shm_send(client, request, length, timeout_ms) < 0)
+    {
+        return -1;
+    }
+
+    return hft_shm_receive(client, response, capacity, timeout_ms);
+}
+
+extern "C" const char *hft_shm_last_error(void)
+{
+    return last_error.c_str();
+}
@@ -19,12 +19,14 @@
 #include <cstdio>
 #include <ctime>
 #include <stdexcept>
+#include <chrono>
 
 #include <boost/lexical_cast.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
 
 namespace hft {
 
-static struct instrument_info_type
+static constexpr struct instrument_info_type
 {
     const char *identifiers[4];
     char dpips_transform;
@@ -102,24 +104,117 @@ static struct instrument_info_type
 
 #define IISIZE (sizeof(instrument_info) / sizeof(instrument_info_type))
 
-instrument_type instrument2type(const std::string &instrstr)
+//
+// Perfect hash of all instrument identifiers, built at compile time.
+// Seed of FNV-1a is searched until no two identifiers share a slot,
+// so lookup is one hash, one slot read and one string compare
+// regardless of the number of instruments.
+//
+
+#define IIHASH_SIZE 2048
+#define IIHASH_EMPTY 0xFFFF
+
+static_assert(IISIZE < 0xFF, "Instrument type must fit in hash slot");
+
+struct instrument_hash_type
+{
+    std::uint32_t seed;
+    std::uint16_t slots[IIHASH_SIZE];
+};
+
+static constexpr std::uint32_t instrument_hash(std::uint32_t seed, const char *data, size_t length)
+{
+    std::uint32_t h = 2166136261u ^ seed;
+
+    for (size_t i = 0; i < length; i++)
+    {
+        h = (h ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+
+    return (h ^ (h >> 15)) & (IIHASH_SIZE - 1);
+}
+
+static constexpr size_t constexpr_strlen(const char *data)
+{
+    size_t length = 0;
+
+    while (data[length] != 0)
+    {
+        length++;
+    }
+
+    return length;
+}
+
+static constexpr instrument_hash_type build_instrument_hash(void)
 {
-    for (unsigned int i = 0; i < IISIZE; i++)
+    instrument_hash_type ret {};
+
+    for (std::uint32_t seed = 1; ; seed++)
     {
-        for (unsigned int j = 0; j < 4; j++)
+        bool perfect = true;
+
+        for (unsigned int k = 0; k < IIHASH_SIZE; k++)
         {
-            if (instrument_info[i].identifiers[j] == nullptr)
-            {
-                break;
-            }
-            else if (instrstr == instrument_info[i].identifiers[j])
+            ret.slots[k] = IIHASH_EMPTY;
+        }
+
+        for (unsigned int i = 0; i < IISIZE && perfect; i++)
+        {
+            for (unsigned int j = 0; j < 4 && instrument_info[i].identifiers[j] != nullptr; j++)
             {
-                return i;
+                const char *id = instrument_info[i].identifiers[j];
+                std::uint32_t slot = instrument_hash(seed, id, constexpr_strlen(id));
+
+                if (ret.slots[slot] != IIHASH_EMPTY)
+                {
+                    perfect = false;
+                    break;
+                }
+
+                //
+                // Slot keeps both instrument and identifier index
+                // to verify the match without scanning aliases.
+                //
+
+                ret.slots[slot] = static_cast<std::uint16_t>((i << 8) | j);
             }
         }
+
+        if (perfect)
+        {
+            ret.seed = seed;
+
+            return ret;
+        }
+    }
+}
+
+static constexpr instrument_hash_type instrument_hash_table = build_instrument_hash();
+
+instrument_type instrument2type(const std::string &instrstr)
+{
+    std::uint32_t slot = instrument_hash(instrument_hash_table.seed, instrstr.data(), instrstr.length());
+    std::uint16_t entry = instrument_hash_table.slots[slot];
+
+    if (entry == IIHASH_EMPTY)
+    {
+        return UNRECOGNIZED_INSTRUMENT;
     }
 
-    return UNRECOGNIZED_INSTRUMENT;
+    instrument_type t = entry >> 8;
+
+    if (instrstr.compare(instrument_info[t].identifiers[entry & 0xFF]) != 0)
+    {
+        return UNRECOGNIZED_INSTRUMENT;
+    }
+
+    return t;
+}
+
+unsigned int get_instruments_number(void)
+{
+    return IISIZE;
 }
 
 const char *get_instrument_description(instrument_type t)
@@ -127,6 +222,11 @@ const char *get_instrument_description(instrument_type t)
     return ((t < IISIZE) ? instrument_info[t].description : nullptr);
 }
 
+const char *get_instrument_name(instrument_type t)
+{
+    return ((t < IISIZE) ? instrument_info[t].identifiers[0] : nullptr);
+}
+
 static char instrument_type2transform_exp(instrument_type t)
 {
     return ((t < IISIZE) ? instrument_info[t].dpips_transform : 0);
@@ -166,6 +266,31 @@ unsigned int floating2dpips(const std::string &data, instrument_type t)
     return boost::lexical_cast<unsigned int>(buffer);
 }
 
+//
+// Inverse of floating2dpips, e.g. 110031 → „1.10031” for EURUSD.
+//
+
+std::string dpips2floating(unsigned int dpips, instrument_type t)
+{
+    int decimals = instrument_type2transform_exp(t) - '0';
+    unsigned int scale = 1;
+
+    if (decimals <= 0 || decimals > 9)
+    {
+        return std::to_string(dpips);
+    }
+
+    for (int i = 0; i < decimals; i++)
+    {
+        scale *= 10;
+    }
+
+    std::string fraction = std::to_string(dpips % scale);
+
+    return std::to_string(dpips / scale) + std::string(".")
+           + std::string(decimals - fraction.length(), '0') + fraction;
+}
+
 std::string timestamp_to_datetime_str(long timestamp)
 {
     const time_t rawtime = (const time_t) timestamp;
@@ -182,5 +307,149 @@ std::string timestamp_to_datetime_str(long timestamp)
     return std::string(buffer);
 }
 
+//
+// Days since epoch for proleptic Gregorian date (H. Hinnant's
+// days_from_civil), valid for any year in the protocol range.
+//
+
+static std::int64_t days_from_civil(int y, unsigned m, unsigned d)
+{
+    y -= m <= 2;
+
+    const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+
+    return era * 146097 + static_cast<std::int64_t>(doe) - 719468;
+}
+
+static inline bool fixed_digits(const char *p, int n, int &out)
+{
+    out = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (p[i] < '0' || p[i] > '9')
+        {
+            return false;
+        }
+
+        out = out * 10 + (p[i] - '0');
+    }
+
+    return true;
+}
+
+//
+// Fast path for fixed layout „YYYY-MM-DD HH:MM:SS[.ffffff]”
+// which is what all clients send. Anything else falls back
+// to boost parser.
+//
+
+static bool fixed_layout_to_epoch_usec(const std::string &data, epoch_usec_type &out)
+{
+    static const unsigned char days_in_month[] = { 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+    const char *p = data.c_str();
+    size_t length = data.length();
+    int year, month, day, hour, minute, second;
+
+    if (length < 19
+            || p[4] != '-' || p[7] != '-' || (p[10] != ' ' && p[10] != 'T')
+            || p[13] != ':' || p[16] != ':')
+    {
+        return false;
+    }
+
+    if (! fixed_digits(p, 4, year)
+            || ! fixed_digits(p + 5, 2, month)
+            || ! fixed_digits(p + 8, 2, day)
+            || ! fixed_digits(p + 11, 2, hour)
+            || ! fixed_digits(p + 14, 2, minute)
+            || ! fixed_digits(p + 17, 2, second))
+    {
+        return false;
+    }
+
+    if (month < 1 || month > 12 || day < 1 || day > days_in_month[month - 1]
+            || hour > 23 || minute > 59 || second > 59)
+    {
+        return false;
+    }
+
+    if (month == 2 && day == 29 && ! (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0)))
+    {
+        return false;
+    }
+
+    epoch_usec_type usec = 0;
+
+    if (length > 19)
+    {
+        if ((p[19] != '.' && p[19] != ',') || length == 20)
+        {
+            return false;
+        }
+
+        epoch_usec_type scale = 100000;
+
+        for (size_t i = 20; i < length; i++)
+        {
+            if (p[i] < '0' || p[i] > '9')
+            {
+                return false;
+            }
+
+            usec  += (p[i] - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    out = days_from_civil(year, month, day) * USEC_PER_DAY
+            + (hour * 3600LL + minute * 60LL + second) * USEC_PER_SECOND
+            + usec;
+
+    return true;
+}
+
+bool datetime_str_to_epoch_usec(const std::string &data, epoch_usec_type &out)
+{
+    if (fixed_layout_to_epoch_usec(data, out))
+    {
+        return true;
+    }
+
+    try
+    {
+        static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+        boost::posix_time::ptime t = boost::posix_time::time_from_string(data);
+
+        if (t.is_special())
+        {
+            return false;
+        }
+
+        out = (t - epoch).total_microseconds();
+    }
+    catch (const std::exception &e)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+std::string epoch_usec_to_datetime_str(epoch_usec_type timestamp)
+{
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+    return boost::posix_time::to_iso_extended_string(epoch + boost::posix_time::microseconds(timestamp));
+}
+
+epoch_usec_type epoch_usec_now(void)
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
 
 } /* namespace hft */
@@ -0,0 +1,63 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <hftr_samples.hpp>
+
+void hftr_samples::append(const hftr &h)
+{
+    if (inputs_ == 0)
+    {
+        inputs_ = h.get_size();
+    }
+    else if (inputs_ != h.get_size())
+    {
+        throw exception("Bad HFTR, inconsistent input size");
+    }
+
+    switch (h.get_output())
+    {
+        case hftr::INCREASE:
+            expected_.push_back(1.0);
+            break;
+        case hftr::DECREASE:
+            expected_.push_back(-1.0);
+            break;
+        default:
+            throw exception("Bad HFTR, unrecognized output");
+    }
+
+    for (size_t i = 0; i < inputs_; i++)
+    {
+        pins_.push_back(h.get_pin(i));
+    }
+}
+
+size_t hftr_samples::load(text_file_reader &reader, size_t max)
+{
+    std::string line;
+    size_t n = 0;
+    hftr h;
+
+    while ((max == 0 || n < max) && reader.read_line(line))
+    {
+        h.clear();
+        h.import_from_text_line(line);
+        append(h);
+        n++;
+    }
+
+    return n;
+}
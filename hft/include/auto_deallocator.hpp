@@ -18,6 +18,7 @@
 #define __AUTO_DEALLOCATOR_HPP__
 
 #include <set>
+#include <mutex>
 
 class auto_deallocator
 {
@@ -44,6 +45,7 @@ private:
     private:
 
        std::set<void *> registered_;
+       std::mutex mutex_;
     };
 
     static resource records_;
@@ -22,6 +22,7 @@
 #include <mdc.hpp>
 #include <granularity_counter.hpp>
 #include <neural_network.hpp>
+#include <quantized_network.hpp>
 #include <hftr.hpp>
 #include <easylogging++.h>
 
@@ -79,10 +80,39 @@ public:
     // Dodanie sieci neuronowej do układu.
     // Podawana jest architektura warstw ukrytych.
     // Metoda zwraca numer ID dla nowododanej
-    // sieci neuronowej.
+    // sieci neuronowej. „acc” - accuracy of activate
+    // functions of the network, „rng” - optional
+    // generator for initial weights.
     //
 
-    unsigned int add_neural_network(const neural_network::layers_architecture &la);
+    unsigned int add_neural_network(const neural_network::layers_architecture &la,
+                                    hft::activation_accuracy acc = hft::ACTIVATION_EXACT,
+                                    std::mt19937 *rng = nullptr);
+
+    //
+    // Creates standalone network of the same shape as
+    // „add_neural_network” does, not attached to the system.
+    //
+
+    static std::shared_ptr<neural_network> create_neural_network(const neural_network::layers_architecture &la,
+                                                                 hft::activation_accuracy acc = hft::ACTIVATION_EXACT,
+                                                                 std::mt19937 *rng = nullptr);
+
+    //
+    // Replaces network of given ID with another one
+    // of the same architecture. Input bus is invalidated.
+    //
+
+    void replace_neural_network(unsigned int nid, std::shared_ptr<neural_network> net);
+
+    //
+    // Network of given ID is evaluated by its quantized copy
+    // until detached (null pointer) or replaced by another
+    // float network. Copy has to be quantized from current
+    // weights of the float network.
+    //
+
+    void attach_quantized_network(unsigned int nid, std::shared_ptr<quantized_network> qnet);
 
     //
     // Zwraca liczbę sieci neuronowych zaaplikowanych do systemu.
@@ -96,6 +126,15 @@ public:
 
     void save_network(unsigned int nid, const std::string &file_name);
 
+    //
+    // In-memory snapshot of network weights (JSON),
+    // e.g. to clone trained network into replicas.
+    //
+
+    std::string export_network(unsigned int nid) const;
+
+    void load_network_from_buffer(unsigned int nid, const std::string &buffer);
+
     double get_network_output(unsigned int nid);
 
     //
@@ -131,10 +170,25 @@ public:
 
     void fireup_networks(void);
 
+    //
+    // Fires only network of given ID, so ensemble
+    // may be evaluated lazily. Input bus is loaded
+    // if needed.
+    //
+
+    void fireup_network(unsigned int nid);
+
     void feedback(double expected);
 
     void import_input_bus_from_hftr(const hftr &h);
 
+    //
+    // As above, but input pins are given
+    // as a plain array of „size” values.
+    //
+
+    void import_input_bus(const double *pins, size_t size);
+
     hftr export_input_bus_to_hftr(void) const;
 
 protected:
@@ -146,6 +200,7 @@ protected:
 private:
 
     typedef std::vector<std::shared_ptr<neural_network> > neural_network_container;
+    typedef std::vector<std::shared_ptr<quantized_network> > quantized_network_container;
 
     //
     // Whether neural network input bus is loaded or not.
@@ -174,6 +229,15 @@ private:
 
     neural_network_container neural_networks_;
 
+    //
+    // Quantized copies, null if network is evaluated
+    // in floating point. They take input bus from
+    // „input_pins_” instead of network pins.
+    //
+
+    quantized_network_container quantized_networks_;
+    std::vector<double> input_pins_;
+
     unsigned int granularity_;
     granularity_counter gc_;
     hftr input_bus_copy_;
@@ -0,0 +1,322 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __BASIC_SHM_SERVER_HPP__
+#define __BASIC_SHM_SERVER_HPP__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <cerrno>
+#include <csignal>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <boost/asio.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+
+#include <easylogging++.h>
+
+#include <custom_except.hpp>
+#include <hft_bin_proto.hpp>
+#include <hft_shm_ring.hpp>
+
+#define hft_shmserver_log(__X__) \
+    CLOG(__X__, "SHM_server")
+
+//
+// Shared memory counterpart of basic_tcp_server for co-located
+// bridges. Every channel from „networking.shm_channels” is
+// a POSIX shared memory region served by its own thread, which
+// feeds binary protocol frames into a session of SessionType.
+// Client side is the hft_shm_client library.
+//
+
+template <typename SessionType>
+class basic_shm_server
+{
+public:
+
+    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
+
+    basic_shm_server(boost::asio::io_context &ioctx, boost::program_options::variables_map &config)
+        : ioctx_(ioctx),
+          config_(config),
+          stop_(false)
+    {
+        std::vector<std::string> names;
+        std::string channels = config["networking.shm_channels"].as<std::string>();
+
+        el::Loggers::getLogger("SHM_server", true);
+
+        boost::trim_if(channels, boost::is_any_of("\" \t"));
+
+        if (channels.empty())
+        {
+            return;
+        }
+
+        boost::split(names, channels, boost::is_any_of(", \t"), boost::token_compress_on);
+
+        channels_.resize(names.size());
+
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            channels_[i].name = (names[i].front() == '/') ? names[i] : std::string("/") + names[i];
+            create_region(channels_[i]);
+
+            hft_shmserver_log(INFO) << "Server configured to serve shared memory channel ["
+                                    << channels_[i].name << "]";
+        }
+
+        for (auto &ch : channels_)
+        {
+            ch.thread.reset(new std::thread(&basic_shm_server<SessionType>::serve, this, &ch));
+        }
+    }
+
+    virtual ~basic_shm_server(void)
+    {
+        stop_ = true;
+
+        for (auto &ch : channels_)
+        {
+            if (ch.thread)
+            {
+                ch.region -> requests.doorbell.fetch_add(1);
+                hft::shm::futex_wake(&ch.region -> requests.doorbell);
+                ch.thread -> join();
+            }
+
+            destroy_region(ch);
+        }
+    }
+
+private:
+
+    struct channel_data
+    {
+        channel_data(void) : fd(-1), region(nullptr) {}
+
+        std::string name;
+        int fd;
+        hft::shm::region *region;
+        std::shared_ptr<std::thread> thread;
+    };
+
+    void create_region(channel_data &ch)
+    {
+        //
+        // Stale region after crash is simply replaced.
+        //
+
+        shm_unlink(ch.name.c_str());
+
+        ch.fd = shm_open(ch.name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660);
+
+        if (ch.fd < 0 || ftruncate(ch.fd, sizeof(hft::shm::region)) < 0)
+        {
+            throw exception(std::string("Unable to create shared memory channel ")
+                            + ch.name + std::string(": ") + strerror(errno));
+        }
+
+        void *addr = mmap(nullptr, sizeof(hft::shm::region), PROT_READ | PROT_WRITE, MAP_SHARED, ch.fd, 0);
+
+        if (addr == MAP_FAILED)
+        {
+            throw exception(std::string("Unable to map shared memory channel ")
+                            + ch.name + std::string(": ") + strerror(errno));
+        }
+
+        ch.region = new (addr) hft::shm::region;
+        ch.region -> state.store(hft::shm::FREE);
+        ch.region -> client_pid.store(0);
+        ch.region -> requests.reset();
+        ch.region -> requests.doorbell.store(0);
+        ch.region -> responses.reset();
+        ch.region -> responses.doorbell.store(0);
+        ch.region -> version = hft::shm::REGION_VERSION;
+        ch.region -> magic = hft::shm::REGION_MAGIC;
+    }
+
+    void destroy_region(channel_data &ch)
+    {
+        if (ch.region != nullptr)
+        {
+            munmap(ch.region, sizeof(hft::shm::region));
+            ch.region = nullptr;
+        }
+
+        if (ch.fd >= 0)
+        {
+            close(ch.fd);
+            shm_unlink(ch.name.c_str());
+            ch.fd = -1;
+        }
+    }
+
+    void drop_client(channel_data *ch, std::unique_ptr<SessionType> &session, const char *reason)
+    {
+        hft_shmserver_log(INFO) << "Channel [" << ch -> name << "]: client "
+                                << ch -> region -> client_pid.load() << " " << reason;
+
+        session.reset();
+
+        ch -> region -> client_pid.store(0);
+        ch -> region -> state.store(hft::shm::FREE);
+        hft::shm::futex_wake(&ch -> region -> state);
+    }
+
+    bool client_alive(channel_data *ch) const
+    {
+        pid_t pid = ch -> region -> client_pid.load();
+
+        return (pid <= 0 || kill(pid, 0) == 0 || errno != ESRCH);
+    }
+
+    void serve(channel_data *ch)
+    {
+        hft::shm::region *region = ch -> region;
+        std::unique_ptr<SessionType> session;
+        std::vector<unsigned char> frame(sizeof(hft::bin_frame_header) + hft::BIN_PROTO_MAX_PAYLOAD);
+        hft::bin_frame_header header;
+        std::string response;
+        long length;
+
+        while (! stop_)
+        {
+            switch (region -> state.load())
+            {
+                case hft::shm::ATTACHING:
+                {
+                    //
+                    // Client stores its pid right after it has
+                    // taken the channel and rings the doorbell.
+                    //
+
+                    pid_t pid = region -> client_pid.load();
+
+                    if (pid <= 0)
+                    {
+                        break;
+                    }
+
+                    region -> requests.reset();
+                    region -> responses.reset();
+                    session.reset(new SessionType(ioctx_, config_));
+
+                    //
+                    // Client may have given up waiting in the
+                    // meantime and released the channel, then
+                    // it must stay free.
+                    //
+
+                    std::uint32_t expected = hft::shm::ATTACHING;
+
+                    if (! region -> state.compare_exchange_strong(expected, hft::shm::CONNECTED))
+                    {
+                        hft_shmserver_log(WARNING) << "Channel [" << ch -> name << "]: client "
+                                                   << pid << " gave up attaching";
+
+                        session.reset();
+                        continue;
+                    }
+
+                    hft_shmserver_log(INFO) << "Channel [" << ch -> name << "]: client "
+                                            << pid << " attached";
+
+                    hft::shm::futex_wake(&region -> state);
+                    continue;
+                }
+
+                case hft::shm::CLOSING:
+                    drop_client(ch, session, "detached");
+                    continue;
+
+                case hft::shm::CONNECTED:
+                    length = region -> requests.pop(frame.data(), frame.size());
+
+                    if (length < 0)
+                    {
+                        drop_client(ch, session, "sent oversized frame, disconnected");
+                        continue;
+                    }
+                    else if (length > 0)
+                    {
+                        response.clear();
+                        std::memcpy(&header, frame.data(), std::min(size_t(length), sizeof(header)));
+
+                        if (size_t(length) < sizeof(header) || header.length != length - sizeof(header))
+                        {
+                            hft::bin_encode_response("ERROR;Malformed frame", response);
+                        }
+                        else
+                        {
+                            try
+                            {
+                                session -> process_binary_frame(header, frame.data() + sizeof(header), response, hft::epoch_usec_now());
+                            }
+                            catch (const std::exception &e)
+                            {
+                                hft_shmserver_log(ERROR) << "Error occured: " << e.what();
+
+                                drop_client(ch, session, "disconnected because of error");
+                                continue;
+                            }
+                        }
+
+                        while (! region -> responses.push(response.data(), response.length()))
+                        {
+                            if (stop_ || region -> state.load() != hft::shm::CONNECTED)
+                            {
+                                break;
+                            }
+
+                            std::this_thread::yield();
+                        }
+
+                        continue;
+                    }
+
+                    break;
+
+                default:
+                    break;
+            }
+
+            if (! region -> requests.wait(100) && region -> state.load() == hft::shm::CONNECTED && ! client_alive(ch))
+            {
+                drop_client(ch, session, "died");
+            }
+        }
+
+        session.reset();
+    }
+
+    boost::asio::io_context &ioctx_;
+    boost::program_options::variables_map &config_;
+    std::atomic<bool> stop_;
+    std::vector<channel_data> channels_;
+};
+
+#endif /* __BASIC_SHM_SERVER_HPP__ */
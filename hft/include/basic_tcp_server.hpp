@@ -18,6 +18,13 @@
 #define __BASIC_TCP_SERVER_HPP__
 
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
@@ -30,14 +37,23 @@ using boost::asio::ip::tcp;
 #define hft_tcpserver_log(__X__) \
     CLOG(__X__, "TCP_IP_server")
 
+//
+// Stream server accepting sessions on TCP port, Unix domain
+// socket or both at once. Acceptors are generic stream ones
+// so sessions do not care about underlying protocol.
+//
+
 template <typename SessionType>
 class basic_tcp_server
 {
 public:
 
+    typedef boost::asio::basic_socket_acceptor<boost::asio::generic::stream_protocol> acceptor_type;
+    typedef boost::asio::generic::stream_protocol::endpoint endpoint_type;
+
     basic_tcp_server(boost::asio::io_context &ioctx, boost::program_options::variables_map &config)
         : ioctx_(ioctx),
-          acceptor_(ioctx, tcp::endpoint(tcp::v4(), config["networking.listen_port"].as<short>())),
+          unix_socket_(config["networking.unix_socket"].as<std::string>()),
           config_(config)
     {
         //
@@ -46,29 +62,121 @@ public:
 
         el::Loggers::getLogger("TCP_IP_server", true);
 
-        hft_tcpserver_log(INFO) << "Server configured to listen "
-                                << "on port ["
-                                << config["networking.listen_port"].as<short>()
-                                << "]";
+        if (config["networking.tcp_enabled"].as<bool>())
+        {
+            endpoint_type endpoint(tcp::endpoint(tcp::v4(), config["networking.listen_port"].as<short>()));
+
+            acceptors_.push_back(std::make_shared<acceptor_type>(ioctx, endpoint));
+
+            hft_tcpserver_log(INFO) << "Server configured to listen "
+                                    << "on port ["
+                                    << config["networking.listen_port"].as<short>()
+                                    << "]";
+        }
+
+        if (! unix_socket_.empty())
+        {
+            remove_stale_unix_socket();
+
+            endpoint_type endpoint { boost::asio::local::stream_protocol::endpoint(unix_socket_) };
+
+            acceptors_.push_back(std::make_shared<acceptor_type>(ioctx, endpoint));
+
+            ::chmod(unix_socket_.c_str(), 0660);
 
-        start_accept();
+            hft_tcpserver_log(INFO) << "Server configured to listen "
+                                    << "on Unix socket „"
+                                    << unix_socket_
+                                    << "”";
+        }
+
+        if (acceptors_.empty())
+        {
+            throw std::runtime_error("Neither TCP nor Unix socket listener is enabled");
+        }
+
+        for (auto &acceptor : acceptors_)
+        {
+            start_accept(acceptor.get());
+        }
     }
 
-    virtual ~basic_tcp_server(void) = default;
+    virtual ~basic_tcp_server(void)
+    {
+        if (! unix_socket_.empty())
+        {
+            acceptors_.clear();
+
+            ::unlink(unix_socket_.c_str());
+        }
+    }
 
 private:
 
-    void start_accept(void)
+    //
+    // Removes socket file left by previous instance. Never
+    // removes anything else mistyped path points to, nor
+    // socket of another instance still listening on it.
+    //
+
+    void remove_stale_unix_socket(void)
+    {
+        struct stat st;
+
+        if (::lstat(unix_socket_.c_str(), &st) != 0)
+        {
+            return;
+        }
+
+        if (! S_ISSOCK(st.st_mode))
+        {
+            throw std::runtime_error(std::string("Unix socket path „") + unix_socket_
+                                     + "” exists and is not a socket");
+        }
+
+        boost::asio::local::stream_protocol::socket probe(ioctx_);
+        boost::system::error_code ec;
+
+        probe.connect(boost::asio::local::stream_protocol::endpoint(unix_socket_), ec);
+
+        if (! ec)
+        {
+            throw std::runtime_error(std::string("Unix socket „") + unix_socket_
+                                     + "” is in use by another running instance");
+        }
+
+        if (ec != boost::asio::error::connection_refused)
+        {
+            throw std::runtime_error(std::string("Unable to check Unix socket „") + unix_socket_
+                                     + "”: " + ec.message());
+        }
+
+        ::unlink(unix_socket_.c_str());
+    }
+
+    void start_accept(acceptor_type *acceptor)
     {
         SessionType *new_session = new SessionType(ioctx_, config_);
 
-        acceptor_.async_accept(new_session -> socket(), boost::bind(&basic_tcp_server<SessionType>::handle_accept, this, new_session, boost::asio::placeholders::error));
+        acceptor -> async_accept(new_session -> socket(), boost::bind(&basic_tcp_server<SessionType>::handle_accept, this, acceptor, new_session, boost::asio::placeholders::error));
     }
 
-    void handle_accept(SessionType *new_session, const boost::system::error_code &error)
+    void handle_accept(acceptor_type *acceptor, SessionType *new_session, const boost::system::error_code &error)
     {
         if (! error)
         {
+            //
+            // Responses are small and latency sensitive,
+            // don't let Nagle hold them back.
+            //
+
+            if (acceptor -> local_endpoint().protocol().family() != AF_UNIX)
+            {
+                boost::system::error_code ignored;
+
+                new_session -> socket().set_option(tcp::no_delay(true), ignored);
+            }
+
             new_session -> start();
         }
         else
@@ -77,13 +185,19 @@ private:
                                      << error.message();
 
             delete new_session;
+
+            if (error == boost::asio::error::operation_aborted)
+            {
+                return;
+            }
         }
 
-        start_accept();
+        start_accept(acceptor);
     }
 
     boost::asio::io_context &ioctx_;
-    tcp::acceptor acceptor_;
+    std::vector<std::shared_ptr<acceptor_type>> acceptors_;
+    std::string unix_socket_;
     boost::program_options::variables_map &config_;
 };
 
@@ -18,13 +18,16 @@
 #define __EXPERT_ADVISOR_HPP__
 
 #include <list>
+#include <vector>
+#include <atomic>
 #include <utility>
 
 #include <basic_artifical_inteligence.hpp>
 #include <decision_trigger.hpp>
 #include <position_control_manager.hpp>
-#include <files_change_tracker.hpp>
+#include <file_watch_service.hpp>
 #include <hci.hpp>
+#include <hft_utils.hpp>
 
 class expert_advisor : private basic_artifical_inteligence
 {
@@ -75,7 +78,16 @@ private:
 
     void factory_advisor(void);
 
+    void watch_networks(const std::string &manifest_file_name);
+
+    void apply_reloaded_networks(void);
+
+    decision_type full_vote(void);
+
+    decision_type lazy_vote(void);
+
     std::string instrument_;
+    hft::instrument_type instrument_id_;
     unsigned int dpips_limit_loss_;
     unsigned int dpips_limit_profit_;
     bool mutable_networks_;
@@ -84,12 +96,50 @@ private:
 
     double vote_ratio_;
 
+    //
+    // Lazy voting. Networks are evaluated one by one,
+    // cheapest per abstention first, until outcome of
+    // voting is determined. „votes_required_” is the
+    // least number of votes satisfying „vote_ratio_”.
+    //
+
+    typedef struct _network_voting_stats
+    {
+        _network_voting_stats(void)
+            : cost(0.0), evaluations(0), abstentions(0) {}
+
+        double cost;
+        unsigned long evaluations;
+        unsigned long abstentions;
+
+    } network_voting_stats;
+
+    bool lazy_voting_;
+    unsigned int votes_required_;
+    std::vector<network_voting_stats> voting_stats_;
+    std::vector<unsigned int> voting_order_;
+    unsigned long lazy_decisions_;
+    unsigned long lazy_short_circuits_;
+    unsigned long lazy_evaluations_;
+
     std::shared_ptr<decision_trigger> decision_;
     std::shared_ptr<position_control_manager> position_controller_;
     std::shared_ptr<hci> decision_compensate_inverter_;
     bool decision_compensate_inverter_enabled_;
 
-    files_change_tracker net_info_;
+    //
+    // Network hot reload. Networks are loaded off-thread
+    // by file watch service handler and published in
+    // „reloaded_networks_”, then swapped in between
+    // decisions.
+    //
+
+    neural_network::layers_architecture arch_;
+    hft::activation_accuracy activation_accuracy_;
+    std::vector<std::string> network_files_;
+    std::vector<std::shared_ptr<neural_network> > reloaded_networks_;
+    std::atomic<bool> networks_reloaded_;
+    std::vector<file_watch_service::subscription_id> subscriptions_;
 
     bool trade_on_positive_swaps_only_;
 
@@ -0,0 +1,105 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __FAST_ACTIVATION_HPP__
+#define __FAST_ACTIVATION_HPP__
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace hft {
+
+    //
+    // Accuracy of sigmoid activate functions. „exact”
+    // calls „exp” and is the reference, others use
+    // sigmoid table with linear interpolation. Maximum
+    // absolute error of sigmoid (bipolar sigmoid has
+    // twice as big) against the reference:
+    //
+    //   ACTIVATION_FINE    step 1/256, error < 2·10⁻⁷
+    //   ACTIVATION_COARSE  step 1/32,  error < 1.3·10⁻⁵
+    //
+
+    enum activation_accuracy
+    {
+        ACTIVATION_EXACT,
+        ACTIVATION_FINE,
+        ACTIVATION_COARSE
+    };
+
+    //
+    // Recognizes „exact”, „fine” and „coarse”.
+    //
+
+    bool parse_activation_accuracy(const std::string &s, activation_accuracy &acc);
+
+    std::string activation_accuracy_to_string(activation_accuracy acc);
+
+    //
+    // Logistic sigmoid tabulated over <-range, range>,
+    // saturated outside. Each node holds value and slope
+    // to next node, so lookup is single load and fma.
+    //
+
+    class sigmoid_table
+    {
+    public:
+
+        sigmoid_table(double range, unsigned int resolution);
+
+        double operator ()(double x) const
+        {
+            double t = (x + range_) * resolution_;
+
+            if (! (t > 0.0))
+            {
+                return nodes_.front().value;
+            }
+            else if (t >= last_)
+            {
+                return nodes_.back().value;
+            }
+
+            size_t i = static_cast<size_t>(t);
+
+            return nodes_[i].value + (t - i) * nodes_[i].slope;
+        }
+
+        //
+        // Shared table for given accuracy,
+        // null for „ACTIVATION_EXACT”.
+        //
+
+        static const sigmoid_table *get(activation_accuracy acc);
+
+    private:
+
+        typedef struct _node
+        {
+            double value;
+            double slope;
+
+        } node;
+
+        double range_;
+        double resolution_;
+        double last_;
+        std::vector<node> nodes_;
+    };
+}
+
+#endif /* __FAST_ACTIVATION_HPP__ */
@@ -0,0 +1,86 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __FILE_WATCH_SERVICE_HPP__
+#define __FILE_WATCH_SERVICE_HPP__
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include <custom_except.hpp>
+
+//
+// Process wide service watching files for changes. Watching
+// is done by inotify on directories containing subscribed
+// files, in one background thread. When file is written
+// (closed after write) or moved into directory, all handlers
+// subscribed for that file are called from the background
+// thread, so they are allowed to do heavy work (e.g. parse
+// a file), but must not subscribe nor unsubscribe.
+// „unsubscribe” waits for a handler in progress, so after
+// it returns, handler is never called again.
+//
+
+class file_watch_service
+{
+public:
+
+    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
+
+    typedef unsigned int subscription_id;
+    typedef std::function<void (const std::string &)> handler;
+
+    static file_watch_service &instance(void);
+
+    ~file_watch_service(void);
+
+    subscription_id subscribe(const std::string &file_name, handler h);
+
+    void unsubscribe(subscription_id id);
+
+private:
+
+    file_watch_service(void);
+    file_watch_service(const file_watch_service &) = delete;
+
+    int add_watch(const std::string &dir);
+
+    void thread_funct(void);
+
+    struct subscription
+    {
+        int wd;
+        std::string name;
+        std::string path;
+        handler h;
+    };
+
+    int fd_;
+    std::map<int, std::string> watches_;
+    std::map<subscription_id, subscription> subscriptions_;
+    subscription_id next_id_;
+
+    std::mutex mtx_;
+    std::atomic<bool> stop_;
+    std::shared_ptr<std::thread> thread_;
+};
+
+#endif /* __FILE_WATCH_SERVICE_HPP__ */
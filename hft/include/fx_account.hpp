@@ -42,6 +42,7 @@ public:
     void forcibly_close_position(const csv_loader::csv_record &market_info);
 
     std::string get_position_status(const csv_loader::csv_record &market_info) const;
+    double get_position_pips(const csv_loader::csv_record &market_info) const;
 
     void dispaly_statistics(void) const;
 
@@ -0,0 +1,114 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_BIN_PROTO_HPP__
+#define __HFT_BIN_PROTO_HPP__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <hft_req_proto.hpp>
+
+//
+// Binary protocol is selected by client sending BIN_PROTO_MAGIC
+// as the very first byte of connection. Afterwards every request
+// and response is a frame: bin_frame_header followed by „length”
+// bytes of payload. All fields are little-endian.
+//
+// Requests reuse opcodes of text protocol messages. Responses
+// carry one of bin_response_code as opcode, ERROR response has
+// error description as payload.
+//
+
+namespace hft {
+
+    const unsigned char BIN_PROTO_MAGIC = 0xB1;
+    const size_t BIN_PROTO_MAX_PAYLOAD = 4096;
+
+    #pragma pack(push, 1)
+
+    struct bin_frame_header
+    {
+        std::uint16_t length;
+        std::uint8_t  opcode;
+        std::uint8_t  reserved;
+    };
+
+    struct bin_tick_payload
+    {
+        std::uint16_t instrument_id;
+        std::uint16_t reserved;
+        std::uint32_t ask;
+        std::int64_t  request_time;
+        double        bankroll;
+        double        position_status;  // NaN means no position („N/A”)
+    };
+
+    struct bin_historical_tick_payload
+    {
+        std::uint16_t instrument_id;
+        std::uint16_t reserved;
+        std::uint32_t ask;
+    };
+
+    struct bin_hci_setup_payload
+    {
+        std::uint16_t instrument_id;
+        std::uint8_t  enable;
+        std::uint8_t  reserved;
+    };
+
+    //
+    // Subscribe payload is variable length array of
+    // std::uint16_t instrument identifiers.
+    //
+
+    #pragma pack(pop)
+
+    static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Binary protocol assumes little-endian host");
+    static_assert(sizeof(bin_frame_header) == 4, "Bad size of bin_frame_header");
+    static_assert(sizeof(bin_tick_payload) == 32, "Bad size of bin_tick_payload");
+
+    enum bin_response_code
+    {
+        BIN_RESPONSE_OK    = 0x81,
+        BIN_RESPONSE_LONG  = 0x82,
+        BIN_RESPONSE_SHORT = 0x83,
+        BIN_RESPONSE_CLOSE = 0x84,
+        BIN_RESPONSE_ERROR = 0xFF
+    };
+
+    //
+    // Server side.
+    //
+
+    generic_protocol_message bin_parse_message(const bin_frame_header &header, const unsigned char *payload);
+    void bin_encode_response(const std::string &text_response, std::string &out);
+
+    //
+    // Client side.
+    //
+
+    void bin_encode_tick(const bin_tick_payload &tick, std::string &out);
+    void bin_encode_historical_tick(const bin_historical_tick_payload &tick, std::string &out);
+    void bin_encode_subscribe(const std::vector<instrument_type> &instruments, std::string &out);
+    void bin_encode_hci_setup(const bin_hci_setup_payload &hci, std::string &out);
+    std::string bin_decode_response(const bin_frame_header &header, const unsigned char *payload);
+
+} /* namespace hft */
+
+#endif /* __HFT_BIN_PROTO_HPP__ */
@@ -21,7 +21,6 @@
 #include <stdexcept>
 #include <set>
 
-#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/any.hpp>
 
 #include <hft_utils.hpp>
@@ -38,10 +37,20 @@ namespace hft {
         enum { OPCODE = 1 };
 
         std::string instrument;
-        boost::posix_time::ptime request_time;
+        hft::instrument_type instrument_id;
+        hft::epoch_usec_type request_time;
         unsigned int ask;
         double bankroll;
+
+        //
+        // Text protocol passes position status as received,
+        // binary one as number of pips (NaN if no position),
+        // leaving „position_status” empty. It is not used
+        // on tick path, so it is never formatted there.
+        //
+
         std::string position_status;
+        double position_pips;
 
     } tick_message;
 
@@ -50,6 +59,7 @@ namespace hft {
         enum { OPCODE = 2 };
 
         std::string instrument;
+        hft::instrument_type instrument_id;
         unsigned int ask;
 
     } historical_tick_message;
@@ -67,6 +77,7 @@ namespace hft {
         enum { OPCODE = 4 };
 
         std::string instrument;
+        hft::instrument_type instrument_id;
         bool enable;
 
     } hci_setup_message;
@@ -21,6 +21,7 @@
 #include <session_transport.hpp>
 
 #include <memory>
+#include <vector>
 
 class hft_session : public session_transport
 {
@@ -33,7 +34,16 @@ public:
 
 private:
 
-    typedef std::map<std::string, std::shared_ptr<instrument_handler> > instrument_handler_container;
+    //
+    // Handlers are indexed directly by instrument type.
+    //
+
+    typedef std::vector<std::shared_ptr<instrument_handler> > instrument_handler_container;
+
+    instrument_handler *find_handler(hft::instrument_type instrument_id) const
+    {
+        return (instrument_id < instrument_handlers_.size()) ? instrument_handlers_[instrument_id].get() : nullptr;
+    }
 
     void tick_notify(const hft::tick_message &msg,
                          std::ostringstream &response);
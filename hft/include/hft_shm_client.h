@@ -0,0 +1,58 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_SHM_CLIENT_H__
+#define __HFT_SHM_CLIENT_H__
+
+/*
+ * C client library for HFT server shared memory transport.
+ * Requests and responses are binary protocol frames
+ * (see hft_bin_proto.hpp); the library only moves them
+ * through the channel created by the server.
+ *
+ * All functions return negative value on error, then
+ * hft_shm_last_error() describes what happened.
+ *
+ * After hft_shm_receive() times out, the response may still
+ * arrive and would be mistaken for the answer to the next
+ * request. The client is therefore marked broken: further
+ * sends and receives fail until it is disconnected and
+ * connected again.
+ */
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct hft_shm_client hft_shm_client;
+
+hft_shm_client *hft_shm_connect(const char *channel, int timeout_ms);
+void hft_shm_disconnect(hft_shm_client *client);
+
+int hft_shm_send(hft_shm_client *client, const void *frame, size_t length, int timeout_ms);
+long hft_shm_receive(hft_shm_client *client, void *frame, size_t capacity, int timeout_ms);
+long hft_shm_request(hft_shm_client *client, const void *request, size_t length,
+                     void *response, size_t capacity, int timeout_ms);
+
+const char *hft_shm_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HFT_SHM_CLIENT_H__ */
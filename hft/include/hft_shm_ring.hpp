@@ -0,0 +1,249 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFT_SHM_RING_HPP__
+#define __HFT_SHM_RING_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+//
+// Shared memory channel layout used by shm_transport (server side)
+// and hft_shm_client library (bridge side). Channel is a pair of
+// single-producer/single-consumer byte rings, one for requests
+// and one for responses. Each ring message is a 32-bit length
+// followed by the binary protocol frame (see hft_bin_proto.hpp).
+//
+// Consumer spins for a while (multi CPU hosts only), then sleeps
+// on futex of the ring doorbell. Producer wakes it up only if it
+// really sleeps.
+//
+
+namespace hft {
+namespace shm {
+
+const std::uint32_t REGION_MAGIC   = 0x53544648; // „HFTS”
+const std::uint32_t REGION_VERSION = 1;
+const std::uint32_t RING_CAPACITY  = 1 << 16;
+const unsigned int  SPIN_COUNT     = 20000;
+
+//
+// Channel state, driven by client (ATTACHING, CLOSING)
+// and server (CONNECTED, FREE).
+//
+
+enum channel_state : std::uint32_t
+{
+    FREE      = 0,
+    ATTACHING = 1,
+    CONNECTED = 2,
+    CLOSING   = 3
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Lock-free 64-bit atomics required");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Lock-free 32-bit atomics required");
+
+inline long futex_wait(std::atomic<std::uint32_t> *addr, std::uint32_t expected, int timeout_ms)
+{
+    struct timespec ts;
+
+    ts.tv_sec  = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+
+    return syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(addr), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+inline long futex_wake(std::atomic<std::uint32_t> *addr)
+{
+    return syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(addr), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+//
+// Spinning makes sense only if the peer runs on another CPU,
+// on single CPU it just burns the peer's time slice.
+//
+
+inline unsigned int spin_limit(void)
+{
+    static const unsigned int limit = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? SPIN_COUNT : 0;
+
+    return limit;
+}
+
+inline void cpu_relax(void)
+{
+    #if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+    #endif
+}
+
+struct ring
+{
+    alignas(64) std::atomic<std::uint64_t> head;        // Written by producer only.
+    alignas(64) std::atomic<std::uint64_t> tail;        // Written by consumer only.
+    alignas(64) std::atomic<std::uint32_t> doorbell;
+    std::atomic<std::uint32_t> waiting;
+    alignas(64) unsigned char data[RING_CAPACITY];
+
+    void reset(void)
+    {
+        head.store(0);
+        tail.store(0);
+        waiting.store(0);
+    }
+
+    bool empty(void) const
+    {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_relaxed);
+    }
+
+    void copy_in(std::uint64_t pos, const void *src, size_t length)
+    {
+        size_t offset = pos & (RING_CAPACITY - 1);
+        size_t first  = std::min(length, size_t(RING_CAPACITY) - offset);
+
+        std::memcpy(data + offset, src, first);
+        std::memcpy(data, static_cast<const unsigned char *>(src) + first, length - first);
+    }
+
+    void copy_out(std::uint64_t pos, void *dst, size_t length) const
+    {
+        size_t offset = pos & (RING_CAPACITY - 1);
+        size_t first  = std::min(length, size_t(RING_CAPACITY) - offset);
+
+        std::memcpy(dst, data + offset, first);
+        std::memcpy(static_cast<unsigned char *>(dst) + first, data, length - first);
+    }
+
+    //
+    // Returns false if there is no room for message.
+    //
+
+    bool push(const void *message, std::uint32_t length)
+    {
+        std::uint64_t h = head.load(std::memory_order_relaxed);
+        std::uint64_t t = tail.load(std::memory_order_acquire);
+
+        if (RING_CAPACITY - (h - t) < sizeof(length) + length)
+        {
+            return false;
+        }
+
+        copy_in(h, &length, sizeof(length));
+        copy_in(h + sizeof(length), message, length);
+
+        head.store(h + sizeof(length) + length, std::memory_order_release);
+
+        //
+        // Ring the doorbell. Full fence pairs with consumer
+        // setting „waiting” before it re-checks the ring.
+        //
+
+        doorbell.fetch_add(1, std::memory_order_seq_cst);
+
+        if (waiting.load(std::memory_order_seq_cst))
+        {
+            futex_wake(&doorbell);
+        }
+
+        return true;
+    }
+
+    //
+    // Returns length of popped message, 0 if ring is empty
+    // and -1 if message does not fit in the output buffer
+    // (message stays in the ring then).
+    //
+
+    long pop(void *message, size_t capacity)
+    {
+        std::uint64_t t = tail.load(std::memory_order_relaxed);
+        std::uint64_t h = head.load(std::memory_order_acquire);
+        std::uint32_t length;
+
+        if (h == t)
+        {
+            return 0;
+        }
+
+        copy_out(t, &length, sizeof(length));
+
+        if (length > capacity)
+        {
+            return -1;
+        }
+
+        copy_out(t + sizeof(length), message, length);
+
+        tail.store(t + sizeof(length) + length, std::memory_order_release);
+
+        return length;
+    }
+
+    //
+    // Adaptive wait: spin first, then sleep on doorbell.
+    // Returns true if there is data to pop.
+    //
+
+    bool wait(int timeout_ms)
+    {
+        for (unsigned int i = 0; i < spin_limit(); i++)
+        {
+            if (! empty())
+            {
+                return true;
+            }
+
+            cpu_relax();
+        }
+
+        std::uint32_t seen = doorbell.load(std::memory_order_seq_cst);
+
+        waiting.store(1, std::memory_order_seq_cst);
+
+        if (empty())
+        {
+            futex_wait(&doorbell, seen, timeout_ms);
+        }
+
+        waiting.store(0, std::memory_order_relaxed);
+
+        return ! empty();
+    }
+};
+
+struct region
+{
+    std::uint32_t magic;
+    std::uint32_t version;
+    alignas(64) std::atomic<std::uint32_t> state;
+    std::atomic<std::int32_t> client_pid;
+
+    ring requests;
+    ring responses;
+};
+
+} /* namespace shm */
+} /* namespace hft */
+
+#endif /* __HFT_SHM_RING_HPP__ */
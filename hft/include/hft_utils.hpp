@@ -18,6 +18,7 @@
 #define __HFT_UTILS_HPP__
 
 #include <string>
+#include <cstdint>
 
 namespace hft {
 
@@ -26,11 +27,29 @@ typedef unsigned int instrument_type;
 const instrument_type UNRECOGNIZED_INSTRUMENT=0xFFFF;
 
 unsigned int floating2dpips(const std::string &data, instrument_type t);
+std::string dpips2floating(unsigned int dpips, instrument_type t);
 const char *get_instrument_description(instrument_type t);
+const char *get_instrument_name(instrument_type t);
 instrument_type instrument2type(const std::string &instrstr);
+unsigned int get_instruments_number(void);
 
 std::string timestamp_to_datetime_str(long timestamp);
 
+//
+// Timestamps on the tick path are microseconds since
+// 1970-01-01 00:00:00 of the (naive) client clock.
+//
+
+typedef std::int64_t epoch_usec_type;
+
+const epoch_usec_type USEC_PER_SECOND = 1000000LL;
+const epoch_usec_type USEC_PER_MINUTE = 60LL * USEC_PER_SECOND;
+const epoch_usec_type USEC_PER_DAY    = 1440LL * USEC_PER_MINUTE;
+
+bool datetime_str_to_epoch_usec(const std::string &data, epoch_usec_type &out);
+std::string epoch_usec_to_datetime_str(epoch_usec_type timestamp);
+epoch_usec_type epoch_usec_now(void);
+
 } /* namespace hft */
 
 #endif /* __HFT_UTILS_HPP__ */
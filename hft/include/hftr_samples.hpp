@@ -0,0 +1,84 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __HFTR_SAMPLES_HPP__
+#define __HFTR_SAMPLES_HPP__
+
+#include <vector>
+#include <string>
+
+#include <custom_except.hpp>
+#include <hftr.hpp>
+#include <text_file_reader.hpp>
+
+//
+// Set of HFTR samples parsed to flat array of input
+// pins and expected values (+1.0 for increase, -1.0
+// for decrease), ready to be put onto network input
+// bus without further parsing.
+//
+
+class hftr_samples
+{
+public:
+
+    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
+
+    hftr_samples(void) : inputs_(0) {}
+
+    hftr_samples(const std::string &file_name) : inputs_(0)
+    {
+        text_file_reader reader(file_name);
+
+        load(reader);
+    }
+
+    //
+    // Removes samples, but keeps input size,
+    // so consecutive blocks are consistent.
+    //
+
+    void clear(void)
+    {
+        pins_.clear();
+        expected_.clear();
+    }
+
+    void append(const hftr &h);
+
+    //
+    // Reads up to „max” samples (0 means all remaining)
+    // from reader. Returns number of samples read.
+    //
+
+    size_t load(text_file_reader &reader, size_t max = 0);
+
+    size_t size(void) const { return expected_.size(); }
+
+    size_t get_inputs(void) const { return inputs_; }
+
+    const double *get_pins(size_t n) const { return &pins_[n*inputs_]; }
+
+    double get_expected(size_t n) const { return expected_[n]; }
+
+private:
+
+    std::vector<double> pins_;
+    std::vector<double> expected_;
+    size_t inputs_;
+};
+
+#endif /* __HFTR_SAMPLES_HPP__ */
@@ -48,6 +48,7 @@ private:
         std::string label;
         std::string program;
         std::string start_dir;
+        std::string shm_channel;
         arguments argv;
         std::shared_ptr<boost::process::child> child;
         std::shared_ptr<boost::process::opstream> process_stdin;
@@ -56,7 +57,7 @@ private:
 
     typedef std::list<bridge_process_info> bridge_process_info_list;
 
-    std::string create_process_configuration(void) const;
+    std::string create_process_configuration(const bridge_process_info &bpi) const;
     static std::string prepare_log_file(void);
     static std::string find_free_name(const std::string &file_name);
     static std::string file_get_contents(const std::string &filename);
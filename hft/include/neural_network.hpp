@@ -17,6 +17,8 @@
 #ifndef __NEURAL_NETWORK_HPP__
 #define __NEURAL_NETWORK_HPP__
 
+#include <cstdint>
+
 #include <neuron.hpp>
 
 class neural_network
@@ -40,14 +42,16 @@ public:
     //            should not be used for training. Parameter
     //            can be changd also by „set_learn_coefficient”
     //            method.
+    //   rng    - generator for initial weights (optional).
     //
 
     neural_network(unsigned int inputs,
                    const layers_architecture &la,
-                   double lc = 0.0)
+                   double lc = 0.0,
+                   std::mt19937 *rng = nullptr)
         : inputs_(inputs), lc_(lc)
     {
-        factory_network(la);
+        factory_network(la, rng);
     }
 
     //
@@ -70,11 +74,25 @@ public:
 
     void save_network(const std::string &file_name);
 
+    //
+    // Network weights as JSON string, the same
+    // format as produced by „save_network”.
+    //
+
+    std::string export_to_json(void) const;
+
     void set_learn_coefficient(double lc);
 
     void set_activate_function(unsigned int layer_number,
                                    neuron::activate_function_class af);
 
+    //
+    // Accuracy of activate functions of all neurons,
+    // see „fast_activation.hpp”.
+    //
+
+    void set_activation_accuracy(hft::activation_accuracy acc);
+
     double get_output(unsigned int pin) const;
 
     unsigned int get_number_of_inputs(void) const
@@ -82,6 +100,63 @@ public:
         return inputs_;
     }
 
+    //
+    // Binary format of network weights:
+    //
+    //   offset  size  content
+    //   0       8     magic „HFTNNBIN”
+    //   8       4     format version
+    //   12      4     number of network inputs
+    //   16      4     number of layers (L)
+    //   20      4     reserved (0)
+    //   24      8·L   per layer: number of neurons, activate function
+    //   24+8·L  ...   weights of all neurons, layer by layer,
+    //                 as IEEE 754 doubles
+    //
+    // All integers are 32 bit, all values are little endian.
+    // File is loaded through mmap. Files with „.nnb” extension
+    // are saved in binary format by „save_network”, while
+    // „load_network” recognizes format by magic.
+    //
+
+    void save_network_binary(const std::string &file_name) const;
+
+    void load_network_binary(const std::string &file_name);
+
+    static bool is_binary_file(const std::string &file_name);
+
+    static bool has_binary_extension(const std::string &file_name);
+
+    //
+    // Reads architecture from binary file header, so
+    // the network could be constructed before loading.
+    // Architecture contains all layers (also input and
+    // output ones).
+    //
+
+    static void read_binary_header(const std::string &file_name,
+                                   unsigned int &inputs,
+                                   layers_architecture &la,
+                                   std::vector<neuron::activate_function_class> &af);
+
+    unsigned int get_number_of_layers(void) const
+    {
+        return internal_network_.size();
+    }
+
+    unsigned int get_layer_size(unsigned int num_layer) const
+    {
+        return internal_network_.at(num_layer).size();
+    }
+
+    //
+    // 64 bit FNV-1a hash of network shape and bit
+    // patterns of all weights. Identifies weights
+    // derived copies (e.g. quantized) were made of.
+    //
+
+    std::uint64_t weights_fingerprint(void) const;
+
     #ifdef USE_CJSON
     void load_network(const std::string &file_name);
 
@@ -95,7 +170,7 @@ private:
     typedef std::vector<neuron> layer;
     typedef std::vector<layer> network;
 
-    void factory_network(const layers_architecture &la);
+    void factory_network(const layers_architecture &la, std::mt19937 *rng);
 
     //
     // Network architecture.
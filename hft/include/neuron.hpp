@@ -20,6 +20,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <vector>
+#include <random>
 
 
 //
@@ -29,6 +30,7 @@
 #define USE_CJSON
 
 #include <custom_except.hpp>
+#include <fast_activation.hpp>
 
 #ifdef USE_CJSON
 #include <cJSON/cJSON.h>
@@ -48,7 +50,13 @@ public:
         LINE
     };
 
-    neuron(size_t inputs, double lc);
+    //
+    // Initial weights are randomized with „rng” if given,
+    // otherwise with per thread generator seeded from
+    // random device.
+    //
+
+    neuron(size_t inputs, double lc, std::mt19937 *rng = nullptr);
 
     ~neuron(void)
     {
@@ -88,6 +96,26 @@ public:
         weights_.at(n) = value;
     }
 
+    size_t get_weights_number(void) const
+    {
+        return weights_.size();
+    }
+
+    const double *get_weights(void) const
+    {
+        return weights_.data();
+    }
+
+    //
+    // Sets all weights at once, „w” has to point
+    // to „get_weights_number()” values.
+    //
+
+    void set_weights(const double *w)
+    {
+        weights_.assign(w, w + weights_.size());
+    }
+
     double output_pin(void) const
     {
         return output_;
@@ -110,6 +138,27 @@ public:
         activate_function_init_params();
     }
 
+    activate_function_class get_activate_function(void) const
+    {
+        return function_type_;
+    }
+
+    //
+    // Sigmoids are evaluated by table of given accuracy,
+    // or by „exp” for „ACTIVATION_EXACT” (default).
+    //
+
+    void set_activation_accuracy(hft::activation_accuracy acc)
+    {
+        accuracy_ = acc;
+        sigmoid_ = hft::sigmoid_table::get(acc);
+    }
+
+    hft::activation_accuracy get_activation_accuracy(void) const
+    {
+        return accuracy_;
+    }
+
     void set_learn_coefficient(double lc)
     {
         learn_coefficient_ = lc;
@@ -205,6 +254,8 @@ private:
     std::vector<double> weights_;
     double learn_coefficient_;
     activate_function_class function_type_;
+    hft::activation_accuracy accuracy_;
+    const hft::sigmoid_table *sigmoid_;
     double argument_;
 
     double output_;
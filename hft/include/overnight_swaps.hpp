@@ -18,8 +18,26 @@
 
 #include <string>
 
+#include <hft_utils.hpp>
+
 namespace hft {
 
+//
+// Loads swaps table and starts watching its file. Should be
+// called at start up, lookups made before initialize table
+// on their own, off the fast path.
+//
+
+void init_overnight_swaps(void);
+
+//
+// Instrument should be resolved to „instrument_type”
+// once and the type used for lookups on hot path.
+//
+
+bool is_positive_swap_long(instrument_type t);
+bool is_positive_swap_short(instrument_type t);
+
 bool is_positive_swap_long(const std::string &instrument_str);
 bool is_positive_swap_short(const std::string &instrument_str);
 
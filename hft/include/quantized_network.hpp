@@ -0,0 +1,169 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __QUANTIZED_NETWORK_HPP__
+#define __QUANTIZED_NETWORK_HPP__
+
+#include <cstdint>
+#include <vector>
+#include <string>
+
+#include <custom_except.hpp>
+#include <neural_network.hpp>
+#include <hftr_samples.hpp>
+
+//
+// Inference-only, integer copy of neural network. Weights
+// are int8 with one scale per layer, activations are int16
+// with one scale per layer input, dot products accumulate
+// in int32 (SIMD kernel), and activate functions are looked
+// up in table instead of calling „exp”. Scales of activations
+// are calibrated by running float network over HFTR sample.
+//
+// First layer keeps the shape produced by „neural_network”:
+// each neuron sees its own, consecutive window of inputs,
+// next layers are fully connected.
+//
+
+class quantized_network
+{
+public:
+
+    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
+
+    //
+    // Empty network, to be filled by „load”.
+    //
+
+    quantized_network(void) : inputs_(0), source_fingerprint_(0) {}
+
+    //
+    // Quantizes float network. Activation ranges are
+    // taken from „calibration” samples, thus they should
+    // be representative for data seen in production.
+    //
+
+    quantized_network(neural_network &net, const hftr_samples &calibration);
+
+    //
+    // Binary format of quantized network:
+    //
+    //   offset  size   content
+    //   0       8      magic „HFTNNQNT”
+    //   8       4      format version
+    //   12      4      number of network inputs
+    //   16      4      number of layers (L)
+    //   20      4      reserved (0)
+    //   24      8      fingerprint of source float network
+    //   32      40·L   per layer: number of neurons, activate
+    //                  function, inputs per neuron, reserved (0),
+    //                  weight scale, input scale, output scale
+    //   32+40·L ...    per layer: int8 weights of all neurons,
+    //                  followed by int32 biases of all neurons
+    //
+    // Integers are little endian, scales are IEEE 754 doubles.
+    // Fingerprint is „neural_network::weights_fingerprint”
+    // of network the copy was quantized from, so copy left
+    // over after retraining can be detected.
+    //
+
+    void save(const std::string &file_name) const;
+
+    void load(const std::string &file_name);
+
+    static bool is_quantized_file(const std::string &file_name);
+
+    //
+    // Inference. „pins” holds „get_number_of_inputs()”
+    // values of network input bus.
+    //
+
+    void fire(const double *pins);
+
+    double get_output(unsigned int pin) const { return outputs_.at(pin); }
+
+    unsigned int get_number_of_inputs(void) const { return inputs_; }
+
+    unsigned int get_number_of_layers(void) const { return layers_.size(); }
+
+    unsigned int get_layer_size(unsigned int num_layer) const { return layers_.at(num_layer).neurons; }
+
+    std::uint64_t get_source_fingerprint(void) const { return source_fingerprint_; }
+
+private:
+
+    typedef struct _quantized_layer
+    {
+        unsigned int neurons;
+        neuron::activate_function_class af;
+
+        //
+        // Inputs per neuron and its row length in
+        // „weights”, rounded up to SIMD register width.
+        //
+
+        unsigned int fan_in;
+        unsigned int stride;
+
+        //
+        // Offset of input window of consecutive neurons,
+        // „fan_in” in first layer, 0 in fully connected ones.
+        //
+
+        unsigned int window_step;
+
+        double weight_scale;
+        double input_scale;
+        double output_scale;
+
+        std::vector<std::int16_t> weights;
+        std::vector<std::int32_t> biases;
+
+        //
+        // Activate function table indexed by scaled
+        // accumulator, values already in output scale.
+        //
+
+        std::vector<std::int16_t> table;
+        double table_gain;
+
+        //
+        // Accumulator to output scale for „LINE”.
+        //
+
+        double requantize_gain;
+
+    } quantized_layer;
+
+    void factory_layer_buffers(void);
+
+    static void build_activate_table(quantized_layer &l);
+
+    unsigned int inputs_;
+    std::uint64_t source_fingerprint_;
+    std::vector<quantized_layer> layers_;
+
+    //
+    // Quantized input of each layer, zero padded, so SIMD
+    // kernel may read whole registers past last input.
+    //
+
+    std::vector<std::vector<std::int16_t> > activations_;
+    std::vector<std::int16_t> last_output_;
+    std::vector<double> outputs_;
+};
+
+#endif /* __QUANTIZED_NETWORK_HPP__ */
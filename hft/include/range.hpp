@@ -36,6 +36,16 @@ public:
         return (val >= begin_ && val < end_);
     }
 
+    T get_begin(void) const
+    {
+        return begin_;
+    }
+
+    T get_end(void) const
+    {
+        return end_;
+    }
+
     bool empty(void) const
     {
         return (begin_ == end_);
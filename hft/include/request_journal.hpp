@@ -0,0 +1,159 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+
+#ifndef __REQUEST_JOURNAL_HPP__
+#define __REQUEST_JOURNAL_HPP__
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <custom_except.hpp>
+#include <hft_utils.hpp>
+
+//
+// Request journal is a binary append-only file with every
+// request received by server sessions, its arrival time and
+// the response sent back. File starts with journal_file_header
+// followed by records: journal_record_header, raw request
+// bytes and raw response bytes. Text protocol requests are
+// stored without trailing newline, binary ones as complete
+// frames. All fields are little-endian.
+//
+// Journal is appended across server restarts while session
+// identifiers start over on every run, so each opening of
+// the journal writes a run marker record first (empty
+// request and response). Sessions are identified by pair
+// (run, session) then.
+//
+
+namespace hft {
+
+    const char JOURNAL_MAGIC[8] = { 'H', 'F', 'T', 'J', 'R', 'N', 'L', '\0' };
+    const std::uint32_t JOURNAL_VERSION = 2;
+
+    enum journal_protocol : std::uint8_t
+    {
+        JOURNAL_TEXT_PROTOCOL   = 0,
+        JOURNAL_BINARY_PROTOCOL = 1,
+        JOURNAL_RUN_MARKER      = 2
+    };
+
+    #pragma pack(push, 1)
+
+    struct journal_file_header
+    {
+        char          magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+    };
+
+    struct journal_record_header
+    {
+        std::int64_t  arrival_time;     // epoch microseconds
+        std::uint32_t session_id;
+        std::uint8_t  protocol;         // journal_protocol
+        std::uint8_t  reserved[3];
+        std::uint32_t request_length;
+        std::uint32_t response_length;
+    };
+
+    #pragma pack(pop)
+
+    static_assert(sizeof(journal_file_header) == 16, "Unexpected journal file header size");
+    static_assert(sizeof(journal_record_header) == 24, "Unexpected journal record header size");
+
+    struct journal_record
+    {
+        epoch_usec_type arrival_time;
+        std::uint32_t run_id;
+        std::uint32_t session_id;
+        journal_protocol protocol;
+        std::string request;
+        std::string response;
+    };
+
+} /* namespace hft */
+
+//
+// Writing side of the journal. Sessions only append records
+// to in-memory buffer, the file is written by a background
+// thread, so disk never stalls request processing. When the
+// writer can't keep up and buffer exceeds its limit, records
+// are dropped and counted instead of blocking sessions.
+//
+
+class request_journal
+{
+public:
+
+    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
+
+    request_journal(const std::string &file_name, size_t max_pending_bytes = 64 * 1024 * 1024);
+
+    ~request_journal(void);
+
+    void record(std::uint32_t session_id, hft::journal_protocol protocol,
+                    hft::epoch_usec_type arrival_time,
+                    const char *request, size_t request_length,
+                    const std::string &response);
+
+private:
+
+    void writer(void);
+
+    std::FILE *file_;
+    std::string file_name_;
+    size_t max_pending_bytes_;
+
+    std::string pending_;
+    unsigned long dropped_;
+    bool stop_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread thread_;
+};
+
+//
+// Sequential reader of journal files.
+//
+
+class request_journal_reader
+{
+public:
+
+    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
+
+    request_journal_reader(const std::string &file_name);
+
+    ~request_journal_reader(void);
+
+    bool get_record(hft::journal_record &out_rec);
+
+private:
+
+    std::FILE *file_;
+    std::string file_name_;
+    std::uint32_t version_;
+    std::uint32_t run_id_;
+};
+
+#endif /* __REQUEST_JOURNAL_HPP__ */
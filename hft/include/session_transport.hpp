@@ -20,19 +20,19 @@
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
-#include <iostream>
+#include <cstdint>
+#include <atomic>
 
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
-#include <boost/date_time/posix_time/posix_time.hpp>
 #include <boost/program_options.hpp>
 
 #include <easylogging++.h>
 
 #include <auto_deallocator.hpp>
 #include <hft_req_proto.hpp>
-
-using boost::asio::ip::tcp;
+#include <hft_bin_proto.hpp>
+#include <request_journal.hpp>
 
 class session_transport : public auto_deallocator
 {
@@ -40,26 +40,52 @@ public:
 
     session_transport(boost::asio::io_service &io_service,
                           const boost::program_options::variables_map &config)
-        : socket_(io_service), request_time_(0,0,0,0), config_(config)
+        : socket_(io_service), binary_protocol_(false), request_time_(0),
+          session_id_(++session_counter_), config_(config)
     {
          el::Loggers::getLogger("transport", true);
     }
 
     virtual ~session_transport(void) = default;
 
-    tcp::socket &socket(void)
+    //
+    // Generic stream socket, so the same session serves
+    // TCP as well as Unix domain socket connections.
+    //
+
+    typedef boost::asio::generic::stream_protocol::socket socket_type;
+
+    socket_type &socket(void)
     {
         return socket_;
     }
 
-    void start(void)
+    void start(void);
+
+    //
+    // Protocol entry points used by transports (and replay).
+    // Both set the request time to the given arrival time
+    // and fill in complete response to be sent back.
+    //
+
+    void process_text_request(const std::string &line, std::string &response, hft::epoch_usec_type arrival_time);
+
+    void process_binary_frame(const hft::bin_frame_header &header, const unsigned char *payload,
+                                  std::string &response, hft::epoch_usec_type arrival_time);
+
+    //
+    // Requests of all sessions go to attached journal,
+    // if any. Pass nullptr to stop journaling.
+    //
+
+    static void attach_journal(request_journal *journal)
     {
-        boost::asio::async_read_until(socket_, input_buffer_, '\n', boost::bind(&session_transport::handle_read, this, _1));
+        journal_ = journal;
     }
 
 protected:
 
-    const boost::posix_time::time_duration &get_request_time(void) const
+    hft::epoch_usec_type get_request_time(void) const
     {
         return request_time_;
     }
@@ -83,15 +109,28 @@ protected:
 
 private:
 
+    void handle_handshake(const boost::system::error_code &error);
+
+    void read_request(void);
+
+    void dispatch_message(const hft::generic_protocol_message &msg, std::ostringstream &response);
+
     void handle_read(const boost::system::error_code &error);
 
+    void handle_binary_read(const boost::system::error_code &error);
+
     void handle_write(const boost::system::error_code &error);
 
-    tcp::socket socket_;
+    socket_type socket_;
     boost::asio::streambuf input_buffer_;
     std::string response_data_;
+    bool binary_protocol_;
+
+    hft::epoch_usec_type request_time_;
+    std::uint32_t session_id_;
 
-    boost::posix_time::time_duration request_time_;
+    static std::atomic<request_journal *> journal_;
+    static std::atomic<std::uint32_t> session_counter_;
 
     const boost::program_options::variables_map &config_;
 };
@@ -18,10 +18,18 @@
 #define __TRACER_HPP__
 
 #include <iostream>
-#include <list>
+#include <vector>
+#include <algorithm>
 
 #include <range.hpp>
 
+//
+// Ranges are kept in flat array sorted by beginning, so
+// range of a value is found by binary search. Longest run
+// of equally spaced ranges of equal width (bucket grid) is
+// indexed arithmetically, in O(1).
+//
+
 class value_tracer
 {
 public:
@@ -29,11 +37,29 @@ public:
     DEFINE_CUSTOM_EXCEPTION_CLASS(value_tracer_exception, std::runtime_error)
 
     value_tracer(void)
-        : up_(false), down_(false), new_(true), prev_range_(0, 0) {}
+        : up_(false), down_(false), new_(true), prev_range_(0, 0),
+          grid_valid_(false), grid_first_(0), grid_begin_(0),
+          grid_end_(0), grid_stride_(1) {}
 
     void add_range(const range<unsigned int> &r)
     {
-        for (auto it = ranges_.begin(); it != ranges_.end(); ++it)
+        auto pos = std::upper_bound(ranges_.begin(), ranges_.end(), r);
+
+        //
+        // Ranges are disjoint and sorted, so their ends grow
+        // as well. Only neighbours may have common part with
+        // the new one.
+        //
+
+        for (auto it = pos; it != ranges_.begin() && (it - 1) -> get_end() >= r.get_begin(); --it)
+        {
+            if ((it - 1) -> has_common_range(r))
+            {
+                throw value_tracer_exception("Common range detected.");
+            }
+        }
+
+        for (auto it = pos; it != ranges_.end() && it -> get_begin() <= r.get_end(); ++it)
         {
             if (it -> has_common_range(r))
             {
@@ -41,8 +67,8 @@ public:
             }
         }
 
-        ranges_.push_back(r);
-        ranges_.sort();
+        ranges_.insert(pos, r);
+        grid_valid_ = false;
     }
 
     bool is_up(void) const
@@ -108,25 +134,105 @@ private:
 
     range<unsigned int> get_range(unsigned int v)
     {
-        range<unsigned int> null_range = range<unsigned int>(0, 0);
+        static const range<unsigned int> null_range = range<unsigned int>(0, 0);
+
+        if (! grid_valid_)
+        {
+            index_grid();
+        }
+
+        if (v >= grid_begin_ && v < grid_end_)
+        {
+            const range<unsigned int> &r = ranges_[grid_first_ + (v - grid_begin_) / grid_stride_];
+
+            return (r.in_range(v) ? r : null_range);
+        }
+
+        //
+        // Last range beginning at or before the value
+        // is the only one which may contain it.
+        //
+
+        auto it = std::upper_bound(ranges_.begin(), ranges_.end(), v,
+                                   [](unsigned int x, const range<unsigned int> &r) { return x < r.get_begin(); });
+
+        if (it == ranges_.begin() || ! (it - 1) -> in_range(v))
+        {
+            return null_range;
+        }
+
+        return *(it - 1);
+    }
+
+    void index_grid(void)
+    {
+        size_t best_first = 0, best_count = 0;
 
-        for (auto it = ranges_.begin(); it != ranges_.end(); ++it)
+        for (size_t i = 0; i < ranges_.size(); )
         {
-            if (it -> in_range(v))
+            size_t j = i + 1;
+
+            if (j < ranges_.size())
+            {
+                unsigned int stride = ranges_[j].get_begin() - ranges_[i].get_begin();
+                unsigned int width = ranges_[i].get_end() - ranges_[i].get_begin();
+
+                while (j < ranges_.size()
+                        && ranges_[j].get_begin() - ranges_[j-1].get_begin() == stride
+                        && ranges_[j].get_end() - ranges_[j].get_begin() == width)
+                {
+                    j++;
+                }
+
+                if (stride > 0 && j - i > best_count)
+                {
+                    best_first = i;
+                    best_count = j - i;
+                }
+
+                i = (j - 1 > i) ? j - 1 : j;
+            }
+            else
             {
-                return (*it);
+                break;
             }
         }
 
-        return null_range;
+        //
+        // Grid covers values from beginning of its first range
+        // to end of its last one. No other range can lie there,
+        // it would break the run.
+        //
+
+        grid_valid_ = true;
+        grid_first_ = best_first;
+
+        if (best_count >= 3)
+        {
+            grid_begin_  = ranges_[best_first].get_begin();
+            grid_end_    = ranges_[best_first + best_count - 1].get_end();
+            grid_stride_ = ranges_[best_first + 1].get_begin() - grid_begin_;
+        }
+        else
+        {
+            grid_begin_  = 0;
+            grid_end_    = 0;
+            grid_stride_ = 1;
+        }
     }
 
-    std::list<range<unsigned int> > ranges_;
+    std::vector<range<unsigned int> > ranges_;
 
     range<unsigned int> prev_range_;
     bool up_;
     bool down_;
     bool new_;
+
+    bool grid_valid_;
+    size_t grid_first_;
+    unsigned int grid_begin_;
+    unsigned int grid_end_;
+    unsigned int grid_stride_;
 };
 
 //
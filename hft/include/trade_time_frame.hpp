@@ -18,11 +18,21 @@
 #define __TRADE_TIME_FRAME_HPP__
 
 #include <stdexcept>
+#include <vector>
+#include <cstdint>
 
 #include <boost/program_options.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <custom_except.hpp>
+#include <hft_utils.hpp>
+
+//
+// Trade time frame is compiled once at startup into a weekly bitmap
+// with one bit per minute (7 x 1440 bits, Sunday first), so checking
+// a tick timestamp is a division plus a single shift and mask. Each
+// day may define several trading windows; holidays close the whole day.
+//
 
 class trade_time_frame
 {
@@ -32,14 +42,23 @@ public:
     trade_time_frame(void) = delete;
     ~trade_time_frame(void);
 
-    bool can_play(const boost::posix_time::time_duration &td);
-    bool can_play(const boost::posix_time::ptime &current_time_point);
+    bool can_play(const boost::posix_time::time_duration &td) const;
+    bool can_play(const boost::posix_time::ptime &current_time_point) const;
+    bool can_play(hft::epoch_usec_type timestamp) const;
 
 private:
 
     enum
     {
-        MON, TUE, WED, THU, FRI
+        MINUTES_PER_DAY  = 1440,
+        MINUTES_PER_WEEK = 7 * MINUTES_PER_DAY,
+        WEEK_WORDS       = (MINUTES_PER_WEEK + 63) / 64,
+
+        //
+        // 1970-01-01 was Thursday.
+        //
+
+        EPOCH_DAY_OF_WEEK = 4
     };
 
     struct timeframe_restriction
@@ -48,13 +67,26 @@ private:
         boost::posix_time::time_duration trade_period_to;
     };
 
+    typedef std::vector<timeframe_restriction> timeframe_restrictions;
+
+    static std::int64_t to_epoch_minute(const boost::posix_time::ptime &time_point);
+    bool can_play_minute(std::int64_t epoch_minute) const;
+
+    static timeframe_restrictions parse_restrictions(std::string restrictions);
     static timeframe_restriction parse_restriction(std::string restriction);
-    static bool can_play_today(const timeframe_restriction &restriction,
-                                   const boost::posix_time::time_duration &td);
+    void compile_day(int dow, const timeframe_restrictions &restrictions);
+    void parse_holidays(std::string holidays);
+
+    inline bool minute_of_week_set(unsigned int mow) const
+    {
+        return (week_[mow >> 6] >> (mow & 63)) & 1u;
+    }
+
     static const char *const days_[];
 
     const bool enabled_;
-    timeframe_restriction tfr_[5];
+    std::uint64_t week_[WEEK_WORDS];
+    std::vector<std::int64_t> holidays_;
 };
 
 #endif /* __TRADE_TIME_FRAME_HPP__ */
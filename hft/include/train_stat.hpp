@@ -17,8 +17,7 @@
 #ifndef __TRAIN_STAT_HPP__
 #define __TRAIN_STAT_HPP__
 
-#include <list>
-#include <utility>
+#include <vector>
 #include <string>
 
 class train_stat
@@ -31,37 +30,72 @@ public:
         JSON
     };
 
-    void clear(void) { data_.clear(); };
-    void store(double network_response, double expected);
+    //
+    // Running moments (Welford) of network
+    // response, mergeable across threads.
+    //
 
-    std::string generate_report(report_type rt) const;
+    struct moments
+    {
+        moments(void) : n(0), mean(0.0), m2(0.0) {}
 
-    double get_pessimistic_ratio_indicator(void) const;
+        void add(double x);
+        void merge(const moments &other);
 
-private:
+        double variance(void) const { return n > 1 ? m2 / static_cast<double>(n - 1) : 0.0; }
+
+        unsigned long n;
+        double mean;
+        double m2;
+    };
+
+    train_stat(void);
+
+    void clear(void);
+    void store(double network_response, double expected);
+
+    //
+    // Statistics gathered separately, e.g. in parallel
+    // threads, are aggregated by merge.
+    //
 
-    typedef std::pair<unsigned int, unsigned int> position_type_stats;
+    void merge(const train_stat &other);
 
-    unsigned int get_total_successes(void) const;
+    //
+    // Optional histogram of network responses
+    // in range [min, max] with fixed bins. Values
+    // out of range are counted in edge bins.
+    //
 
-    position_type_stats get_long_information(void) const;
+    void enable_histogram(unsigned int bins, double min = -1.0, double max = 1.0);
 
-    position_type_stats get_short_information(void) const;
+    std::string generate_report(report_type rt) const;
 
-    double get_average_abs_error(void) const;
+    double get_pessimistic_ratio_indicator(void) const;
 
-    double get_average_sqr_error(void) const;
+    double get_ratio(void) const { return ratio(success_, n_); }
+
+private:
 
     static double ratio(unsigned int k, unsigned int n);
     static double pessimistic_ratio_indicator(unsigned int k, unsigned int n);
 
-    //
-    // First is network output value,
-    // second is an result.
-    //
+    unsigned int n_;
+    unsigned int success_;
+    unsigned int long_n_;
+    unsigned int long_success_;
+    unsigned int short_n_;
+    unsigned int short_success_;
 
-    std::list<std::pair<double, double> > data_;
+    double abs_error_sum_;
+    double sqr_error_sum_;
+
+    moments long_moments_;
+    moments short_moments_;
+
+    double histogram_min_;
+    double histogram_max_;
+    std::vector<unsigned long> histogram_;
 };
 
 #endif /* __TRAIN_STAT_HPP__ */
-
@@ -0,0 +1,124 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#ifndef __VALIDATION_ENGINE_HPP__
+#define __VALIDATION_ENGINE_HPP__
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <exception>
+
+#include <neural_network.hpp>
+#include <basic_artifical_inteligence.hpp>
+#include <train_stat.hpp>
+#include <hftr_samples.hpp>
+
+//
+// Evaluates snapshot of network weights against validation
+// set. HFTR file is parsed only once, samples are kept in
+// memory as flat array and may be shared between engines
+// validating different architectures. Evaluation is spread over worker
+// threads, each having its own network replica and own
+// statistics, merged when all workers are done.
+//
+// „start” returns immediately, so validation may run
+// in background while trained network goes on.
+//
+
+class validation_engine
+{
+public:
+
+    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
+
+    validation_engine(const std::string &hftr_file_name,
+                      const neural_network::layers_architecture &arch,
+                      unsigned int threads,
+                      unsigned int histogram_bins = 0,
+                      hft::activation_accuracy accuracy = hft::ACTIVATION_EXACT);
+
+    validation_engine(std::shared_ptr<const hftr_samples> samples,
+                      const neural_network::layers_architecture &arch,
+                      unsigned int threads,
+                      unsigned int histogram_bins = 0,
+                      hft::activation_accuracy accuracy = hft::ACTIVATION_EXACT);
+
+    ~validation_engine(void);
+
+    //
+    // Starts validation of network given by JSON snapshot
+    // (as returned by „export_network”). Previous
+    // validation, if still in progress, is awaited.
+    //
+
+    void start(const std::string &network_snapshot);
+
+    //
+    // Waits for validation to finish and returns
+    // merged statistics. Exception thrown by any
+    // worker is rethrown here.
+    //
+
+    train_stat wait(void);
+
+    train_stat validate(const std::string &network_snapshot)
+    {
+        start(network_snapshot);
+
+        return wait();
+    }
+
+    bool is_running(void) const { return running_; }
+
+    const std::string &get_snapshot(void) const { return snapshot_; }
+
+    size_t get_samples_number(void) const { return samples_ -> size(); }
+
+    std::shared_ptr<const hftr_samples> get_samples(void) const { return samples_; }
+
+private:
+
+    struct worker_data
+    {
+        std::shared_ptr<basic_artifical_inteligence> replica;
+        unsigned int nid;
+        train_stat stat;
+        size_t first;
+        size_t last;
+        std::exception_ptr error;
+
+        std::shared_ptr<std::thread> thread;
+    };
+
+    typedef std::vector<worker_data> workers;
+
+    void thread_funct(worker_data *self);
+
+    void create_workers(const neural_network::layers_architecture &arch,
+                        unsigned int threads,
+                        unsigned int histogram_bins,
+                        hft::activation_accuracy accuracy);
+
+    std::shared_ptr<const hftr_samples> samples_;
+
+    workers workers_;
+    std::string snapshot_;
+    bool running_;
+};
+
+#endif /* __VALIDATION_ENGINE_HPP__ */
@@ -18,8 +18,12 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
-#include <map>
+#include <sstream>
 #include <vector>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <set>
 
 #include <boost/program_options.hpp>
 #include <boost/tokenizer.hpp>
@@ -30,16 +34,84 @@
 
 #include <csv_loader.hpp>
 #include <hft_utils.hpp>
+#include <text_file_reader.hpp>
 
 namespace prog_opts = boost::program_options;
 namespace fs = boost::filesystem;
 
+//
+// Flat histogram of price differences. Index is
+// a difference in dpips, value is its counter.
+//
+
+struct distribution_histogram
+{
+    distribution_histogram(void) : total(0) {}
+
+    void add(unsigned int d)
+    {
+        if (d >= counts.size())
+        {
+            counts.resize(d + 1, 0);
+        }
+
+        counts[d]++;
+        total++;
+    }
+
+    void add(unsigned int d, unsigned long n)
+    {
+        if (d >= counts.size())
+        {
+            counts.resize(d + 1, 0);
+        }
+
+        counts[d] += n;
+        total += n;
+    }
+
+    void merge(const distribution_histogram &h)
+    {
+        if (h.counts.size() > counts.size())
+        {
+            counts.resize(h.counts.size(), 0);
+        }
+
+        for (unsigned int d = 0; d < h.counts.size(); d++)
+        {
+            counts[d] += h.counts[d];
+        }
+
+        total += h.total;
+    }
+
+    std::vector<unsigned long> counts;
+    unsigned long total;
+};
+
+struct worker_data
+{
+    std::vector<std::string> files;
+    distribution_histogram histogram;
+    std::string error;
+
+    std::shared_ptr<std::thread> thread;
+};
+
+typedef std::vector<worker_data> workers;
+
 //
 // Globals.
 //
 
-static std::map<unsigned int, unsigned int> predistr;
-static unsigned int total = 0;
+static distribution_histogram predistr;
+
+//
+// Names of CSV files already counted into
+// histogram loaded from „--histogram-file”.
+//
+
+static std::set<std::string> processed_files;
 
 //
 // Global tool config structure.
@@ -53,6 +125,8 @@ static struct hft_instrument_variability_distribution_config_type
     int granularity;
     std::string output_fmt;
     std::string output_file;
+    std::string histogram_file;
+    int ncores;
 
 } hft_instrument_variability_distribution_config;
 
@@ -62,35 +136,57 @@ static struct hft_instrument_variability_distribution_config_type
 #define hftOption(__X__) \
     hft_instrument_variability_distribution_config.__X__
 
-static void proceed_file(const std::string &csv_file_name, int granularity)
+//
+// Single pass over CSV file. Consecutive equal prices
+// are filtered out and differences between every
+// granularity-th remaining price are counted directly
+// into the histogram, so no price is kept in memory.
+//
+
+static void proceed_file(const std::string &csv_file_name, int granularity,
+                             distribution_histogram &histogram)
 {
     csv_loader::csv_record tick_record;
     csv_loader csv_data(csv_file_name);
 
+    int filter_prev = 0;
     int prev = 0;
     int dpips = 0;
     int skip_num = 0;
 
-    std::map<unsigned int, unsigned int>::iterator it;
-    std::vector<int> filtered_data;
-
     if (granularity <= 0)
     {
         throw std::runtime_error("Granularity must be greater than 0");
     }
 
-    //
-    // Load data and filtering.
-    //
-
     while (csv_data.get_record(tick_record))
     {
         dpips = hft::floating2dpips(boost::lexical_cast<std::string>(tick_record.ask), hftOption(itype));
 
+        //
+        // Filtering.
+        //
+
+        if (filter_prev != 0 && dpips == filter_prev)
+        {
+            continue;
+        }
+
+        filter_prev = dpips;
+
+        //
+        // Compute distribution.
+        //
+
         if (prev == 0)
         {
             prev = dpips;
-            filtered_data.push_back(dpips);
+            continue;
+        }
+
+        if (skip_num < granularity)
+        {
+            skip_num++;
             continue;
         }
 
@@ -101,58 +197,104 @@ static void proceed_file(const std::string &csv_file_name, int granularity)
             continue;
         }
 
+        skip_num = 0;
+
+        histogram.add(d);
+
         prev = dpips;
-        filtered_data.push_back(dpips);
     }
+}
 
-    //
-    // Compute distribution.
-    //
+static void thread_funct_proceed_files(worker_data *self)
+{
+    try
+    {
+        for (auto &file_name : self -> files)
+        {
+            hft_log(INFO) << "Proceeding file " << file_name;
+            proceed_file(file_name, hftOption(granularity), self -> histogram);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        self -> error = e.what();
+    }
+}
 
-    prev = 0;
+//
+// Histogram file keeps raw counters (one „<difference> <count>”
+// pair per line), so distribution can be updated incrementally
+// when new data arrive instead of recomputing it from scratch.
+// Names of counted CSV files are kept as „# <file name>” lines,
+// so a file is never counted twice.
+//
 
-    for (auto p : filtered_data)
+static void load_histogram(const std::string &file_name, distribution_histogram &histogram,
+                               std::set<std::string> &files)
+{
+    text_file_reader histogram_file(file_name);
+    std::string line;
+    bool eof;
+
+    do
     {
-        if (prev == 0)
+        eof = histogram_file.read_line(line);
+
+        if (line.length() == 0)
         {
-            prev = p;
             continue;
         }
 
-        if (skip_num < granularity)
+        if (line[0] == '#')
         {
-            skip_num++;
+            files.insert(line.substr(line.find_first_not_of("# ")));
+
             continue;
         }
 
-        int d = abs(p - prev);
+        std::istringstream iss(line);
+        unsigned int d;
+        unsigned long n;
 
-        if (d == 0)
+        if (! (iss >> d >> n))
         {
-            continue;
+            throw std::runtime_error(std::string("Bad histogram record „") + line + std::string("”"));
         }
 
-        skip_num = 0;
+        histogram.add(d, n);
 
-        it = predistr.find(d);
+    } while (eof);
+}
 
-        if (it == predistr.end())
-        {
-            predistr[d] = 1;
-        }
-        else
+static void save_histogram(const std::string &file_name, const distribution_histogram &histogram,
+                               const std::set<std::string> &files)
+{
+    std::fstream fs;
+
+    fs.open(file_name, std::fstream::out);
+
+    if (! fs.is_open())
+    {
+        throw std::runtime_error(std::string("Unable to create file „") + file_name + std::string("”"));
+    }
+
+    for (auto &f : files)
+    {
+        fs << "# " << f << "\n";
+    }
+
+    for (unsigned int d = 0; d < histogram.counts.size(); d++)
+    {
+        if (histogram.counts[d] != 0)
         {
-            predistr[d]++;
+            fs << d << " " << histogram.counts[d] << "\n";
         }
-
-        prev = p;
-        total++;
     }
 }
 
-static double probab(unsigned int c)
+static double probab(unsigned long c)
 {
-    return double(c) / double(2*total);
+    return double(c) / double(2*predistr.total);
 }
 
 static void print_distribution(std::ostream &file)
@@ -161,24 +303,38 @@ static void print_distribution(std::ostream &file)
 
     if (hftOption(output_fmt) == "simple")
     {
-        for (auto it = predistr.begin(); it != predistr.end(); ++it)
+        for (unsigned int d = 0; d < predistr.counts.size(); d++)
         {
-            sprintf(buffer, "%0.6f]\n", probab(it -> second));
-            file << "[" << (it -> first) << "] => [" << buffer;
+            if (predistr.counts[d] == 0)
+            {
+                continue;
+            }
+
+            sprintf(buffer, "%0.6f]\n", probab(predistr.counts[d]));
+            file << "[" << d << "] => [" << buffer;
         }
     }
     else if (hftOption(output_fmt) == "json")
     {
+        bool first = true;
+
         file << "{\n";
-        for (auto it = predistr.begin(); it != predistr.end(); ++it)
+        for (unsigned int d = 0; d < predistr.counts.size(); d++)
         {
-            if (it != predistr.begin())
+            if (predistr.counts[d] == 0)
+            {
+                continue;
+            }
+
+            if (! first)
             {
                 file << ",\n";
             }
 
-            sprintf(buffer, "%0.6f", probab(it -> second));
-            file << "\t\"" << (it -> first) << "\" : " << buffer;
+            first = false;
+
+            sprintf(buffer, "%0.6f", probab(predistr.counts[d]));
+            file << "\t\"" << d << "\" : " << buffer;
         }
         file << "\n}\n";
     }
@@ -232,6 +388,9 @@ int hft_instrument_variability_distribution_main(int argc, char *argv[])
                                                                               "Available formats: „simple” or „json”. Default is „simple”")
         ("output-file-name,f", prog_opts::value<std::string>(&hftOption(output_file)) -> default_value(""), "File name for save generated distribution."
                                                                               " If unspecified, distribution is printed to STDOUT.")
+        ("histogram-file,H", prog_opts::value<std::string>(&hftOption(histogram_file)) -> default_value(""), "File with raw histogram counters. If exists, counters are loaded"
+                                                                              " and data from source files not counted yet are added to them. Updated counters are saved back.")
+        ("threads,u", prog_opts::value<int>(&hftOption(ncores)) -> default_value(std::thread::hardware_concurrency()), "Define number of threads")
     ;
 
     prog_opts::options_description cmdline_options;
@@ -273,6 +432,7 @@ int hft_instrument_variability_distribution_main(int argc, char *argv[])
     }
 
     fs::path path(hftOption(source));
+    std::vector<std::string> csv_files;
 
     try
     {
@@ -282,8 +442,7 @@ int hft_instrument_variability_distribution_main(int argc, char *argv[])
             {
                 if (path.extension().generic_string() == ".csv")
                 {
-                    hft_log(INFO) << "Proceeding file " << path;
-                    proceed_file(path.generic_string(), hftOption(granularity));
+                    csv_files.push_back(path.generic_string());
                 }
                 else
                 {
@@ -301,9 +460,9 @@ int hft_instrument_variability_distribution_main(int argc, char *argv[])
                     if (x.path().extension().generic_string() == ".csv")
                     {
                         std::string file_name = x.path().generic_string();
-                        hft_log(INFO) << "Proceedeing (file #" << fno++
+                        hft_log(INFO) << "Scheduled (file #" << fno++
                                       << ") " << file_name;
-                        proceed_file(file_name, hftOption(granularity));
+                        csv_files.push_back(file_name);
                       }
                      else
                      {
@@ -329,6 +488,85 @@ int hft_instrument_variability_distribution_main(int argc, char *argv[])
         return 255;
     }
 
+    //
+    // Load previously collected counters, if any.
+    //
+
+    if (hftOption(histogram_file) != "" && fs::exists(hftOption(histogram_file)))
+    {
+        hft_log(INFO) << "Loading histogram from „"
+                      << hftOption(histogram_file) << "”";
+
+        load_histogram(hftOption(histogram_file), predistr, processed_files);
+    }
+
+    //
+    // Files already counted are skipped,
+    // otherwise they would be counted twice.
+    //
+
+    std::vector<std::string> new_files;
+
+    for (auto &f : csv_files)
+    {
+        std::string name = fs::path(f).filename().string();
+
+        if (processed_files.insert(name).second)
+        {
+            new_files.push_back(f);
+        }
+        else
+        {
+            hft_log(WARNING) << "Skipping " << f << " (already counted)";
+        }
+    }
+
+    csv_files.swap(new_files);
+
+    //
+    // Distribute files among threads. Every thread
+    // counts into its own histogram, histograms are
+    // merged when all threads are done.
+    //
+
+    unsigned int ncores = (hftOption(ncores) > 0 ? hftOption(ncores) : 1);
+    workers thread_workers(std::min(static_cast<size_t>(ncores), csv_files.size()));
+
+    for (unsigned int i = 0; i < csv_files.size(); i++)
+    {
+        thread_workers.at(i % thread_workers.size()).files.push_back(csv_files.at(i));
+    }
+
+    for (auto &x : thread_workers)
+    {
+        x.thread.reset(new std::thread(thread_funct_proceed_files, &x));
+    }
+
+    for (auto &x : thread_workers)
+    {
+        x.thread -> join();
+    }
+
+    for (auto &x : thread_workers)
+    {
+        if (x.error.length())
+        {
+            hft_log(ERROR) << x.error;
+
+            return 1;
+        }
+
+        predistr.merge(x.histogram);
+    }
+
+    if (hftOption(histogram_file) != "")
+    {
+        hft_log(INFO) << "Saving histogram to „"
+                      << hftOption(histogram_file) << "”";
+
+        save_histogram(hftOption(histogram_file), predistr, processed_files);
+    }
+
     //
     // Generating distribution.
     //
@@ -0,0 +1,769 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+
+#include <easylogging++.h>
+#include <cJSON/cJSON.h>
+
+#include <hft_utils.hpp>
+#include <hft_bin_proto.hpp>
+
+namespace prog_opts = boost::program_options;
+
+using boost::asio::ip::tcp;
+
+typedef boost::asio::generic::stream_protocol::socket stream_socket;
+typedef std::chrono::steady_clock clock_type;
+
+static struct hft_loadgen_options_type
+{
+    std::string host;
+    std::string port;
+    std::string unix_socket;
+    std::string instruments;
+    std::string distribution_file_name;
+    bool binary_protocol;
+    unsigned int connections;
+    double rate;
+    double duration;
+    double drain_time;
+
+} hft_loadgen_options;
+
+#define hftOption(__X__) \
+    hft_loadgen_options.__X__
+
+#define hft_log(__X__) \
+    CLOG(__X__, "loadgen")
+
+//
+// Price of every instrument is a random walk. Steps are drawn
+// from instrument variability distribution, as produced by
+// `hft instrument-distrib -o json', symmetrically for both
+// directions.
+//
+
+struct instrument_feed
+{
+    hft::instrument_type id;
+    std::string name;
+    long price;
+};
+
+static std::mt19937 generator(2017);
+static std::discrete_distribution<int> step_distribution;
+static std::vector<int> step_values;
+
+static void load_step_distribution(const std::string &file_name)
+{
+    std::vector<double> weights;
+
+    if (file_name.empty())
+    {
+        //
+        // Rough shape of EURUSD tick changes.
+        //
+
+        step_values = { -4, -3, -2, -1, 0, 1, 2, 3, 4 };
+        weights     = { 0.05, 0.06, 0.16, 0.17, 0.12, 0.17, 0.16, 0.06, 0.05 };
+    }
+    else
+    {
+        std::ifstream is(file_name);
+
+        if (! is)
+        {
+            throw std::runtime_error("Unable to open distribution file: " + file_name);
+        }
+
+        std::stringstream buffer;
+        buffer << is.rdbuf();
+
+        cJSON *json = cJSON_Parse(buffer.str().c_str());
+
+        if (json == nullptr || json -> type != cJSON_Object)
+        {
+            cJSON_Delete(json);
+
+            throw std::runtime_error("Invalid distribution file: " + file_name);
+        }
+
+        for (int i = 0; i < cJSON_GetArraySize(json); i++)
+        {
+            cJSON *item = cJSON_GetArrayItem(json, i);
+            int d = std::stoi(item -> string);
+
+            if (d == 0)
+            {
+                step_values.push_back(0);
+                weights.push_back(2.0 * item -> valuedouble);
+            }
+            else
+            {
+                step_values.push_back(d);
+                weights.push_back(item -> valuedouble);
+                step_values.push_back(-d);
+                weights.push_back(item -> valuedouble);
+            }
+        }
+
+        cJSON_Delete(json);
+
+        if (step_values.empty())
+        {
+            throw std::runtime_error("Empty distribution in file: " + file_name);
+        }
+    }
+
+    step_distribution = std::discrete_distribution<int>(weights.begin(), weights.end());
+}
+
+static unsigned int next_price(instrument_feed &feed)
+{
+    feed.price = std::max(1L, feed.price + step_values[step_distribution(generator)]);
+
+    return feed.price;
+}
+
+//
+// Request time in text protocol format.
+//
+
+static std::string format_request_time(hft::epoch_usec_type t)
+{
+    time_t seconds = t / hft::USEC_PER_SECOND;
+    struct tm dt;
+    char buffer[40];
+
+    gmtime_r(&seconds, &dt);
+
+    size_t length = strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &dt);
+    snprintf(buffer + length, sizeof(buffer) - length, ".%03d", int((t % hft::USEC_PER_SECOND) / 1000));
+
+    return buffer;
+}
+
+//
+// Aggregated results of all connections.
+//
+
+static struct
+{
+    std::vector<long> latencies;    // microseconds
+    unsigned long sent = 0;
+    unsigned long received = 0;
+    unsigned long errors = 0;
+    unsigned long unanswered = 0;
+    unsigned long decisions = 0;
+    unsigned int active_connections = 0;
+
+} stats;
+
+//
+// Single bridge connection. Ticks are sent on schedule regardless
+// of responses (open loop), requests are pipelined. Latency is
+// measured from scheduled send time, so it includes any queueing
+// on client side and is not hidden by slow responses.
+//
+
+class loadgen_connection
+{
+public:
+
+    loadgen_connection(boost::asio::io_context &ioctx, const std::vector<instrument_feed *> &feeds,
+                           clock_type::duration interval, clock_type::time_point start)
+        : ioctx_(ioctx), socket_(ioctx), timer_(ioctx), feeds_(feeds), feed_index_(0),
+          interval_(interval), next_(start), sending_(false), write_in_progress_(false)
+    {
+    }
+
+    void connect(void)
+    {
+        if (hftOption(unix_socket).length())
+        {
+            socket_.connect(boost::asio::local::stream_protocol::endpoint(hftOption(unix_socket)));
+        }
+        else
+        {
+            tcp::resolver resolver(ioctx_);
+            boost::system::error_code error = boost::asio::error::host_not_found;
+
+            for (auto &entry : resolver.resolve(hftOption(host), hftOption(port)))
+            {
+                socket_.close();
+                socket_.connect(entry.endpoint(), error);
+
+                if (! error)
+                {
+                    break;
+                }
+            }
+
+            if (error)
+            {
+                throw boost::system::system_error(error);
+            }
+
+            //
+            // Requests are pipelined, Nagle would hold them back.
+            //
+
+            socket_.set_option(tcp::no_delay(true));
+        }
+
+        if (hftOption(binary_protocol))
+        {
+            boost::asio::write(socket_, boost::asio::buffer(&hft::BIN_PROTO_MAGIC, 1));
+        }
+    }
+
+    //
+    // Subscription is done synchronously before load starts.
+    //
+
+    void subscribe(void)
+    {
+        for (auto feed : feeds_)
+        {
+            std::string reply;
+
+            if (hftOption(binary_protocol))
+            {
+                std::string request;
+                hft::bin_frame_header header;
+                std::vector<unsigned char> payload;
+
+                hft::bin_encode_subscribe({ std::uint16_t(feed -> id) }, request);
+                boost::asio::write(socket_, boost::asio::buffer(request));
+                boost::asio::read(socket_, boost::asio::buffer(&header, sizeof(header)));
+
+                payload.resize(header.length);
+                boost::asio::read(socket_, boost::asio::buffer(payload.data(), payload.size()));
+
+                reply = hft::bin_decode_response(header, payload.data());
+            }
+            else
+            {
+                std::string request = "SUBSCRIBE;" + feed -> name + "\n";
+
+                boost::asio::write(socket_, boost::asio::buffer(request));
+                boost::asio::read_until(socket_, input_buffer_, '\n');
+
+                std::istream is(&input_buffer_);
+                std::getline(is, reply);
+            }
+
+            if (reply != "OK")
+            {
+                throw std::runtime_error("Unable to subscribe instrument „" + feed -> name + "”: " + reply);
+            }
+        }
+    }
+
+    void start(void)
+    {
+        sending_ = true;
+        stats.active_connections++;
+
+        read_response();
+        schedule();
+    }
+
+    void stop_sending(void)
+    {
+        sending_ = false;
+        timer_.cancel();
+
+        check_done();
+    }
+
+    void close(void)
+    {
+        boost::system::error_code ignored;
+
+        timer_.cancel();
+        socket_.close(ignored);
+    }
+
+    size_t outstanding(void) const
+    {
+        return scheduled_.size();
+    }
+
+private:
+
+    void schedule(void)
+    {
+        timer_.expires_at(next_);
+        timer_.async_wait(boost::bind(&loadgen_connection::handle_timer, this, boost::asio::placeholders::error));
+    }
+
+    void handle_timer(const boost::system::error_code &error)
+    {
+        if (error || ! sending_)
+        {
+            return;
+        }
+
+        auto now = clock_type::now();
+
+        while (next_ <= now)
+        {
+            append_tick();
+
+            scheduled_.push_back(next_);
+            next_ += interval_;
+        }
+
+        flush();
+        schedule();
+    }
+
+    void append_tick(void)
+    {
+        instrument_feed *feed = feeds_[feed_index_++ % feeds_.size()];
+        unsigned int price = next_price(*feed);
+        hft::epoch_usec_type now = hft::epoch_usec_now();
+
+        if (hftOption(binary_protocol))
+        {
+            hft::bin_tick_payload tick;
+
+            std::memset(&tick, 0, sizeof(tick));
+
+            tick.instrument_id   = feed -> id;
+            tick.ask             = price;
+            tick.request_time    = now;
+            tick.bankroll        = 1000.0;
+            tick.position_status = std::nan("");
+
+            hft::bin_encode_tick(tick, outgoing_);
+        }
+        else
+        {
+            outgoing_ += "TICK;" + feed -> name + ";" + format_request_time(now) + ";"
+                         + hft::dpips2floating(price, feed -> id) + ";1000;N/A\n";
+        }
+
+        stats.sent++;
+    }
+
+    void flush(void)
+    {
+        if (write_in_progress_ || outgoing_.empty())
+        {
+            return;
+        }
+
+        writing_.swap(outgoing_);
+        outgoing_.clear();
+        write_in_progress_ = true;
+
+        boost::asio::async_write(socket_, boost::asio::buffer(writing_),
+                                 boost::bind(&loadgen_connection::handle_write, this, boost::asio::placeholders::error));
+    }
+
+    void handle_write(const boost::system::error_code &error)
+    {
+        write_in_progress_ = false;
+
+        if (error)
+        {
+            fail(error);
+
+            return;
+        }
+
+        flush();
+    }
+
+    void read_response(void)
+    {
+        if (hftOption(binary_protocol))
+        {
+            boost::asio::async_read(socket_, boost::asio::buffer(&header_, sizeof(header_)),
+                                    boost::bind(&loadgen_connection::handle_header, this, boost::asio::placeholders::error));
+        }
+        else
+        {
+            boost::asio::async_read_until(socket_, input_buffer_, '\n',
+                                          boost::bind(&loadgen_connection::handle_line, this, boost::asio::placeholders::error));
+        }
+    }
+
+    void handle_line(const boost::system::error_code &error)
+    {
+        if (error)
+        {
+            fail(error);
+
+            return;
+        }
+
+        std::string reply;
+        std::istream is(&input_buffer_);
+        std::getline(is, reply);
+
+        complete_response(reply);
+    }
+
+    void handle_header(const boost::system::error_code &error)
+    {
+        if (error)
+        {
+            fail(error);
+
+            return;
+        }
+
+        payload_.resize(header_.length);
+
+        boost::asio::async_read(socket_, boost::asio::buffer(payload_.data(), payload_.size()),
+                                boost::bind(&loadgen_connection::handle_payload, this, boost::asio::placeholders::error));
+    }
+
+    void handle_payload(const boost::system::error_code &error)
+    {
+        if (error)
+        {
+            fail(error);
+
+            return;
+        }
+
+        complete_response(hft::bin_decode_response(header_, payload_.data()));
+    }
+
+    void complete_response(const std::string &reply)
+    {
+        auto now = clock_type::now();
+
+        if (scheduled_.empty())
+        {
+            throw std::runtime_error("Unexpected response from server: " + reply);
+        }
+
+        stats.latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(now - scheduled_.front()).count());
+        stats.received++;
+
+        scheduled_.pop_front();
+
+        if (reply.compare(0, 5, "ERROR") == 0)
+        {
+            if (stats.errors++ == 0)
+            {
+                hft_log(WARNING) << "Server responded with error: " << reply;
+            }
+        }
+        else if (reply != "OK")
+        {
+            stats.decisions++;
+        }
+
+        if (! check_done())
+        {
+            read_response();
+        }
+    }
+
+    bool check_done(void)
+    {
+        if (sending_ || ! scheduled_.empty())
+        {
+            return false;
+        }
+
+        if (socket_.is_open())
+        {
+            close();
+
+            if (--stats.active_connections == 0)
+            {
+                ioctx_.stop();
+            }
+        }
+
+        return true;
+    }
+
+    void fail(const boost::system::error_code &error)
+    {
+        if (! socket_.is_open())
+        {
+            return;
+        }
+
+        hft_log(ERROR) << "Connection failed: " << error.message();
+
+        sending_ = false;
+        stats.unanswered += scheduled_.size();
+        scheduled_.clear();
+
+        check_done();
+    }
+
+    boost::asio::io_context &ioctx_;
+    stream_socket socket_;
+    boost::asio::steady_timer timer_;
+    std::vector<instrument_feed *> feeds_;
+    size_t feed_index_;
+
+    clock_type::duration interval_;
+    clock_type::time_point next_;
+    std::deque<clock_type::time_point> scheduled_;
+    bool sending_;
+
+    std::string outgoing_;
+    std::string writing_;
+    bool write_in_progress_;
+
+    boost::asio::streambuf input_buffer_;
+    hft::bin_frame_header header_;
+    std::vector<unsigned char> payload_;
+};
+
+static long percentile(const std::vector<long> &sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+
+    return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+int hft_loadgen_main(int argc, char *argv[])
+{
+    //
+    // Define default logger configuration.
+    //
+
+    el::Configurations logger_cfg;
+    logger_cfg.setToDefault();
+    logger_cfg.parseFromText("* GLOBAL:\n"
+                             " FORMAT               =  \"%datetime %level [%logger] %msg\"\n"
+                             " FILENAME             =  \"/dev/null\"\n"
+                             " ENABLED              =  true\n"
+                             " TO_FILE              =  false\n"
+                             " TO_STANDARD_OUTPUT   =  true\n"
+                             " SUBSECOND_PRECISION  =  1\n"
+                             " PERFORMANCE_TRACKING =  true\n"
+                             " MAX_LOG_FILE_SIZE    =  10485760 ## 10MiB\n"
+                             " LOG_FLUSH_THRESHOLD  =  1 ## Flush after every single log\n"
+                            );
+    el::Loggers::setDefaultConfigurations(logger_cfg);
+
+    START_EASYLOGGINGPP(argc, argv);
+
+    //
+    // Parsing options for load generator.
+    //
+
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("loadgen", "")
+    ;
+
+    prog_opts::options_description desc("Options for load generator");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("host,H", prog_opts::value<std::string>(&hftOption(host)) -> default_value("localhost"), "HFT server hostname or ip address.")
+        ("port,P", prog_opts::value<std::string>(&hftOption(port)) -> default_value("8137"), "HFT server listen port.")
+        ("unix-socket,U", prog_opts::value<std::string>(&hftOption(unix_socket)) -> default_value(""), "Connect through Unix domain socket instead of TCP.")
+        ("binary-protocol,B", prog_opts::value<bool>(&hftOption(binary_protocol)) -> default_value(false), "Talk to HFT server using binary protocol.")
+        ("connections,c", prog_opts::value<unsigned int>(&hftOption(connections)) -> default_value(16), "Number of concurrent bridge connections.")
+        ("instruments,i", prog_opts::value<std::string>(&hftOption(instruments)) -> default_value("EURUSD"), "Comma separated instruments, spread among connections.")
+        ("rate,r", prog_opts::value<double>(&hftOption(rate)) -> default_value(1000.0), "Target aggregate rate of ticks per second.")
+        ("duration,d", prog_opts::value<double>(&hftOption(duration)) -> default_value(10.0), "Duration of load in seconds.")
+        ("drain-time,w", prog_opts::value<double>(&hftOption(drain_time)) -> default_value(5.0), "How long to wait for outstanding responses after load, in seconds.")
+        ("distribution,D", prog_opts::value<std::string>(&hftOption(distribution_file_name)) -> default_value(""), "Instrument variability distribution JSON (from instrument-distrib) driving price random walk.")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    //
+    // If user requested help, show help and quit
+    // ignoring other options, if any.
+    //
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    el::Logger *logger = el::Loggers::getLogger("loadgen", true);
+
+    if (hftOption(connections) == 0 || hftOption(rate) <= 0.0 || hftOption(duration) <= 0.0)
+    {
+        hft_log(ERROR) << "Connections, rate and duration have to be positive";
+
+        return 1;
+    }
+
+    load_step_distribution(hftOption(distribution_file_name));
+
+    //
+    // Instruments are spread among connections round robin.
+    // If there are less instruments than connections, some
+    // instruments are shared by many connections.
+    //
+
+    std::vector<std::string> names;
+    std::vector<instrument_feed> feeds;
+
+    boost::split(names, hftOption(instruments), boost::is_any_of(", "), boost::token_compress_on);
+
+    for (auto &name : names)
+    {
+        hft::instrument_type id = hft::instrument2type(name);
+
+        if (id == hft::UNRECOGNIZED_INSTRUMENT)
+        {
+            hft_log(ERROR) << "Unsupported instrument ‘" << name << "’";
+
+            return 1;
+        }
+
+        feeds.push_back({ id, name, 100000 });
+    }
+
+    boost::asio::io_context ioctx;
+    std::vector<std::unique_ptr<loadgen_connection>> connections;
+
+    const unsigned int nconn = hftOption(connections);
+    const clock_type::duration interval = std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(nconn / hftOption(rate)));
+    const clock_type::time_point start = clock_type::now() + std::chrono::milliseconds(100) + std::chrono::milliseconds(nconn);
+
+    for (unsigned int k = 0; k < nconn; k++)
+    {
+        std::vector<instrument_feed *> own;
+
+        for (size_t j = k % feeds.size(); j < feeds.size(); j += nconn)
+        {
+            own.push_back(&feeds[j]);
+        }
+
+        //
+        // Connections are shifted in time, so load is spread
+        // evenly instead of coming in bursts.
+        //
+
+        connections.emplace_back(new loadgen_connection(ioctx, own, interval, start + (interval * k) / nconn));
+        connections.back() -> connect();
+        connections.back() -> subscribe();
+    }
+
+    hft_log(INFO) << "Opened " << nconn << " connection(s), subscribed "
+                  << feeds.size() << " instrument(s), target rate "
+                  << hftOption(rate) << " ticks/s for " << hftOption(duration) << " s";
+
+    for (auto &c : connections)
+    {
+        c -> start();
+    }
+
+    stats.latencies.reserve(size_t(hftOption(rate) * hftOption(duration) * 1.1));
+
+    boost::asio::steady_timer stop_timer(ioctx);
+    boost::asio::steady_timer drain_timer(ioctx);
+
+    stop_timer.expires_at(start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(hftOption(duration))));
+    stop_timer.async_wait([&](const boost::system::error_code &error)
+    {
+        if (error)
+        {
+            return;
+        }
+
+        for (auto &c : connections)
+        {
+            c -> stop_sending();
+        }
+
+        drain_timer.expires_after(std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(hftOption(drain_time))));
+        drain_timer.async_wait([&](const boost::system::error_code &error)
+        {
+            if (! error)
+            {
+                ioctx.stop();
+            }
+        });
+    });
+
+    ioctx.run();
+
+    double elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+    unsigned long lost = stats.unanswered;
+
+    for (auto &c : connections)
+    {
+        lost += c -> outstanding();
+        c -> close();
+    }
+
+    std::sort(stats.latencies.begin(), stats.latencies.end());
+
+    double mean = 0.0;
+
+    for (auto l : stats.latencies)
+    {
+        mean += l;
+    }
+
+    mean = (stats.latencies.empty() ? 0.0 : mean / stats.latencies.size());
+
+    std::cout << "\nConnections:          " << nconn << "\n"
+              << "Instruments:          " << feeds.size() << "\n"
+              << "Ticks sent:           " << stats.sent << "\n"
+              << "Responses:            " << stats.received << " (decisions " << stats.decisions
+              << ", errors " << stats.errors << ", unanswered " << lost << ")\n"
+              << std::fixed << std::setprecision(1)
+              << "Target rate:          " << hftOption(rate) << " ticks/s\n"
+              << "Achieved throughput:  " << stats.received / elapsed << " responses/s\n"
+              << "Latency [us]:         mean " << mean
+              << ", p50 " << percentile(stats.latencies, 0.50)
+              << ", p90 " << percentile(stats.latencies, 0.90)
+              << ", p99 " << percentile(stats.latencies, 0.99)
+              << ", p99.9 " << percentile(stats.latencies, 0.999)
+              << ", max " << (stats.latencies.empty() ? 0 : stats.latencies.back()) << "\n";
+
+    return (stats.errors == 0 && lost == 0 ? 0 : 1);
+}
@@ -38,6 +38,10 @@ extern int hft_server_main(int argc, char *argv[]);
 extern int hft_bcalc_main(int argc, char *argv[]);
 extern int hft_hci_tuner_main(int argc, char *argv[]);
 extern int hft_dukascopy_optimizer_main(int argc, char *argv[]);
+extern int hft_nn_convert_main(int argc, char *argv[]);
+extern int hft_nn_quantize_main(int argc, char *argv[]);
+extern int hft_replay_main(int argc, char *argv[]);
+extern int hft_loadgen_main(int argc, char *argv[]);
 
 static struct
 {
@@ -55,7 +59,11 @@ static struct
     { .tool_name = "server",                   .start_program = &hft_server_main },
     { .tool_name = "bcalc",                    .start_program = &hft_bcalc_main },
     { .tool_name = "hci-tuner",                .start_program = &hft_hci_tuner_main },
-    { .tool_name = "dukascopy-optimizer",      .start_program = &hft_dukascopy_optimizer_main }
+    { .tool_name = "dukascopy-optimizer",      .start_program = &hft_dukascopy_optimizer_main },
+    { .tool_name = "nn-convert",               .start_program = &hft_nn_convert_main },
+    { .tool_name = "nn-quantize",              .start_program = &hft_nn_quantize_main },
+    { .tool_name = "replay",                   .start_program = &hft_replay_main },
+    { .tool_name = "loadgen",                  .start_program = &hft_loadgen_main }
 };
 
 int main(int argc, char *argv[])
@@ -77,6 +85,10 @@ int main(int argc, char *argv[])
                       << "  hci-tuner                 finds optimal settings for HCI regulator\n"
                       << "                            optimizing specified indicator\n\n"
                       << "  ai-trainer                proceed train AI predictor's neural networks\n\n"
+                      << "  nn-convert                converts neural network file between JSON and\n"
+                      << "                            binary format\n\n"
+                      << "  nn-quantize               quantizes neural networks for integer\n"
+                      << "                            inference and reports accuracy loss\n\n"
                       << "  serial-analyzer           serial distribution analyzer for instrument\n\n"
                       << "  bcalc                     Bernouli Calculator - calculates correct\n"
                       << "                            prediction probability of set of defined amount\n"
@@ -88,7 +100,11 @@ int main(int argc, char *argv[])
                       << "  fxemulator                HFT TCP Client emulates Dukascopy forex trading\n"
                       << "                            platform using dukascopy historical CSV data\n\n"
                       << "  server                    HFT Trading TCP Server. Expert Advisor for\n"
-                      << "                            production and testing purposes\n\n";
+                      << "                            production and testing purposes\n\n"
+                      << "  replay                    replays server request journal in-process and\n"
+                      << "                            reports response differences and latency\n\n"
+                      << "  loadgen                   synthetic multi-connection, multi-instrument\n"
+                      << "                            load generator for HFT server\n\n";
 
             return 0;
         }
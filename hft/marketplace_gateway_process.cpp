@@ -97,7 +97,7 @@ marketplace_gateway_process::marketplace_gateway_process(boost::asio::io_context
         }
 
 //        proc_item.process_stdin.reset(new boost::process::opstream());
-        (*proc_item.process_stdin) << create_process_configuration() << std::endl;
+        (*proc_item.process_stdin) << create_process_configuration(proc_item) << std::endl;
         proc_item.process_stdin -> flush();
         proc_item.process_stdin -> pipe().close();
     }
@@ -123,13 +123,33 @@ marketplace_gateway_process::~marketplace_gateway_process(void)
     }
 }
 
-std::string marketplace_gateway_process::create_process_configuration(void) const
+std::string marketplace_gateway_process::create_process_configuration(const bridge_process_info &bpi) const
 {
     std::ostringstream oss;
 
     oss << "{\"connection_port\":"
-        << config_["networking.listen_port"].as<short>()
-        << "}";
+        << config_["networking.listen_port"].as<short>();
+
+    //
+    // Bridge may talk to the server through shared memory
+    // channel (see hft_shm_client.h) instead of TCP.
+    //
+
+    if (bpi.shm_channel.length())
+    {
+        oss << ",\"shm_channel\":\"" << bpi.shm_channel << "\"";
+    }
+
+    //
+    // Local bridges may prefer Unix socket when it is enabled.
+    //
+
+    if (config_["networking.unix_socket"].as<std::string>().length())
+    {
+        oss << ",\"unix_socket\":\"" << config_["networking.unix_socket"].as<std::string>() << "\"";
+    }
+
+    oss << "}";
 
     return oss.str();
 }
@@ -292,6 +312,21 @@ void marketplace_gateway_process::parse_proc_list_json(const std::string &data)
 
             bpi.start_dir = start_dir_json -> valuestring;
 
+            cJSON *shm_channel_json = cJSON_GetObjectItem(bridge_proc_json, "shm_channel");
+
+            if (shm_channel_json == nullptr)
+            {
+                bpi.shm_channel.clear();
+            }
+            else if (shm_channel_json -> type != cJSON_String)
+            {
+                throw exception("Attribute ‘shm_channel’ must be type string");
+            }
+            else
+            {
+                bpi.shm_channel = shm_channel_json -> valuestring;
+            }
+
             cJSON *argv_json = cJSON_GetObjectItem(bridge_proc_json, "argv");
 
             if (argv_json == nullptr)
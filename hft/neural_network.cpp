@@ -15,8 +15,16 @@
 \**********************************************************************/
 
 #include <fstream>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
 #include <neural_network.hpp>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/trim.hpp> 
@@ -136,15 +144,13 @@ void neural_network::feedback(double d, bool autosave)
     }
 }
 
-void neural_network::save_network(const std::string &file_name)
+std::string neural_network::export_to_json(void) const
 {
-    file_name_ = file_name;
-
     std::string json_data = "[";
 
     for (auto it = internal_network_.begin(); it != internal_network_.end(); it++)
     {
-        layer &l = (*it);
+        const layer &l = (*it);
 
         for (auto jt = l.begin(); jt != l.end(); jt++)
         {
@@ -161,6 +167,22 @@ void neural_network::save_network(const std::string &file_name)
         json_data.at(json_data.length() - 1) = ']';
     }
 
+    return json_data;
+}
+
+void neural_network::save_network(const std::string &file_name)
+{
+    file_name_ = file_name;
+
+    if (has_binary_extension(file_name_))
+    {
+        save_network_binary(file_name_);
+
+        return;
+    }
+
+    std::string json_data = export_to_json();
+
     std::ofstream os(file_name_, std::ifstream::binary);
 
     if (os)
@@ -175,7 +197,7 @@ void neural_network::save_network(const std::string &file_name)
     }
 }
 
-void neural_network::factory_network(const layers_architecture &la)
+void neural_network::factory_network(const layers_architecture &la, std::mt19937 *rng)
 {
     if (la.size() == 0)
     {
@@ -209,7 +231,7 @@ void neural_network::factory_network(const layers_architecture &la)
                            + std::string("N")
                            + boost::lexical_cast<std::string>(j);
 
-            internal_network_.at(i).push_back(neuron(inputs /*+ 1*/, lc_));
+            internal_network_.at(i).push_back(neuron(inputs /*+ 1*/, lc_, rng));
             internal_network_.at(i).at(j).set_id(id);
             //internal_network_.at(i).at(j).set_pin(inputs, 1.0);
             internal_network_.at(i).at(j).add_const_input();
@@ -274,6 +296,17 @@ void neural_network::set_activate_function(unsigned int layer_number,
     }
 }
 
+void neural_network::set_activation_accuracy(hft::activation_accuracy acc)
+{
+    for (auto &l : internal_network_)
+    {
+        for (auto &n : l)
+        {
+            n.set_activation_accuracy(acc);
+        }
+    }
+}
+
 double neural_network::get_output(unsigned int pin) const
 {
     //
@@ -297,9 +330,404 @@ double neural_network::get_output(unsigned int pin) const
     return last_layer.at(pin).output_pin();
 }
 
+//
+// Binary format.
+//
+
+static const char binary_magic[8] = { 'H', 'F', 'T', 'N', 'N', 'B', 'I', 'N' };
+static const uint32_t binary_version = 1;
+static const size_t binary_fixed_header_size = 24;
+
+static void put_le32(std::string &out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out.push_back(static_cast<char>((v >> (8*i)) & 0xff));
+    }
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return static_cast<uint32_t>(p[0])
+         | (static_cast<uint32_t>(p[1]) << 8)
+         | (static_cast<uint32_t>(p[2]) << 16)
+         | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void put_le_doubles(std::string &out, const double *v, size_t n)
+{
+    #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    out.append(reinterpret_cast<const char *>(v), n*sizeof(double));
+    #else
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t u;
+        memcpy(&u, &v[i], sizeof(u));
+        u = __builtin_bswap64(u);
+        out.append(reinterpret_cast<const char *>(&u), sizeof(u));
+    }
+    #endif
+}
+
+static void get_le_doubles(const unsigned char *p, double *v, size_t n)
+{
+    memcpy(v, p, n*sizeof(double));
+
+    #if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t u;
+        memcpy(&u, &v[i], sizeof(u));
+        u = __builtin_bswap64(u);
+        memcpy(&v[i], &u, sizeof(u));
+    }
+    #endif
+}
+
+//
+// Read only memory mapped file, unmapped when out of scope.
+//
+
+class mapped_network_file
+{
+public:
+
+    mapped_network_file(const std::string &file_name)
+        : data_(nullptr), size_(0)
+    {
+        int fd = open(file_name.c_str(), O_RDONLY);
+
+        if (fd < 0)
+        {
+            std::string msg = std::string("Unable to open file for read: ") + file_name;
+
+            throw neural_network::ioerror(msg.c_str());
+        }
+
+        struct stat st;
+
+        if (fstat(fd, &st) != 0)
+        {
+            close(fd);
+
+            std::string msg = std::string("Unable to stat file: ") + file_name;
+
+            throw neural_network::ioerror(msg.c_str());
+        }
+
+        size_ = st.st_size;
+
+        if (size_ > 0)
+        {
+            void *m = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (m == MAP_FAILED)
+            {
+                close(fd);
+
+                std::string msg = std::string("Unable to map file: ") + file_name;
+
+                throw neural_network::ioerror(msg.c_str());
+            }
+
+            data_ = static_cast<const unsigned char *>(m);
+        }
+
+        close(fd);
+    }
+
+    ~mapped_network_file(void)
+    {
+        if (data_ != nullptr)
+        {
+            munmap(const_cast<unsigned char *>(data_), size_);
+        }
+    }
+
+    const unsigned char *data(void) const { return data_; }
+
+    size_t size(void) const { return size_; }
+
+private:
+
+    const unsigned char *data_;
+    size_t size_;
+};
+
+static size_t parse_binary_header(const mapped_network_file &mf,
+                                  const std::string &file_name,
+                                  unsigned int &inputs,
+                                  neural_network::layers_architecture &la,
+                                  std::vector<neuron::activate_function_class> &af)
+{
+    const unsigned char *p = mf.data();
+
+    if (mf.size() < binary_fixed_header_size || memcmp(p, binary_magic, sizeof(binary_magic)) != 0)
+    {
+        std::string msg = std::string("Not a binary network file: ") + file_name;
+
+        throw neural_network::general_exception(msg.c_str());
+    }
+
+    if (get_le32(p + 8) != binary_version)
+    {
+        std::string msg = std::string("Unsupported binary network version: ") + file_name;
+
+        throw neural_network::general_exception(msg.c_str());
+    }
+
+    inputs = get_le32(p + 12);
+    uint32_t layers = get_le32(p + 16);
+
+    size_t header_size = binary_fixed_header_size + 8*static_cast<size_t>(layers);
+
+    if (mf.size() < header_size)
+    {
+        std::string msg = std::string("Truncated binary network file: ") + file_name;
+
+        throw neural_network::general_exception(msg.c_str());
+    }
+
+    la.clear();
+    af.clear();
+
+    for (uint32_t i = 0; i < layers; i++)
+    {
+        la.push_back(get_le32(p + binary_fixed_header_size + 8*i));
+        af.push_back(static_cast<neuron::activate_function_class>(get_le32(p + binary_fixed_header_size + 8*i + 4)));
+    }
+
+    return header_size;
+}
+
+void neural_network::save_network_binary(const std::string &file_name) const
+{
+    std::string data(binary_magic, sizeof(binary_magic));
+
+    put_le32(data, binary_version);
+    put_le32(data, inputs_);
+    put_le32(data, internal_network_.size());
+    put_le32(data, 0);
+
+    for (auto &l : internal_network_)
+    {
+        put_le32(data, l.size());
+        put_le32(data, l.size() ? l.at(0).get_activate_function() : 0);
+    }
+
+    for (auto &l : internal_network_)
+    {
+        for (auto &n : l)
+        {
+            put_le_doubles(data, n.get_weights(), n.get_weights_number());
+        }
+    }
+
+    //
+    // The loader maps the file, so it must never be truncated
+    // in place. Write a temporary file, flush it to disk and
+    // atomically rename it over the target.
+    //
+
+    std::string tmp_file_name = file_name + ".tmp";
+
+    int fd = open(tmp_file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (fd < 0)
+    {
+        std::string msg = std::string("Unable to open file for write: ") + tmp_file_name;
+        throw ioerror(msg.c_str());
+    }
+
+    const char *p = data.c_str();
+    size_t left = data.length();
+
+    while (left > 0)
+    {
+        ssize_t n = write(fd, p, left);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            close(fd);
+            unlink(tmp_file_name.c_str());
+
+            std::string msg = std::string("Unable to write file: ") + tmp_file_name;
+            throw ioerror(msg.c_str());
+        }
+
+        p += n;
+        left -= n;
+    }
+
+    if (fsync(fd) != 0 || close(fd) != 0)
+    {
+        unlink(tmp_file_name.c_str());
+
+        std::string msg = std::string("Unable to flush file: ") + tmp_file_name;
+        throw ioerror(msg.c_str());
+    }
+
+    if (rename(tmp_file_name.c_str(), file_name.c_str()) != 0)
+    {
+        unlink(tmp_file_name.c_str());
+
+        std::string msg = std::string("Unable to rename ") + tmp_file_name
+                          + std::string(" to ") + file_name;
+        throw ioerror(msg.c_str());
+    }
+}
+
+void neural_network::load_network_binary(const std::string &file_name)
+{
+    mapped_network_file mf(file_name);
+
+    unsigned int inputs;
+    layers_architecture la;
+    std::vector<neuron::activate_function_class> af;
+
+    size_t offset = parse_binary_header(mf, file_name, inputs, la, af);
+
+    //
+    // Architecture has to match exactly.
+    //
+
+    bool match = (inputs == inputs_ && la.size() == internal_network_.size());
+
+    for (size_t i = 0; match && i < la.size(); i++)
+    {
+        match = (la[i] == internal_network_[i].size());
+    }
+
+    if (! match)
+    {
+        std::string msg = std::string("Network architecture mismatch in file: ") + file_name;
+
+        throw general_exception(msg.c_str());
+    }
+
+    size_t total = offset;
+
+    for (auto &l : internal_network_)
+    {
+        for (auto &n : l)
+        {
+            total += n.get_weights_number()*sizeof(double);
+        }
+    }
+
+    if (mf.size() != total)
+    {
+        std::string msg = std::string("Invalid size of binary network file: ") + file_name;
+
+        throw general_exception(msg.c_str());
+    }
+
+    std::vector<double> w;
+
+    for (size_t i = 0; i < internal_network_.size(); i++)
+    {
+        for (auto &n : internal_network_[i])
+        {
+            w.resize(n.get_weights_number());
+            get_le_doubles(mf.data() + offset, w.data(), w.size());
+            n.set_weights(w.data());
+            offset += w.size()*sizeof(double);
+
+            if (n.get_activate_function() != af[i])
+            {
+                n.set_activate_function(af[i]);
+            }
+        }
+    }
+
+    file_name_ = file_name;
+}
+
+std::uint64_t neural_network::weights_fingerprint(void) const
+{
+    std::uint64_t h = 14695981039346656037ULL;
+
+    auto mix = [&h](std::uint64_t v)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            h ^= (v >> (8*i)) & 0xff;
+            h *= 1099511628211ULL;
+        }
+    };
+
+    mix(inputs_);
+    mix(internal_network_.size());
+
+    for (auto &l : internal_network_)
+    {
+        mix(l.size());
+
+        for (auto &n : l)
+        {
+            const double *w = n.get_weights();
+
+            mix(n.get_weights_number());
+
+            for (size_t i = 0; i < n.get_weights_number(); i++)
+            {
+                std::uint64_t u;
+                memcpy(&u, &w[i], sizeof(u));
+
+                mix(u);
+            }
+        }
+    }
+
+    return h;
+}
+
+bool neural_network::is_binary_file(const std::string &file_name)
+{
+    std::ifstream is(file_name, std::ifstream::binary);
+    char magic[sizeof(binary_magic)];
+
+    if (! is.read(magic, sizeof(magic)))
+    {
+        return false;
+    }
+
+    return memcmp(magic, binary_magic, sizeof(binary_magic)) == 0;
+}
+
+bool neural_network::has_binary_extension(const std::string &file_name)
+{
+    static const std::string ext = ".nnb";
+
+    return file_name.length() >= ext.length() &&
+           file_name.compare(file_name.length() - ext.length(), ext.length(), ext) == 0;
+}
+
+void neural_network::read_binary_header(const std::string &file_name,
+                                        unsigned int &inputs,
+                                        layers_architecture &la,
+                                        std::vector<neuron::activate_function_class> &af)
+{
+    mapped_network_file mf(file_name);
+
+    parse_binary_header(mf, file_name, inputs, la, af);
+}
+
 #ifdef USE_CJSON
 void neural_network::load_network(const std::string &file_name)
 {
+    if (is_binary_file(file_name))
+    {
+        load_network_binary(file_name);
+
+        return;
+    }
+
     file_name_ = file_name;
 
     std::ifstream is(file_name_, std::ifstream::binary);
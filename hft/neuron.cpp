@@ -15,6 +15,7 @@
 \**********************************************************************/
 
 #include <random>
+#include <mutex>
 #include <cmath>
 #include <limits>
 #include <sstream>
@@ -29,24 +30,41 @@ static el::Logger *logger = nullptr;
 #define hft_log(__X__) \
     CLOG(__X__, "neuron")
 
-neuron::neuron(size_t inputs, double lc)
+//
+// Random device is shared, so it is queried under lock,
+// once per thread.
+//
+
+static std::mt19937 &default_weights_generator(void)
+{
+    static std::mutex rd_mtx;
+    static std::random_device rd;
+
+    thread_local std::mt19937 generator([]()
+    {
+        std::lock_guard<std::mutex> lck(rd_mtx);
+
+        return rd();
+    }());
+
+    return generator;
+}
+
+neuron::neuron(size_t inputs, double lc, std::mt19937 *rng)
     : pins_(inputs), weights_(inputs), learn_coefficient_(lc),
-      function_type_(SIGMOID), argument_(0.0), output_(0.0)
+      function_type_(SIGMOID), accuracy_(hft::ACTIVATION_EXACT),
+      sigmoid_(nullptr), argument_(0.0), output_(0.0)
 {
     //
     // Randimize weight.
     //
 
-    static std::random_device rd;
-
-    std::mt19937 rng(rd());    // Random-number engine used (Mersenne-Twister in this case).
+    std::mt19937 &generator = (rng != nullptr ? *rng : default_weights_generator());
     std::uniform_int_distribution<int> uni(100, 10000); // Guaranteed unbiased.
 
-    int random_integer;
-
     for (int i = 0; i < weights_.size(); i++)
     {
-        weights_.at(i) = double(uni(rng)) / 10000.0;
+        weights_.at(i) = double(uni(generator)) / 10000.0;
         weights_.at(i) /= weights_.size();
     }
 
@@ -267,6 +285,25 @@ double neuron::activate_function(void) const
 {
     double x = argument_;
 
+    if (sigmoid_ != nullptr)
+    {
+        switch (function_type_)
+        {
+            case SIGMOID:
+                return (*sigmoid_)(x);
+            case SIGMOID_BIPOLAR:
+                return 2.0*(*sigmoid_)(x) - 1.0;
+            case LINE:
+                return x;
+            default:
+                throw invalid_objec_state("Unknown activate function");
+        }
+    }
+
+    //
+    // Reference implementation.
+    //
+
     switch (function_type_)
     {
         case SIGMOID:
@@ -286,6 +323,31 @@ double neuron::activate_derived_function(void) const
 {
     double x = argument_;
 
+    if (sigmoid_ != nullptr)
+    {
+        //
+        // Derivatives expressed by output of last „fire”:
+        // σ' = σ(1 - σ), and for bipolar f = 2σ - 1
+        // f' = (1 - f²)/2.
+        //
+
+        switch (function_type_)
+        {
+            case SIGMOID:
+                return output_*(1.0 - output_);
+            case SIGMOID_BIPOLAR:
+                return 0.5*(1.0 - output_*output_);
+            case LINE:
+                return 1.0;
+            default:
+                throw invalid_objec_state("Unknown activate function");
+        }
+    }
+
+    //
+    // Reference implementation.
+    //
+
     switch (function_type_)
     {
         case SIGMOID:
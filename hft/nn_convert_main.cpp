@@ -0,0 +1,247 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <memory>
+#include <cstdio>
+
+#include <boost/program_options.hpp>
+
+#include <easylogging++.h>
+
+#include <neural_network.hpp>
+
+namespace prog_opts = boost::program_options;
+
+static struct _nn_convert_config
+{
+    std::string input_file_name;
+    std::string output_file_name;
+    std::string activate_function;
+} nn_convert_config;
+
+#define hftOption(__X__) \
+    nn_convert_config.__X__
+
+#define hft_log(__X__) \
+    CLOG(__X__, "nn_convert")
+
+//
+// JSON file does not hold architecture explicitly, but
+// it can be restored from neuron identifiers „L<i>N<j>”
+// and number of weights of neurons in first layer.
+// Used also by „nn-quantize”.
+//
+
+void infer_json_architecture(const std::string &file_name,
+                                    unsigned int &inputs,
+                                    neural_network::layers_architecture &la)
+{
+    std::ifstream is(file_name, std::ifstream::binary);
+
+    if (! is)
+    {
+        throw std::runtime_error("Unable to open input file: " + file_name);
+    }
+
+    std::stringstream buffer;
+    buffer << is.rdbuf();
+
+    cJSON *json = cJSON_Parse(buffer.str().c_str());
+
+    if (json == NULL)
+    {
+        throw std::runtime_error("Invalid json data in file: " + file_name);
+    }
+
+    unsigned int first_layer_weights = 0;
+
+    la.clear();
+
+    for (cJSON *it = json -> child; it != NULL; it = it -> next)
+    {
+        cJSON *id_object = cJSON_GetObjectItem(it, "id");
+        cJSON *weights_array = cJSON_GetObjectItem(it, "weights");
+        unsigned int l, n;
+
+        if (id_object == NULL || weights_array == NULL ||
+            id_object -> valuestring == NULL ||
+            sscanf(id_object -> valuestring, "L%uN%u", &l, &n) != 2)
+        {
+            cJSON_Delete(json);
+
+            throw std::runtime_error("Unrecognized neuron in file: " + file_name);
+        }
+
+        if (la.size() <= l)
+        {
+            la.resize(l + 1, 0);
+        }
+
+        la[l] = std::max(la[l], n + 1);
+
+        if (l == 0)
+        {
+            first_layer_weights = cJSON_GetArraySize(weights_array);
+        }
+    }
+
+    cJSON_Delete(json);
+
+    if (la.empty() || first_layer_weights < 2)
+    {
+        throw std::runtime_error("Unable to recognize network architecture in file: " + file_name);
+    }
+
+    //
+    // Last weight is for constant input.
+    //
+
+    inputs = (first_layer_weights - 1) * la[0];
+}
+
+int hft_nn_convert_main(int argc, char *argv[])
+{
+    //
+    // Define default logger configuration.
+    //
+
+    el::Configurations logger_cfg;
+    logger_cfg.setToDefault();
+    logger_cfg.parseFromText("* GLOBAL:\n"
+                             " FORMAT               =  \"%datetime %level [%logger] %msg\"\n"
+                             " FILENAME             =  \"/dev/null\"\n"
+                             " ENABLED              =  true\n"
+                             " TO_FILE              =  false\n"
+                             " TO_STANDARD_OUTPUT   =  true\n"
+                             " SUBSECOND_PRECISION  =  1\n"
+                             " PERFORMANCE_TRACKING =  true\n"
+                             " MAX_LOG_FILE_SIZE    =  10485760 ## 10MiB\n"
+                             " LOG_FLUSH_THRESHOLD  =  1 ## Flush after every single log\n"
+                            );
+    el::Loggers::setDefaultConfigurations(logger_cfg);
+
+    START_EASYLOGGINGPP(argc, argv);
+
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("nn-convert", "")
+    ;
+
+    prog_opts::options_description desc("Options for neural network file converter");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("input-file,i",  prog_opts::value<std::string>(&hftOption(input_file_name) ), "input network file (JSON or binary, recognized automatically)")
+        ("output-file,o", prog_opts::value<std::string>(&hftOption(output_file_name) ), "output network file, binary if has „.nnb” extension, JSON otherwise")
+        ("activate-function,a", prog_opts::value<std::string>(&hftOption(activate_function)) -> default_value("sigmoid-bipolar"), "activate function of all layers for JSON input (sigmoid, sigmoid-bipolar, line)")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).run(), vm);
+    prog_opts::notify(vm);
+
+    //
+    // If user requested help, show help and quit
+    // ignoring other options, if any.
+    //
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    el::Logger *logger = el::Loggers::getLogger("nn_convert", true);
+
+    if (! vm.count("input-file") || ! vm.count("output-file"))
+    {
+        hft_log(ERROR) << "Both input and output files are required";
+
+        return 1;
+    }
+
+    unsigned int inputs;
+    neural_network::layers_architecture la;
+    std::vector<neuron::activate_function_class> af;
+
+    bool binary = neural_network::is_binary_file(hftOption(input_file_name));
+
+    if (binary)
+    {
+        neural_network::read_binary_header(hftOption(input_file_name), inputs, la, af);
+    }
+    else
+    {
+        infer_json_architecture(hftOption(input_file_name), inputs, la);
+
+        neuron::activate_function_class f;
+
+        if (hftOption(activate_function) == "sigmoid")
+        {
+            f = neuron::activate_function_class::SIGMOID;
+        }
+        else if (hftOption(activate_function) == "sigmoid-bipolar")
+        {
+            f = neuron::activate_function_class::SIGMOID_BIPOLAR;
+        }
+        else if (hftOption(activate_function) == "line")
+        {
+            f = neuron::activate_function_class::LINE;
+        }
+        else
+        {
+            hft_log(ERROR) << "Unknown activate function „" << hftOption(activate_function) << "”";
+
+            return 1;
+        }
+
+        af.assign(la.size(), f);
+    }
+
+    std::ostringstream arch;
+
+    for (size_t i = 0; i < la.size(); i++)
+    {
+        arch << (i ? " " : "") << la[i];
+    }
+
+    hft_log(INFO) << "Network [" << hftOption(input_file_name) << "] "
+                  << (binary ? "binary" : "JSON") << ", inputs ["
+                  << inputs << "], layers [" << arch.str() << "].";
+
+    neural_network net(inputs, la);
+
+    for (size_t i = 0; i < af.size(); i++)
+    {
+        net.set_activate_function(i, af[i]);
+    }
+
+    net.load_network(hftOption(input_file_name));
+    net.save_network(hftOption(output_file_name));
+
+    hft_log(INFO) << "Saved as [" << hftOption(output_file_name) << "] "
+                  << (neural_network::has_binary_extension(hftOption(output_file_name)) ? "binary" : "JSON")
+                  << ".";
+
+    return 0;
+}
@@ -0,0 +1,385 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+
+#include <boost/program_options.hpp>
+
+#include <easylogging++.h>
+
+#include <neural_network.hpp>
+#include <quantized_network.hpp>
+#include <decision_trigger.hpp>
+#include <hftr_samples.hpp>
+#include <text_file_reader.hpp>
+
+namespace prog_opts = boost::program_options;
+
+static struct _nn_quantize_config
+{
+    std::vector<std::string> network_file_names;
+    std::string calibration_file_name;
+    std::string validation_file_name;
+    std::string activate_function;
+    std::string rule;
+    double vote_ratio;
+    size_t calibration_samples;
+} nn_quantize_config;
+
+#define hftOption(__X__) \
+    nn_quantize_config.__X__
+
+#define hft_log(__X__) \
+    CLOG(__X__, "nn_quantize")
+
+extern void infer_json_architecture(const std::string &file_name,
+                                    unsigned int &inputs,
+                                    neural_network::layers_architecture &la);
+
+//
+// Quantized network is saved next to the
+// float one, with „.nnq” extension.
+//
+
+static std::string quantized_file_name(const std::string &file_name)
+{
+    size_t slash = file_name.find_last_of('/');
+    size_t dot = file_name.find_last_of('.');
+
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+    {
+        return file_name + ".nnq";
+    }
+
+    return file_name.substr(0, dot) + ".nnq";
+}
+
+static std::shared_ptr<neural_network> load_float_network(const std::string &file_name,
+                                                          neuron::activate_function_class json_af)
+{
+    unsigned int inputs;
+    neural_network::layers_architecture la;
+    std::vector<neuron::activate_function_class> af;
+
+    if (neural_network::is_binary_file(file_name))
+    {
+        neural_network::read_binary_header(file_name, inputs, la, af);
+    }
+    else
+    {
+        infer_json_architecture(file_name, inputs, la);
+        af.assign(la.size(), json_af);
+    }
+
+    std::shared_ptr<neural_network> net = std::make_shared<neural_network>(inputs, la);
+
+    for (size_t i = 0; i < af.size(); i++)
+    {
+        net -> set_activate_function(i, af[i]);
+    }
+
+    net -> load_network(file_name);
+
+    return net;
+}
+
+static bool hit(decision_type d, double expected)
+{
+    return (d == DECISION_LONG && expected > 0.0) || (d == DECISION_SHORT && expected < 0.0);
+}
+
+int hft_nn_quantize_main(int argc, char *argv[])
+{
+    //
+    // Define default logger configuration.
+    //
+
+    el::Configurations logger_cfg;
+    logger_cfg.setToDefault();
+    logger_cfg.parseFromText("* GLOBAL:\n"
+                             " FORMAT               =  \"%datetime %level [%logger] %msg\"\n"
+                             " FILENAME             =  \"/dev/null\"\n"
+                             " ENABLED              =  true\n"
+                             " TO_FILE              =  false\n"
+                             " TO_STANDARD_OUTPUT   =  true\n"
+                             " SUBSECOND_PRECISION  =  1\n"
+                             " PERFORMANCE_TRACKING =  true\n"
+                             " MAX_LOG_FILE_SIZE    =  10485760 ## 10MiB\n"
+                             " LOG_FLUSH_THRESHOLD  =  1 ## Flush after every single log\n"
+                            );
+    el::Loggers::setDefaultConfigurations(logger_cfg);
+
+    START_EASYLOGGINGPP(argc, argv);
+
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("nn-quantize", "")
+        ("network", prog_opts::value<std::vector<std::string> >(&hftOption(network_file_names)), "")
+    ;
+
+    prog_opts::positional_options_description positional;
+    positional.add("network", -1);
+
+    prog_opts::options_description desc("Usage: hft nn-quantize [options] network...\n\n"
+                                        "Quantizes networks to int8 weights and int16 activations,\n"
+                                        "saved next to float networks with „.nnq” extension.\n\n"
+                                        "Options");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("calibration,c", prog_opts::value<std::string>(&hftOption(calibration_file_name)), "HFTR sample used to calibrate activation ranges")
+        ("samples,s", prog_opts::value<size_t>(&hftOption(calibration_samples)) -> default_value(10000), "maximum number of calibration records (0 - all)")
+        ("validation,v", prog_opts::value<std::string>(&hftOption(validation_file_name)), "HFTR file for accuracy report of quantized vs float networks")
+        ("rule,r", prog_opts::value<std::string>(&hftOption(rule)) -> default_value("<0,1> = LONG; <-1,0> = SHORT"), "decision rule of network output, as in manifest")
+        ("vote-ratio,V", prog_opts::value<double>(&hftOption(vote_ratio)) -> default_value(0.7), "vote ratio of networks ensemble, as in manifest")
+        ("activate-function,a", prog_opts::value<std::string>(&hftOption(activate_function)) -> default_value("sigmoid-bipolar"), "activate function of all layers for JSON input (sigmoid, sigmoid-bipolar, line)")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).positional(positional).run(), vm);
+    prog_opts::notify(vm);
+
+    //
+    // If user requested help, show help and quit
+    // ignoring other options, if any.
+    //
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    el::Logger *logger = el::Loggers::getLogger("nn_quantize", true);
+
+    if (hftOption(network_file_names).empty() || ! vm.count("calibration"))
+    {
+        hft_log(ERROR) << "At least one network and calibration HFTR file are required";
+
+        return 1;
+    }
+
+    neuron::activate_function_class json_af;
+
+    if (hftOption(activate_function) == "sigmoid")
+    {
+        json_af = neuron::activate_function_class::SIGMOID;
+    }
+    else if (hftOption(activate_function) == "sigmoid-bipolar")
+    {
+        json_af = neuron::activate_function_class::SIGMOID_BIPOLAR;
+    }
+    else if (hftOption(activate_function) == "line")
+    {
+        json_af = neuron::activate_function_class::LINE;
+    }
+    else
+    {
+        hft_log(ERROR) << "Unknown activate function „" << hftOption(activate_function) << "”";
+
+        return 1;
+    }
+
+    hftr_samples calibration;
+
+    {
+        text_file_reader reader(hftOption(calibration_file_name));
+        calibration.load(reader, hftOption(calibration_samples));
+    }
+
+    hft_log(INFO) << "Loaded [" << calibration.size() << "] calibration records from ["
+                  << hftOption(calibration_file_name) << "].";
+
+    std::vector<std::shared_ptr<neural_network> > float_networks;
+    std::vector<std::shared_ptr<quantized_network> > quantized_networks;
+
+    for (auto &file_name : hftOption(network_file_names))
+    {
+        std::shared_ptr<neural_network> net = load_float_network(file_name, json_af);
+        std::shared_ptr<quantized_network> qnet = std::make_shared<quantized_network>(*net, calibration);
+
+        std::string output_file_name = quantized_file_name(file_name);
+        qnet -> save(output_file_name);
+
+        hft_log(INFO) << "Network [" << file_name << "] quantized, saved as ["
+                      << output_file_name << "].";
+
+        float_networks.push_back(net);
+        quantized_networks.push_back(qnet);
+    }
+
+    if (! vm.count("validation"))
+    {
+        return 0;
+    }
+
+    //
+    // Accuracy report: outputs and decisions of
+    // quantized networks against float ones.
+    //
+
+    hftr_samples validation(hftOption(validation_file_name));
+    decision_trigger decision(hftOption(rule));
+
+    const size_t N = validation.size();
+    const size_t M = float_networks.size();
+
+    if (N == 0)
+    {
+        hft_log(ERROR) << "Empty validation file [" << hftOption(validation_file_name) << "]";
+
+        return 1;
+    }
+
+    std::vector<double> max_error(M, 0.0), sum_error(M, 0.0);
+    std::vector<size_t> agree(M, 0), float_hits(M, 0), quantized_hits(M, 0);
+    std::vector<std::vector<decision_type> > float_decisions(M, std::vector<decision_type>(N));
+    std::vector<std::vector<decision_type> > quantized_decisions(M, std::vector<decision_type>(N));
+    std::chrono::nanoseconds float_time(0), quantized_time(0);
+
+    for (size_t m = 0; m < M; m++)
+    {
+        neural_network &net = *float_networks[m];
+        quantized_network &qnet = *quantized_networks[m];
+
+        if (net.get_number_of_inputs() != validation.get_inputs())
+        {
+            hft_log(ERROR) << "Validation file does not match input bus of network ["
+                           << hftOption(network_file_names)[m] << "]";
+
+            return 1;
+        }
+
+        for (size_t s = 0; s < N; s++)
+        {
+            const double *pins = validation.get_pins(s);
+
+            auto t0 = std::chrono::steady_clock::now();
+
+            net.reset_input_bus();
+
+            for (unsigned int i = 0; i < validation.get_inputs(); i++)
+            {
+                net.set_pin(i, pins[i]);
+            }
+
+            net.fire();
+
+            auto t1 = std::chrono::steady_clock::now();
+
+            qnet.fire(pins);
+
+            auto t2 = std::chrono::steady_clock::now();
+
+            float_time += t1 - t0;
+            quantized_time += t2 - t1;
+
+            double fo = net.get_output(0);
+            double qo = qnet.get_output(0);
+            double err = std::fabs(fo - qo);
+
+            max_error[m] = std::max(max_error[m], err);
+            sum_error[m] += err;
+
+            float_decisions[m][s] = decision(fo);
+            quantized_decisions[m][s] = decision(qo);
+
+            agree[m] += (float_decisions[m][s] == quantized_decisions[m][s]);
+            float_hits[m] += hit(float_decisions[m][s], validation.get_expected(s));
+            quantized_hits[m] += hit(quantized_decisions[m][s], validation.get_expected(s));
+        }
+    }
+
+    //
+    // Ensemble vote, the same way as expert advisor does.
+    //
+
+    auto vote = [&](const std::vector<std::vector<decision_type> > &d, size_t s)
+    {
+        unsigned int voting[2] = {0, 0};
+
+        for (size_t m = 0; m < M; m++)
+        {
+            voting[0] += (d[m][s] == DECISION_SHORT);
+            voting[1] += (d[m][s] == DECISION_LONG);
+        }
+
+        if (static_cast<double>(voting[0]) / M >= hftOption(vote_ratio))
+        {
+            return DECISION_SHORT;
+        }
+        else if (static_cast<double>(voting[1]) / M >= hftOption(vote_ratio))
+        {
+            return DECISION_LONG;
+        }
+
+        return NO_DECISION;
+    };
+
+    size_t vote_agree = 0, float_vote_hits = 0, quantized_vote_hits = 0;
+    size_t float_votes = 0, quantized_votes = 0;
+
+    for (size_t s = 0; s < N; s++)
+    {
+        decision_type fv = vote(float_decisions, s);
+        decision_type qv = vote(quantized_decisions, s);
+
+        vote_agree += (fv == qv);
+        float_votes += (fv != NO_DECISION);
+        quantized_votes += (qv != NO_DECISION);
+        float_vote_hits += hit(fv, validation.get_expected(s));
+        quantized_vote_hits += hit(qv, validation.get_expected(s));
+    }
+
+    auto percent = [](size_t a, size_t b)
+    {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(2) << (b ? 100.0 * a / b : 0.0) << "%";
+
+        return os.str();
+    };
+
+    std::cout << "\nAccuracy report on [" << hftOption(validation_file_name) << "], "
+              << N << " records:\n\n";
+
+    for (size_t m = 0; m < M; m++)
+    {
+        std::cout << "  " << hftOption(network_file_names)[m] << "\n"
+                  << "    output error max/mean: " << max_error[m] << " / " << sum_error[m] / N << "\n"
+                  << "    decision agreement:    " << percent(agree[m], N) << "\n"
+                  << "    hits float/quantized:  " << percent(float_hits[m], N)
+                  << " / " << percent(quantized_hits[m], N) << "\n";
+    }
+
+    std::cout << "\n  Ensemble vote (ratio " << hftOption(vote_ratio) << ")\n"
+              << "    vote agreement:        " << percent(vote_agree, N) << "\n"
+              << "    votes float/quantized: " << float_votes << " / " << quantized_votes << "\n"
+              << "    hits float/quantized:  " << percent(float_vote_hits, float_votes)
+              << " / " << percent(quantized_vote_hits, quantized_votes) << "\n\n"
+              << "  Inference time per network float/quantized: "
+              << float_time.count() / (N*M) << " / " << quantized_time.count() / (N*M) << " ns\n\n";
+
+    return 0;
+}
@@ -15,18 +15,14 @@
 \**********************************************************************/
 
 
-#include <errno.h>
-#include <sys/types.h>
-#include <sys/inotify.h>
-#include <unistd.h>
-#include <poll.h>
-
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <stdexcept>
 #include <sstream>
-#include <map>
+#include <vector>
 
 #include <easylogging++.h>
 #include <boost/filesystem.hpp>
@@ -35,6 +31,8 @@
 #include <boost/lexical_cast.hpp>
 
 #include <overnight_swaps.hpp>
+#include <hft_utils.hpp>
+#include <file_watch_service.hpp>
 #include <custom_except.hpp>
 #include <text_file_reader.hpp>
 
@@ -42,33 +40,11 @@
     CLOG(__X__, "overnight_swaps")
 
 //
-// Auxiliary class for monitoring change of
-// file with overnight swaps table.
+// Immutable table of swaps, indexed by instrument type.
+// Once created, it is never modified, reload creates
+// new instance which is published atomically.
 //
 
-#define DIR_MONITOR_EVENT_SIZE    (sizeof(struct inotify_event))
-#define DIR_MONITOR_EVENT_BUF_LEN (1024 * (DIR_MONITOR_EVENT_SIZE + 16))
-
-class dir_monitor
-{
-public:
-
-    DEFINE_CUSTOM_EXCEPTION_CLASS(exception, std::runtime_error)
-
-    dir_monitor(const std::string &d);
-    dir_monitor(void) = delete;
-    ~dir_monitor(void);
-
-    bool has_changed(const std::string &f);
-
-private:
-
-    int fd_;
-    int wd_;
-    char buffer_[DIR_MONITOR_EVENT_BUF_LEN];
-    std::string dir_;
-};
-
 class swaps_table
 {
 public:
@@ -77,153 +53,27 @@ public:
     swaps_table(void) = delete;
     ~swaps_table(void);
 
-    bool is_positive_swap_long(const std::string &instrument_str) const;
-    bool is_positive_swap_short(const std::string &instrument_str) const;
+    bool is_positive_swap_long(hft::instrument_type t) const;
+    bool is_positive_swap_short(hft::instrument_type t) const;
 
 private:
 
-    void process_swaps_table_line(std::string &line);
-
-    std::map<std::string, std::pair<bool, bool> > swaps_;
-};
-
-dir_monitor::dir_monitor(const std::string &d)
-    : dir_(d)
-{
-    hft_log(INFO) << "Creating directory monitor instance for ["
-                  << d << "]";
-
-    //
-    // Creating the INOTIFY instance.
-    //
-
-    fd_ = ::inotify_init();
-
-    if (fd_ == -1)
-    {
-        std::ostringstream err_msg;
-
-        err_msg << "Failed to initialize dir_monitor for directory ["
-                << dir_ << "]: inotify_init failed with system error [";
-
-        switch (errno)
-        {
-            case EMFILE:
-                err_msg << "EMFILE] - The user limit on the total number of inotify instances has been reached.";
-                break;
-            case ENFILE:
-                err_msg << "ENFILE] - The system limit on the total number of file descriptors has been reached.";
-                break;
-            case ENOMEM:
-                err_msg << "ENOMEM] - Insufficient kernel memory is available.";
-                break;
-            default:
-                /* Should never happen. */
-                err_msg << "?] - Unknown";
-        }
-
-        throw exception(err_msg.str());
-    }
-
-    wd_ = ::inotify_add_watch(fd_, d.c_str(), IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO);
-
-    if (wd_ == -1)
+    enum
     {
-        std::ostringstream err_msg;
-
-        err_msg << "Failed to initialize dir_monitor for directory ["
-                << dir_ << "]: inotify_add_watch failed with system error [";
-
-        switch (errno)
-        {
-            case EACCES:
-                err_msg << "EACCES] - Read access to the given file is not permitted.";
-                break;
-            case EBADF:
-                err_msg << "EBADF] - The given file descriptor is not valid.";
-                break;
-            case EFAULT:
-                err_msg << "EFAULT] - Pathname points outside of the process's accessible address space.";
-                break;
-            case EINVAL:
-                err_msg << "EINVAL] - The given event mask contains no valid events; or fd is not an inotify file descriptor.";
-                break;
-            case ENOENT:
-                err_msg << "ENOENT] - A directory component in pathname does not exist or is a dangling symbolic link.";
-                break;
-            case ENOMEM:
-                err_msg << "ENOMEM] - Insufficient kernel memory was available.";
-                break;
-            case ENOSPC:
-                err_msg << "ENOSPC] - The user limit on the total number of inotify watches was "
-                        << "reached or the kernel failed to allocate a needed resource.";
-                break;
-            default:
-                /* Should never happen. */
-                err_msg << "?] - Unknown";
-        }
-
-        throw exception(err_msg.str());
-    }
-}
-
-dir_monitor::~dir_monitor(void)
-{
-    hft_log(INFO) << "Destroying directory monitor instance for ["
-                  << dir_ << "]";
-
-    //
-    // Removing directory from the watch list.
-    //
-
-    ::inotify_rm_watch(fd_, wd_);
-
-    //
-    // Closing the INOTIFY instance.
-    //
-
-    ::close(fd_);
-}
-
-bool dir_monitor::has_changed(const std::string &f)
-{
-    int length, i = 0;
-    struct pollfd pfd = { .fd = fd_, .events = POLLIN };
-
-    if (::poll(&pfd, 1, 0) != 1)
-    {
-        //
-        // Nothing has changed.
-        //
-
-        return false;
-    }
-
-    length = ::read(fd_, buffer_, DIR_MONITOR_EVENT_BUF_LEN);
-
-    //
-    // Actually read return the list of change
-    // events happens. Here, read the change
-    // event one by one and process it
-    // accordingly.
-    //
+        SWAP_KNOWN          = 0x01,
+        SWAP_LONG_POSITIVE  = 0x02,
+        SWAP_SHORT_POSITIVE = 0x04
+    };
 
-    while (i < length)
-    {
-        struct inotify_event *event = (struct inotify_event *) &buffer_[i];
-
-        if (event -> len && std::string(event -> name) == f)
-        {
-            return true;
-        }
+    void process_swaps_table_line(std::string &line);
 
-        i += DIR_MONITOR_EVENT_SIZE + event -> len;
-    }
+    void log_unknown_instrument(hft::instrument_type t) const;
 
-    return false;
-}
+    std::vector<unsigned char> swaps_;
+};
 
 swaps_table::swaps_table(const std::string &swaps_table_full_path)
+    : swaps_(hft::get_instruments_number(), 0)
 {
     hft_log(INFO) << "Creating swaps table instance for data ["
                   << swaps_table_full_path << "]";
@@ -242,11 +92,16 @@ swaps_table::swaps_table(const std::string &swaps_table_full_path)
 
     text_file_reader swaps_file(swaps_table_full_path);
     std::string line;
-    bool is_eof = false;
+    bool has_more = true;
 
-    while (! is_eof)
+    //
+    // Last line may be not terminated by new line,
+    // so it is processed even if reader reports EOF.
+    //
+
+    while (has_more)
     {
-        is_eof = swaps_file.read_line(line);
+        has_more = swaps_file.read_line(line);
 
         boost::trim(line);
 
@@ -261,12 +116,17 @@ swaps_table::swaps_table(const std::string &swaps_table_full_path)
     hft_log(INFO) << "| Instrument | LONG | SHORT |";
     hft_log(INFO) << "+------------+------+-------+";
 
-    for (auto &item : swaps_)
+    for (hft::instrument_type t = 0; t < swaps_.size(); t++)
     {
-        hft_log(INFO) << "|   " << item.first << "   |   "
-                      << (item.second.first ? '+' : '-')
+        if (! (swaps_[t] & SWAP_KNOWN))
+        {
+            continue;
+        }
+
+        hft_log(INFO) << "|   " << hft::get_instrument_name(t) << "   |   "
+                      << ((swaps_[t] & SWAP_LONG_POSITIVE) ? '+' : '-')
                       << "  |   "
-                      << (item.second.second ? '+' : '-')
+                      << ((swaps_[t] & SWAP_SHORT_POSITIVE) ? '+' : '-')
                       << "   |";
     }
 
@@ -278,40 +138,37 @@ swaps_table::~swaps_table(void)
     hft_log(INFO) << "Destroying swaps table";
 }
 
-bool swaps_table::is_positive_swap_long(const std::string &instrument_str) const
+void swaps_table::log_unknown_instrument(hft::instrument_type t) const
 {
-    std::map<std::string, std::pair<bool, bool> >::const_iterator it;
+    const char *name = hft::get_instrument_name(t);
 
-    it = swaps_.find(instrument_str);
+    CLOG_EVERY_N(1000, ERROR, "overnight_swaps") << "No instrument ["
+                                                 << (name ? name : "?")
+                                                 << "] in swap table!";
+}
 
-    if (it == swaps_.end())
+bool swaps_table::is_positive_swap_long(hft::instrument_type t) const
+{
+    if (t >= swaps_.size() || ! (swaps_[t] & SWAP_KNOWN))
     {
-        CLOG_EVERY_N(1000, ERROR, "overnight_swaps") << "No instrument ["
-                                                     << instrument_str
-                                                     << "] in swap table!";
+        log_unknown_instrument(t);
 
         return false;
     }
 
-    return it -> second.first;
+    return (swaps_[t] & SWAP_LONG_POSITIVE);
 }
 
-bool swaps_table::is_positive_swap_short(const std::string &instrument_str) const
+bool swaps_table::is_positive_swap_short(hft::instrument_type t) const
 {
-    std::map<std::string, std::pair<bool, bool> >::const_iterator it;
-
-    it = swaps_.find(instrument_str);
-
-    if (it == swaps_.end())
+    if (t >= swaps_.size() || ! (swaps_[t] & SWAP_KNOWN))
     {
-        CLOG_EVERY_N(1000, ERROR, "overnight_swaps") << "No instrument ["
-                                                     << instrument_str
-                                                     << "] in swap table!";
+        log_unknown_instrument(t);
 
         return false;
     }
 
-    return it -> second.second;
+    return (swaps_[t] & SWAP_SHORT_POSITIVE);
 }
 
 void swaps_table::process_swaps_table_line(std::string &line)
@@ -322,6 +179,7 @@ void swaps_table::process_swaps_table_line(std::string &line)
     }
 
     std::string instrument;
+    hft::instrument_type t;
     bool long_swap_positive;
     bool short_swap_positive;
 
@@ -334,8 +192,9 @@ void swaps_table::process_swaps_table_line(std::string &line)
         if (n == 0)
         {
             instrument = boost::erase_all_copy(token, "/");
+            t = hft::instrument2type(instrument);
 
-            if (instrument.length() != 6)
+            if (t == hft::UNRECOGNIZED_INSTRUMENT)
             {
                 hft_log(ERROR) << "Bad instrument [" << instrument
                                << "] in line [" << line << "], skipping record.";
@@ -402,60 +261,83 @@ void swaps_table::process_swaps_table_line(std::string &line)
         return;
     }
 
-    swaps_[instrument] = std::make_pair(long_swap_positive, short_swap_positive);
+    swaps_[t] = SWAP_KNOWN
+              | (long_swap_positive ? SWAP_LONG_POSITIVE : 0)
+              | (short_swap_positive ? SWAP_SHORT_POSITIVE : 0);
 }
 
 static const std::string overnight_swaps_dir  = "/var/lib/hft/overnight_swaps";
 static const std::string overnight_swaps_file = "swap_table";
 
 static el::Logger *logger = nullptr;
-static std::shared_ptr<dir_monitor> monitor;
-static std::shared_ptr<swaps_table> table;
+static std::once_flag initialized;
 
-static void oswps_check_initialized(void)
-{
-    //
-    // Initialize logger.
-    //
+//
+// Current table is published as plain atomic pointer, so
+// lookup is a single acquire load. Replaced tables are
+// retired, never freed: a reader may still hold the old
+// pointer for an unbounded time, while tables are tiny and
+// reloaded at most a few times a day.
+//
 
-    if (logger == nullptr)
-    {
-        logger = el::Loggers::getLogger("overnight_swaps", true);
-    }
+static std::atomic<const swaps_table *> table(nullptr);
+static std::mutex publish_mtx;
+static std::vector<std::unique_ptr<const swaps_table> > retired_tables;
 
-    //
-    // Initialize directory monitor to watch
-    // directory with overnight swap table
-    // file.
-    //
+static void oswps_publish(const swaps_table *new_table)
+{
+    std::lock_guard<std::mutex> lck(publish_mtx);
 
-    if (monitor.use_count() == 0)
+    const swaps_table *old_table = table.exchange(new_table, std::memory_order_acq_rel);
+
+    if (old_table != nullptr)
     {
-        monitor.reset(new dir_monitor(overnight_swaps_dir));
+        retired_tables.emplace_back(old_table);
     }
+}
 
-    //
-    // Initialize swaps_table object.
-    //
+//
+// Loads table and subscribes file watch service for changes
+// of swap table file. Reloaded table is built in file watch
+// service thread and published atomically, so lookups never
+// wait for the file system.
+//
 
-    if (table.use_count() == 0)
-    {
-        table.reset(new swaps_table(overnight_swaps_dir + std::string("/") + overnight_swaps_file));
-    }
+static void oswps_initialize(void)
+{
+    logger = el::Loggers::getLogger("overnight_swaps", true);
 
-    //
-    // Check if swaps table file has changed, if so, reinit.
-    //
+    const std::string swaps_table_full_path = overnight_swaps_dir + std::string("/") + overnight_swaps_file;
 
-    if (monitor -> has_changed(overnight_swaps_file))
+    oswps_publish(new swaps_table(swaps_table_full_path));
+
+    file_watch_service::instance().subscribe(swaps_table_full_path, [](const std::string &file_name)
     {
         hft_log(WARNING) << "Swaps table file ["
                          << overnight_swaps_file
                          << "] has changed. "
                          << "Reinitialization...";
 
-        table.reset(new swaps_table(overnight_swaps_dir + std::string("/") + overnight_swaps_file));
+        oswps_publish(new swaps_table(file_name));
+    });
+}
+
+static inline const swaps_table *oswps_table(void)
+{
+    const swaps_table *t = table.load(std::memory_order_acquire);
+
+    if (__builtin_expect(t == nullptr, 0))
+    {
+        //
+        // Not initialized eagerly, slow path.
+        //
+
+        std::call_once(initialized, oswps_initialize);
+
+        t = table.load(std::memory_order_acquire);
     }
+
+    return t;
 }
 
 //
@@ -464,18 +346,29 @@ static void oswps_check_initialized(void)
 
 namespace hft {
 
-bool is_positive_swap_long(const std::string &instrument_str)
+void init_overnight_swaps(void)
 {
-    oswps_check_initialized();
+    std::call_once(initialized, oswps_initialize);
+}
 
-    return table -> is_positive_swap_long(instrument_str);
+bool is_positive_swap_long(instrument_type t)
+{
+    return oswps_table() -> is_positive_swap_long(t);
 }
 
-bool is_positive_swap_short(const std::string &instrument_str)
+bool is_positive_swap_short(instrument_type t)
 {
-    oswps_check_initialized();
+    return oswps_table() -> is_positive_swap_short(t);
+}
 
-    return table -> is_positive_swap_short(instrument_str);
+bool is_positive_swap_long(const std::string &instrument_str)
+{
+    return is_positive_swap_long(instrument2type(boost::erase_all_copy(instrument_str, "/")));
+}
+
+bool is_positive_swap_short(const std::string &instrument_str)
+{
+    return is_positive_swap_short(instrument2type(boost::erase_all_copy(instrument_str, "/")));
 }
 
 } /* namespace hft */
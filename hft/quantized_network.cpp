@@ -0,0 +1,596 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include <quantized_network.hpp>
+
+static const char quantized_magic[8] = { 'H', 'F', 'T', 'N', 'N', 'Q', 'N', 'T' };
+static const uint32_t quantized_version = 2;
+static const size_t quantized_fixed_header_size = 32;
+static const size_t quantized_layer_header_size = 40;
+
+//
+// Weight rows are padded to multiple of 16 int16 values,
+// one AVX2 register (or two SSE2 ones).
+//
+
+static const unsigned int simd_width = 16;
+
+//
+// Activate function table covers arguments <-8, 8)
+// with step 1/512, beyond that sigmoids are flat.
+//
+
+static const int table_size = 8192;
+static const double table_resolution = 512.0;
+
+static const int16_t activation_max = std::numeric_limits<int16_t>::max();
+static const int8_t weight_max = std::numeric_limits<int8_t>::max();
+
+static void put_le32(std::string &out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        out.push_back(static_cast<char>((v >> (8*i)) & 0xff));
+    }
+}
+
+static uint32_t get_le32(const unsigned char *p)
+{
+    return static_cast<uint32_t>(p[0])
+         | (static_cast<uint32_t>(p[1]) << 8)
+         | (static_cast<uint32_t>(p[2]) << 16)
+         | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void put_le_double(std::string &out, double v)
+{
+    uint64_t u;
+    memcpy(&u, &v, sizeof(u));
+
+    for (int i = 0; i < 8; i++)
+    {
+        out.push_back(static_cast<char>((u >> (8*i)) & 0xff));
+    }
+}
+
+static void put_le64(std::string &out, uint64_t v)
+{
+    for (int i = 0; i < 8; i++)
+    {
+        out.push_back(static_cast<char>((v >> (8*i)) & 0xff));
+    }
+}
+
+static uint64_t get_le64(const unsigned char *p)
+{
+    uint64_t u = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        u |= static_cast<uint64_t>(p[i]) << (8*i);
+    }
+
+    return u;
+}
+
+static double get_le_double(const unsigned char *p)
+{
+    uint64_t u = 0;
+
+    for (int i = 0; i < 8; i++)
+    {
+        u |= static_cast<uint64_t>(p[i]) << (8*i);
+    }
+
+    double v;
+    memcpy(&v, &u, sizeof(v));
+
+    return v;
+}
+
+//
+// Rounding to nearest is done by hand, „lrint” is a libm
+// call and would cost more than the whole dot product.
+//
+
+static inline int32_t round_nearest(double x)
+{
+    return static_cast<int32_t>(x < 0.0 ? x - 0.5 : x + 0.5);
+}
+
+static inline int16_t saturate16(double x)
+{
+    x = std::max<double>(-activation_max, std::min<double>(activation_max, x));
+
+    return static_cast<int16_t>(round_nearest(x));
+}
+
+static double activate(neuron::activate_function_class af, double x)
+{
+    switch (af)
+    {
+        case neuron::activate_function_class::SIGMOID:
+            return 1.0 / (1.0 + exp(-1.0*x));
+        case neuron::activate_function_class::SIGMOID_BIPOLAR:
+            return 2.0 / (1.0 + exp(-1.0*x)) - 1.0;
+        case neuron::activate_function_class::LINE:
+            return x;
+        default:
+            throw quantized_network::exception("Unknown activate function");
+    }
+}
+
+//
+// Integer GEMV kernel: dot product of int16 activations and
+// int16 (sign extended int8) weights accumulated in int32.
+// „n” is a multiple of „simd_width”.
+//
+
+static inline int32_t dot_product(const int16_t *x, const int16_t *w, unsigned int n)
+{
+    #if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+
+    for (unsigned int i = 0; i < n; i += 16)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(w + i));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+    }
+
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    #elif defined(__SSE2__)
+    __m128i s = _mm_setzero_si128();
+
+    for (unsigned int i = 0; i < n; i += 8)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(w + i));
+        s = _mm_add_epi32(s, _mm_madd_epi16(a, b));
+    }
+    #else
+    int32_t s = 0;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        s += static_cast<int32_t>(x[i]) * static_cast<int32_t>(w[i]);
+    }
+
+    return s;
+    #endif
+
+    #if defined(__SSE2__)
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    return _mm_cvtsi128_si32(s);
+    #endif
+}
+
+quantized_network::quantized_network(neural_network &net, const hftr_samples &calibration)
+    : inputs_(net.get_number_of_inputs()), source_fingerprint_(net.weights_fingerprint())
+{
+    const unsigned int L = net.get_number_of_layers();
+
+    if (L == 0)
+    {
+        throw exception("Attempt to quantize empty network");
+    }
+
+    if (calibration.size() == 0)
+    {
+        throw exception("Empty calibration sample");
+    }
+
+    if (calibration.get_inputs() != inputs_)
+    {
+        throw exception("Calibration sample does not match network input bus");
+    }
+
+    //
+    // Calibrate: range of input bus and of
+    // outputs of every layer over the sample.
+    //
+
+    std::vector<double> range(L + 1, 0.0);
+
+    for (size_t s = 0; s < calibration.size(); s++)
+    {
+        const double *pins = calibration.get_pins(s);
+
+        net.reset_input_bus();
+
+        for (unsigned int i = 0; i < inputs_; i++)
+        {
+            net.set_pin(i, pins[i]);
+            range[0] = std::max(range[0], std::fabs(pins[i]));
+        }
+
+        net.fire();
+
+        for (unsigned int l = 0; l < L; l++)
+        {
+            for (unsigned int j = 0; j < net.get_layer_size(l); j++)
+            {
+                range[l + 1] = std::max(range[l + 1], std::fabs(net.neuron_at(l, j).output_pin()));
+            }
+        }
+    }
+
+    for (auto &r : range)
+    {
+        if (r == 0.0)
+        {
+            r = 1.0;
+        }
+    }
+
+    //
+    // Quantize weights layer by layer.
+    //
+
+    for (unsigned int l = 0; l < L; l++)
+    {
+        quantized_layer ql;
+
+        ql.neurons = net.get_layer_size(l);
+        ql.af = net.neuron_at(l, 0).get_activate_function();
+        ql.fan_in = net.neuron_at(l, 0).get_weights_number() - 1;
+        ql.window_step = (l == 0) ? ql.fan_in : 0;
+        ql.input_scale = range[l] / activation_max;
+        ql.output_scale = range[l + 1] / activation_max;
+
+        //
+        // Last weight of neuron is bias (constant input).
+        //
+
+        double wmax = 0.0;
+
+        for (unsigned int j = 0; j < ql.neurons; j++)
+        {
+            const double *w = net.neuron_at(l, j).get_weights();
+
+            for (unsigned int i = 0; i < ql.fan_in; i++)
+            {
+                wmax = std::max(wmax, std::fabs(w[i]));
+            }
+        }
+
+        ql.weight_scale = (wmax == 0.0 ? 1.0 : wmax) / weight_max;
+
+        //
+        // Worst case of accumulator has to fit into int32.
+        //
+
+        if (static_cast<double>(ql.fan_in) * weight_max * activation_max > 0.5*std::numeric_limits<int32_t>::max())
+        {
+            throw exception("Layer too wide for int32 accumulator");
+        }
+
+        ql.stride = (ql.fan_in + simd_width - 1) / simd_width * simd_width;
+        ql.weights.assign(ql.neurons * ql.stride, 0);
+        ql.biases.resize(ql.neurons);
+
+        const double accumulator_scale = ql.weight_scale * ql.input_scale;
+
+        for (unsigned int j = 0; j < ql.neurons; j++)
+        {
+            const double *w = net.neuron_at(l, j).get_weights();
+
+            for (unsigned int i = 0; i < ql.fan_in; i++)
+            {
+                ql.weights[j*ql.stride + i] = static_cast<int16_t>(lrint(w[i] / ql.weight_scale));
+            }
+
+            double b = w[ql.fan_in] / accumulator_scale;
+            b = std::max<double>(-0.5*std::numeric_limits<int32_t>::max(), std::min<double>(0.5*std::numeric_limits<int32_t>::max(), b));
+
+            ql.biases[j] = static_cast<int32_t>(lrint(b));
+        }
+
+        build_activate_table(ql);
+
+        layers_.push_back(ql);
+    }
+
+    factory_layer_buffers();
+}
+
+void quantized_network::build_activate_table(quantized_layer &l)
+{
+    const double accumulator_scale = l.weight_scale * l.input_scale;
+
+    if (l.af == neuron::activate_function_class::LINE)
+    {
+        l.table.clear();
+        l.table_gain = 0.0;
+        l.requantize_gain = accumulator_scale / l.output_scale;
+
+        return;
+    }
+
+    l.table.resize(table_size);
+    l.table_gain = accumulator_scale * table_resolution;
+    l.requantize_gain = 0.0;
+
+    for (int i = 0; i < table_size; i++)
+    {
+        double x = (i - table_size/2) / table_resolution;
+
+        l.table[i] = saturate16(activate(l.af, x) / l.output_scale);
+    }
+}
+
+void quantized_network::factory_layer_buffers(void)
+{
+    activations_.clear();
+
+    for (unsigned int l = 0; l < layers_.size(); l++)
+    {
+        size_t size = (l == 0) ? inputs_ + layers_[l].stride : layers_[l].stride;
+
+        activations_.push_back(std::vector<int16_t>(size, 0));
+    }
+
+    last_output_.assign(layers_.back().neurons, 0);
+    outputs_.assign(layers_.back().neurons, 0.0);
+}
+
+void quantized_network::fire(const double *pins)
+{
+    const double inv_input_scale = 1.0 / layers_[0].input_scale;
+    int16_t *x = activations_[0].data();
+
+    for (unsigned int i = 0; i < inputs_; i++)
+    {
+        x[i] = saturate16(pins[i] * inv_input_scale);
+    }
+
+    for (unsigned int l = 0; l < layers_.size(); l++)
+    {
+        const quantized_layer &ql = layers_[l];
+        const int16_t *in = activations_[l].data();
+        int16_t *out = (l + 1 < layers_.size()) ? activations_[l + 1].data() : last_output_.data();
+
+        for (unsigned int j = 0; j < ql.neurons; j++)
+        {
+            int32_t acc = dot_product(in + j*ql.window_step, &ql.weights[j*ql.stride], ql.stride) + ql.biases[j];
+
+            if (ql.table.empty())
+            {
+                out[j] = saturate16(acc * ql.requantize_gain);
+            }
+            else
+            {
+                double x = std::max<double>(-table_size/2, std::min<double>(table_size/2 - 1, acc * ql.table_gain));
+                int32_t idx = round_nearest(x) + table_size/2;
+
+                out[j] = ql.table[idx];
+            }
+        }
+    }
+
+    const quantized_layer &last = layers_.back();
+
+    for (unsigned int j = 0; j < last.neurons; j++)
+    {
+        outputs_[j] = last_output_[j] * last.output_scale;
+    }
+}
+
+void quantized_network::save(const std::string &file_name) const
+{
+    std::string data(quantized_magic, sizeof(quantized_magic));
+
+    put_le32(data, quantized_version);
+    put_le32(data, inputs_);
+    put_le32(data, layers_.size());
+    put_le32(data, 0);
+    put_le64(data, source_fingerprint_);
+
+    for (auto &l : layers_)
+    {
+        put_le32(data, l.neurons);
+        put_le32(data, l.af);
+        put_le32(data, l.fan_in);
+        put_le32(data, 0);
+        put_le_double(data, l.weight_scale);
+        put_le_double(data, l.input_scale);
+        put_le_double(data, l.output_scale);
+    }
+
+    for (auto &l : layers_)
+    {
+        for (unsigned int j = 0; j < l.neurons; j++)
+        {
+            for (unsigned int i = 0; i < l.fan_in; i++)
+            {
+                data.push_back(static_cast<char>(static_cast<int8_t>(l.weights[j*l.stride + i])));
+            }
+        }
+
+        for (auto b : l.biases)
+        {
+            put_le32(data, static_cast<uint32_t>(b));
+        }
+    }
+
+    std::ofstream os(file_name, std::ifstream::binary);
+
+    if (os)
+    {
+        os.write(data.c_str(), data.length());
+        os.close();
+    }
+    else
+    {
+        std::string msg = std::string("Unable to open file for write: ") + file_name;
+
+        throw exception(msg.c_str());
+    }
+}
+
+void quantized_network::load(const std::string &file_name)
+{
+    std::ifstream is(file_name, std::ifstream::binary);
+
+    if (! is)
+    {
+        std::string msg = std::string("Unable to open file for read: ") + file_name;
+
+        throw exception(msg.c_str());
+    }
+
+    std::stringstream buffer;
+    buffer << is.rdbuf();
+
+    const std::string data = buffer.str();
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(data.data());
+    const size_t size = data.size();
+
+    if (size < quantized_fixed_header_size || memcmp(p, quantized_magic, sizeof(quantized_magic)) != 0)
+    {
+        std::string msg = std::string("Not a quantized network file: ") + file_name;
+
+        throw exception(msg.c_str());
+    }
+
+    if (get_le32(p + 8) != quantized_version)
+    {
+        std::string msg = std::string("Unsupported quantized network version (re-run „hft nn-quantize”): ") + file_name;
+
+        throw exception(msg.c_str());
+    }
+
+    unsigned int inputs = get_le32(p + 12);
+    uint32_t L = get_le32(p + 16);
+    uint64_t source_fingerprint = get_le64(p + 24);
+
+    size_t offset = quantized_fixed_header_size + quantized_layer_header_size*static_cast<size_t>(L);
+
+    if (L == 0 || size < offset)
+    {
+        std::string msg = std::string("Truncated quantized network file: ") + file_name;
+
+        throw exception(msg.c_str());
+    }
+
+    std::vector<quantized_layer> layers(L);
+
+    for (uint32_t l = 0; l < L; l++)
+    {
+        const unsigned char *h = p + quantized_fixed_header_size + quantized_layer_header_size*l;
+        quantized_layer &ql = layers[l];
+
+        ql.neurons = get_le32(h);
+        ql.af = static_cast<neuron::activate_function_class>(get_le32(h + 4));
+        ql.fan_in = get_le32(h + 8);
+        ql.weight_scale = get_le_double(h + 16);
+        ql.input_scale = get_le_double(h + 24);
+        ql.output_scale = get_le_double(h + 32);
+        ql.window_step = (l == 0) ? ql.fan_in : 0;
+        ql.stride = (ql.fan_in + simd_width - 1) / simd_width * simd_width;
+
+        //
+        // Shape has to be consistent with input bus
+        // and with previous layer.
+        //
+
+        bool consistent = (l == 0) ? (ql.neurons * ql.fan_in == inputs)
+                                   : (ql.fan_in == layers[l - 1].neurons);
+
+        if (ql.neurons == 0 || ! consistent)
+        {
+            std::string msg = std::string("Inconsistent architecture of quantized network file: ") + file_name;
+
+            throw exception(msg.c_str());
+        }
+
+        auto valid_scale = [](double s) { return std::isfinite(s) && s > 0.0; };
+
+        if (! valid_scale(ql.weight_scale) || ! valid_scale(ql.input_scale) || ! valid_scale(ql.output_scale))
+        {
+            std::string msg = std::string("Invalid scale in quantized network file: ") + file_name;
+
+            throw exception(msg.c_str());
+        }
+
+        size_t layer_size = static_cast<size_t>(ql.neurons) * ql.fan_in + 4*static_cast<size_t>(ql.neurons);
+
+        if (size < offset + layer_size)
+        {
+            std::string msg = std::string("Truncated quantized network file: ") + file_name;
+
+            throw exception(msg.c_str());
+        }
+
+        ql.weights.assign(ql.neurons * ql.stride, 0);
+        ql.biases.resize(ql.neurons);
+
+        for (unsigned int j = 0; j < ql.neurons; j++)
+        {
+            for (unsigned int i = 0; i < ql.fan_in; i++)
+            {
+                ql.weights[j*ql.stride + i] = static_cast<int8_t>(p[offset++]);
+            }
+        }
+
+        for (unsigned int j = 0; j < ql.neurons; j++)
+        {
+            ql.biases[j] = static_cast<int32_t>(get_le32(p + offset));
+            offset += 4;
+        }
+
+        build_activate_table(ql);
+    }
+
+    if (offset != size)
+    {
+        std::string msg = std::string("Invalid size of quantized network file: ") + file_name;
+
+        throw exception(msg.c_str());
+    }
+
+    inputs_ = inputs;
+    source_fingerprint_ = source_fingerprint;
+    layers_.swap(layers);
+
+    factory_layer_buffers();
+}
+
+bool quantized_network::is_quantized_file(const std::string &file_name)
+{
+    std::ifstream is(file_name, std::ifstream::binary);
+    char magic[sizeof(quantized_magic)];
+
+    if (! is.read(magic, sizeof(magic)))
+    {
+        return false;
+    }
+
+    return memcmp(magic, quantized_magic, sizeof(quantized_magic)) == 0;
+}
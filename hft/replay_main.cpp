@@ -0,0 +1,295 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+#include <easylogging++.h>
+
+#include <hft_session.hpp>
+#include <hft_bin_proto.hpp>
+#include <request_journal.hpp>
+
+namespace prog_opts = boost::program_options;
+
+//
+// Defined in hft_server_main.cpp.
+//
+
+extern void hft_server_config_options(prog_opts::options_description &server_config_desc);
+
+static struct hft_replay_options_type
+{
+    std::string config_file_name;
+    std::string journal_file_name;
+    bool paced;
+    unsigned int max_diffs;
+
+} hft_replay_options;
+
+#define hftOption(__X__) \
+    hft_replay_options.__X__
+
+#define hft_log(__X__) \
+    CLOG(__X__, "replay")
+
+//
+// Human readable form of response for diff reports.
+//
+
+static std::string printable_response(hft::journal_protocol protocol, const std::string &response)
+{
+    if (protocol == hft::JOURNAL_BINARY_PROTOCOL)
+    {
+        hft::bin_frame_header header;
+
+        if (response.length() < sizeof(header))
+        {
+            return "<truncated frame>";
+        }
+
+        std::memcpy(&header, response.data(), sizeof(header));
+
+        return hft::bin_decode_response(header, reinterpret_cast<const unsigned char *>(response.data()) + sizeof(header));
+    }
+
+    if (response.length() && response.back() == '\n')
+    {
+        return response.substr(0, response.length() - 1);
+    }
+
+    return response;
+}
+
+static long percentile(const std::vector<long> &sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+
+    return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+int hft_replay_main(int argc, char *argv[])
+{
+    //
+    // Define default logger configuration.
+    //
+
+    el::Configurations logger_cfg;
+    logger_cfg.setToDefault();
+    logger_cfg.parseFromText("* GLOBAL:\n"
+                             " FORMAT               =  \"%datetime %level [%logger] %msg\"\n"
+                             " FILENAME             =  \"/dev/null\"\n"
+                             " ENABLED              =  true\n"
+                             " TO_FILE              =  false\n"
+                             " TO_STANDARD_OUTPUT   =  true\n"
+                             " SUBSECOND_PRECISION  =  1\n"
+                             " PERFORMANCE_TRACKING =  true\n"
+                             " MAX_LOG_FILE_SIZE    =  10485760 ## 10MiB\n"
+                             " LOG_FLUSH_THRESHOLD  =  1 ## Flush after every single log\n"
+                            );
+    el::Loggers::setDefaultConfigurations(logger_cfg);
+
+    START_EASYLOGGINGPP(argc, argv);
+
+    //
+    // Parsing options for replay.
+    //
+
+    prog_opts::options_description hidden("Hidden options");
+    hidden.add_options()
+        ("replay", "")
+    ;
+
+    prog_opts::options_description desc("Options for request journal replay");
+    desc.add_options()
+        ("help,h", "produce help message")
+        ("config,c", prog_opts::value<std::string>(&hftOption(config_file_name)) -> default_value("/etc/hft/hftd.conf"), "Server configuration file name used to set up sessions.")
+        ("journal,j", prog_opts::value<std::string>(&hftOption(journal_file_name)) -> required(), "Request journal file recorded by server.")
+        ("paced,p", prog_opts::bool_switch(&hftOption(paced)), "Replay at recorded pace instead of as fast as possible.")
+        ("max-diffs,d", prog_opts::value<unsigned int>(&hftOption(max_diffs)) -> default_value(10), "Maximum number of reported response differences.")
+    ;
+
+    prog_opts::options_description cmdline_options;
+    cmdline_options.add(desc).add(hidden);
+
+    prog_opts::positional_options_description p;
+    p.add("journal", 1);
+
+    prog_opts::variables_map vm;
+    prog_opts::store(prog_opts::command_line_parser(argc, argv).options(cmdline_options).positional(p).run(), vm);
+
+    //
+    // If user requested help, show help and quit
+    // ignoring other options, if any.
+    //
+
+    if (vm.count("help"))
+    {
+        std::cout << desc << "\n";
+
+        return 0;
+    }
+
+    prog_opts::notify(vm);
+
+    el::Logger *logger = el::Loggers::getLogger("replay", true);
+
+    prog_opts::variables_map server_config;
+    prog_opts::options_description server_config_desc;
+    hft_server_config_options(server_config_desc);
+    prog_opts::store(prog_opts::parse_config_file<char>(hftOption(config_file_name).c_str(), server_config_desc), server_config);
+    prog_opts::notify(server_config);
+
+    //
+    // Every recorded session gets its own in-process
+    // session, so per-connection state is reproduced.
+    // Session identifiers start over on every server
+    // run, so sessions are keyed by (run, session).
+    //
+
+    boost::asio::io_context ioctx;
+    std::map<std::pair<std::uint32_t, std::uint32_t>, hft_session *> sessions;
+
+    request_journal_reader journal(hftOption(journal_file_name));
+    hft::journal_record rec;
+    std::string response;
+    std::vector<long> latencies;
+
+    unsigned long records = 0;
+    unsigned long diffs = 0;
+
+    hft::epoch_usec_type first_arrival = 0;
+    std::uint32_t current_run = 0;
+    auto replay_start = std::chrono::steady_clock::now();
+    auto run_start = replay_start;
+
+    while (journal.get_record(rec))
+    {
+        hft_session *&session = sessions[std::make_pair(rec.run_id, rec.session_id)];
+
+        if (session == nullptr)
+        {
+            session = new hft_session(ioctx, server_config);
+        }
+
+        //
+        // Pacing restarts with every run, gaps
+        // between server runs are not replayed.
+        //
+
+        if (records == 0 || rec.run_id != current_run)
+        {
+            first_arrival = rec.arrival_time;
+            current_run = rec.run_id;
+            run_start = std::chrono::steady_clock::now();
+        }
+
+        if (hftOption(paced))
+        {
+            std::this_thread::sleep_until(run_start + std::chrono::microseconds(rec.arrival_time - first_arrival));
+        }
+
+        response.clear();
+
+        auto started = std::chrono::steady_clock::now();
+
+        if (rec.protocol == hft::JOURNAL_BINARY_PROTOCOL)
+        {
+            hft::bin_frame_header header;
+
+            if (rec.request.length() < sizeof(header))
+            {
+                throw std::runtime_error("Malformed binary frame in journal");
+            }
+
+            std::memcpy(&header, rec.request.data(), sizeof(header));
+
+            if (rec.request.length() != sizeof(header) + header.length)
+            {
+                throw std::runtime_error("Malformed binary frame in journal");
+            }
+
+            session -> process_binary_frame(header, reinterpret_cast<const unsigned char *>(rec.request.data()) + sizeof(header),
+                                            response, rec.arrival_time);
+        }
+        else
+        {
+            session -> process_text_request(rec.request, response, rec.arrival_time);
+        }
+
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count());
+
+        records++;
+
+        if (response != rec.response)
+        {
+            if (diffs < hftOption(max_diffs))
+            {
+                hft_log(WARNING) << "Response differs for record #" << records
+                                 << " (run " << rec.run_id << ", session " << rec.session_id << ", arrived "
+                                 << hft::epoch_usec_to_datetime_str(rec.arrival_time) << "):";
+                hft_log(WARNING) << "  request:  „" << (rec.protocol == hft::JOURNAL_BINARY_PROTOCOL ? std::string("<binary frame>") : rec.request) << "”";
+                hft_log(WARNING) << "  recorded: „" << printable_response(rec.protocol, rec.response) << "”";
+                hft_log(WARNING) << "  replayed: „" << printable_response(rec.protocol, response) << "”";
+            }
+
+            diffs++;
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - replay_start).count();
+
+    for (auto &s : sessions)
+    {
+        delete s.second;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+
+    long total = 0;
+
+    for (auto l : latencies)
+    {
+        total += l;
+    }
+
+    std::cout << "Records replayed:    " << records << "\n"
+              << "Sessions:            " << sessions.size() << "\n"
+              << "Differences:         " << diffs << "\n"
+              << "Elapsed time:        " << elapsed << " s\n";
+
+    if (records > 0)
+    {
+        std::cout << "Request latency [ns]: mean " << (total / long(records))
+                  << ", p50 " << percentile(latencies, 0.50)
+                  << ", p99 " << percentile(latencies, 0.99)
+                  << ", max " << latencies.back() << "\n";
+    }
+
+    return (diffs == 0 ? 0 : 1);
+}
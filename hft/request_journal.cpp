@@ -0,0 +1,270 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+
+#include <cstring>
+#include <cerrno>
+
+#include <request_journal.hpp>
+
+#include <easylogging++.h>
+
+#define hft_log(__X__) \
+    CLOG(__X__, "journal")
+
+request_journal::request_journal(const std::string &file_name, size_t max_pending_bytes)
+    : file_(nullptr), file_name_(file_name), max_pending_bytes_(max_pending_bytes),
+      dropped_(0), stop_(false)
+{
+    el::Loggers::getLogger("journal", true);
+
+    file_ = std::fopen(file_name.c_str(), "ab+");
+
+    if (file_ == nullptr)
+    {
+        throw exception(std::string("Unable to open request journal „") + file_name
+                        + "”: " + std::strerror(errno));
+    }
+
+    //
+    // Fresh file gets header, an existing one has
+    // to be a journal of the same version.
+    //
+
+    hft::journal_file_header header;
+
+    std::fseek(file_, 0, SEEK_SET);
+
+    if (std::fread(&header, sizeof(header), 1, file_) == 1)
+    {
+        if (std::memcmp(header.magic, hft::JOURNAL_MAGIC, sizeof(header.magic)) != 0
+                || header.version != hft::JOURNAL_VERSION)
+        {
+            std::fclose(file_);
+
+            throw exception(std::string("File „") + file_name + "” is not a request journal");
+        }
+    }
+    else
+    {
+        std::memcpy(header.magic, hft::JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = hft::JOURNAL_VERSION;
+        header.reserved = 0;
+
+        std::fwrite(&header, sizeof(header), 1, file_);
+    }
+
+    //
+    // Mark beginning of the run, session
+    // identifiers start over from here.
+    //
+
+    hft::journal_record_header marker;
+
+    std::memset(&marker, 0, sizeof(marker));
+    marker.arrival_time = hft::epoch_usec_now();
+    marker.protocol     = hft::JOURNAL_RUN_MARKER;
+
+    std::fseek(file_, 0, SEEK_END);
+    std::fwrite(&marker, sizeof(marker), 1, file_);
+    std::fflush(file_);
+
+    pending_.reserve(1024 * 1024);
+
+    thread_ = std::thread(&request_journal::writer, this);
+
+    hft_log(INFO) << "Journaling requests to „" << file_name << "”";
+}
+
+request_journal::~request_journal(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+
+    cv_.notify_one();
+    thread_.join();
+
+    std::fclose(file_);
+
+    if (dropped_ > 0)
+    {
+        hft_log(WARNING) << dropped_ << " request(s) dropped from journal, writer could not keep up";
+    }
+}
+
+void request_journal::record(std::uint32_t session_id, hft::journal_protocol protocol,
+                                 hft::epoch_usec_type arrival_time,
+                                 const char *request, size_t request_length,
+                                 const std::string &response)
+{
+    hft::journal_record_header header;
+
+    std::memset(&header, 0, sizeof(header));
+    header.arrival_time    = arrival_time;
+    header.session_id      = session_id;
+    header.protocol        = protocol;
+    header.request_length  = request_length;
+    header.response_length = response.length();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (pending_.size() + sizeof(header) + request_length + response.length() > max_pending_bytes_)
+        {
+            dropped_++;
+
+            return;
+        }
+
+        pending_.append(reinterpret_cast<const char *>(&header), sizeof(header));
+        pending_.append(request, request_length);
+        pending_.append(response);
+    }
+
+    cv_.notify_one();
+}
+
+void request_journal::writer(void)
+{
+    std::string chunk;
+
+    chunk.reserve(pending_.capacity());
+
+    while (true)
+    {
+        bool stop;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            cv_.wait(lock, [this]() { return stop_ || ! pending_.empty(); });
+
+            chunk.swap(pending_);
+            stop = stop_;
+        }
+
+        if (chunk.size() > 0)
+        {
+            if (std::fwrite(chunk.data(), chunk.size(), 1, file_) != 1)
+            {
+                hft_log(ERROR) << "Write to request journal „" << file_name_
+                               << "” failed: " << std::strerror(errno);
+            }
+
+            std::fflush(file_);
+            chunk.clear();
+        }
+
+        if (stop)
+        {
+            break;
+        }
+    }
+}
+
+request_journal_reader::request_journal_reader(const std::string &file_name)
+    : file_(nullptr), file_name_(file_name), version_(0), run_id_(0)
+{
+    el::Loggers::getLogger("journal", true);
+
+    file_ = std::fopen(file_name.c_str(), "rb");
+
+    if (file_ == nullptr)
+    {
+        throw exception(std::string("Unable to open request journal „") + file_name
+                        + "”: " + std::strerror(errno));
+    }
+
+    hft::journal_file_header header;
+
+    if (std::fread(&header, sizeof(header), 1, file_) != 1
+            || std::memcmp(header.magic, hft::JOURNAL_MAGIC, sizeof(header.magic)) != 0)
+    {
+        std::fclose(file_);
+
+        throw exception(std::string("File „") + file_name + "” is not a request journal");
+    }
+
+    //
+    // Version 1 journals have no run markers,
+    // all their records belong to run 0.
+    //
+
+    if (header.version != hft::JOURNAL_VERSION && header.version != 1)
+    {
+        std::fclose(file_);
+
+        throw exception(std::string("Unsupported request journal version ")
+                        + std::to_string(header.version));
+    }
+
+    version_ = header.version;
+}
+
+request_journal_reader::~request_journal_reader(void)
+{
+    std::fclose(file_);
+}
+
+bool request_journal_reader::get_record(hft::journal_record &out_rec)
+{
+    hft::journal_record_header header;
+
+    while (true)
+    {
+        if (std::fread(&header, sizeof(header), 1, file_) != 1)
+        {
+            return false;
+        }
+
+        if (version_ < 2 || header.protocol != hft::JOURNAL_RUN_MARKER)
+        {
+            break;
+        }
+
+        if (std::fseek(file_, header.request_length + header.response_length, SEEK_CUR) != 0)
+        {
+            return false;
+        }
+
+        run_id_++;
+    }
+
+    out_rec.arrival_time = header.arrival_time;
+    out_rec.run_id       = run_id_;
+    out_rec.session_id   = header.session_id;
+    out_rec.protocol     = hft::journal_protocol(header.protocol);
+
+    out_rec.request.resize(header.request_length);
+    out_rec.response.resize(header.response_length);
+
+    if ((header.request_length > 0 && std::fread(&out_rec.request[0], header.request_length, 1, file_) != 1)
+            || (header.response_length > 0 && std::fread(&out_rec.response[0], header.response_length, 1, file_) != 1))
+    {
+        //
+        // Truncated tail, e.g. server killed in the
+        // middle of write. Treat as end of journal.
+        //
+
+        hft_log(WARNING) << "Request journal „" << file_name_ << "” is truncated";
+
+        return false;
+    }
+
+    return true;
+}
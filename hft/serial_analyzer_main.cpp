@@ -21,6 +21,10 @@
 #include <vector>
 #include <map>
 #include <random>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
 
 #include <boost/program_options.hpp>
 
@@ -31,12 +35,42 @@ namespace prog_opts = boost::program_options;
 typedef std::vector<int> serial_container;
 typedef std::map<int, int> series_distrib;
 
+//
+// Random series packed 64 items per word,
+// i-th item is bit (i % 64) of word (i / 64).
+//
+
+typedef std::vector<uint64_t> packed_serial;
+
+//
+// Amount of runs indexed by run length.
+//
+
+typedef std::vector<unsigned int> run_length_histogram;
+
+struct worker_data
+{
+    worker_data(void) : first_trial(0), last_trial(0) {}
+
+    unsigned int first_trial;
+    unsigned int last_trial;
+    std::vector<run_length_histogram> results;
+
+    std::shared_ptr<std::thread> thread;
+};
+
+typedef std::vector<worker_data> workers;
+
 static struct hft_serial_analyzer_options_type
 {
     std::string list_filename;
     std::string serial_filename;
     std::string instrument;
     unsigned int pips_limit;
+    unsigned int monte_carlo_trials;
+    double confidence;
+    unsigned int seed;
+    int ncores;
 } hft_serial_analyzer_options;
 
 #define hftOption(__X__) \
@@ -151,7 +185,7 @@ static serial_container generate_random_serial(int n)
     serial_container sc;
 
     std::mt19937 rng;
-    rng.seed(std::random_device()());
+    rng.seed(hftOption(seed));
     std::uniform_int_distribution<std::mt19937::result_type> dist(0, 1); // distribution in range [0, 1]
 
     for (int i = 0; i < n; i++)
@@ -162,6 +196,199 @@ static serial_container generate_random_serial(int n)
     return sc;
 }
 
+//
+// Every trial has its own generator seeded by (seed, trial),
+// so results do not depend on the number of threads.
+//
+
+static void generate_random_packed_serial(unsigned int trial, size_t n, packed_serial &ps)
+{
+    std::seed_seq sseq = { hftOption(seed), trial };
+    std::mt19937_64 rng(sseq);
+
+    ps.resize((n + 63) / 64);
+
+    for (auto &w : ps)
+    {
+        w = rng();
+    }
+}
+
+//
+// Bit-parallel run counting. For every word, mask of run
+// boundaries is obtained as XOR of the word and the series
+// shifted by one item, then only boundaries are visited.
+//
+
+static void count_runs(const packed_serial &ps, size_t n, run_length_histogram &rlh)
+{
+    rlh.clear();
+
+    if (n == 0)
+    {
+        return;
+    }
+
+    const size_t words = ps.size();
+    const size_t last_item = n - 1;
+    long prev_end = -1;
+
+    for (size_t j = 0; j < words; j++)
+    {
+        uint64_t next = (j + 1 < words) ? (ps[j + 1] << 63) : 0;
+        uint64_t boundaries = ps[j] ^ ((ps[j] >> 1) | next);
+
+        if (j == last_item / 64)
+        {
+            //
+            // The last item always ends a run,
+            // items beyond series are dropped.
+            //
+
+            unsigned int b = last_item % 64;
+
+            boundaries |= (uint64_t(1) << b);
+
+            if (b < 63)
+            {
+                boundaries &= ((uint64_t(1) << (b + 1)) - 1);
+            }
+        }
+
+        while (boundaries)
+        {
+            long pos = j*64 + __builtin_ctzll(boundaries);
+            unsigned int len = pos - prev_end;
+
+            if (len >= rlh.size())
+            {
+                rlh.resize(len + 1, 0);
+            }
+
+            rlh[len]++;
+            prev_end = pos;
+
+            boundaries &= (boundaries - 1);
+        }
+
+        if (j == last_item / 64)
+        {
+            break;
+        }
+    }
+}
+
+static void thread_funct_monte_carlo(worker_data *self)
+{
+    packed_serial ps;
+    const size_t n = experiment_series.size();
+
+    for (unsigned int trial = self -> first_trial; trial < self -> last_trial; trial++)
+    {
+        self -> results.push_back(run_length_histogram());
+
+        generate_random_packed_serial(trial, n, ps);
+        count_runs(ps, n, self -> results.back());
+    }
+}
+
+static void monte_carlo(const series_distrib &experiment_distrib)
+{
+    const unsigned int trials = hftOption(monte_carlo_trials);
+    const unsigned int ncores = hftOption(ncores) > 0 ? hftOption(ncores) : 1;
+
+    hft_log(INFO) << "Monte Carlo: [" << trials << "] random series of length ["
+                  << experiment_series.size() << "] on [" << ncores << "] threads.";
+
+    hft_log(INFO) << "Random seed [" << hftOption(seed) << "], pass „--seed "
+                  << hftOption(seed) << "” to reproduce the run.";
+
+    workers thread_workers(std::min(ncores, trials));
+
+    for (unsigned int i = 0; i < thread_workers.size(); i++)
+    {
+        thread_workers[i].first_trial = (static_cast<unsigned long>(trials) * i) / thread_workers.size();
+        thread_workers[i].last_trial  = (static_cast<unsigned long>(trials) * (i + 1)) / thread_workers.size();
+    }
+
+    for (auto &x : thread_workers)
+    {
+        x.thread.reset(new std::thread(thread_funct_monte_carlo, &x));
+    }
+
+    for (auto &x : thread_workers)
+    {
+        x.thread -> join();
+    }
+
+    //
+    // Gather samples per run length.
+    //
+
+    size_t max_len = 0;
+
+    for (auto &x : thread_workers)
+    {
+        for (auto &rlh : x.results)
+        {
+            max_len = std::max(max_len, rlh.size());
+        }
+    }
+
+    if (! experiment_distrib.empty())
+    {
+        max_len = std::max(max_len, static_cast<size_t>(experiment_distrib.rbegin() -> first + 1));
+    }
+
+    std::vector<std::vector<unsigned int> > samples(max_len);
+
+    for (auto &x : thread_workers)
+    {
+        for (auto &rlh : x.results)
+        {
+            for (size_t len = 1; len < max_len; len++)
+            {
+                samples[len].push_back(len < rlh.size() ? rlh[len] : 0);
+            }
+        }
+    }
+
+    //
+    // Report confidence band per run length.
+    //
+
+    const double alpha = (1.0 - hftOption(confidence)) / 2.0;
+
+    hft_log(INFO) << "Run length: experiment / random mean [lower - upper] at confidence "
+                  << hftOption(confidence);
+
+    for (size_t len = 1; len < max_len; len++)
+    {
+        std::vector<unsigned int> &v = samples[len];
+
+        std::sort(v.begin(), v.end());
+
+        double mean = 0.0;
+
+        for (auto c : v)
+        {
+            mean += c;
+        }
+
+        mean /= v.size();
+
+        unsigned int lower = v[static_cast<size_t>(alpha * (v.size() - 1))];
+        unsigned int upper = v[static_cast<size_t>((1.0 - alpha) * (v.size() - 1) + 0.5)];
+
+        auto it = experiment_distrib.find(len);
+        unsigned int observed = (it == experiment_distrib.end() ? 0 : it -> second);
+
+        hft_log(INFO) << len << ":\t" << observed << "\t" << mean
+                      << "\t[" << lower << " - " << upper << "]"
+                      << ((observed < lower || observed > upper) ? "\t*** outside band" : "");
+    }
+}
+
 int hft_serial_analyzer_main(int argc, char *argv[])
 {
     //
@@ -196,6 +423,10 @@ int hft_serial_analyzer_main(int argc, char *argv[])
         ("list-file,l", prog_opts::value<std::string>(&hftOption(list_filename)), "File with list of Dukascoopy historical CSV file names")
         ("serial-file,s", prog_opts::value<std::string>(&hftOption(serial_filename)), "File name with serial data, like \"00101011\"")
         ("pips-limit,p", prog_opts::value<unsigned int>(&hftOption(pips_limit)) -> default_value(0), "Pips limit")
+        ("monte-carlo,m", prog_opts::value<unsigned int>(&hftOption(monte_carlo_trials)) -> default_value(0), "Number of random series for Monte Carlo comparison. If 0, single random series is displayed")
+        ("confidence,c", prog_opts::value<double>(&hftOption(confidence)) -> default_value(0.95), "Confidence level of Monte Carlo bands")
+        ("seed,r", prog_opts::value<unsigned int>(&hftOption(seed)) -> default_value(std::random_device()()), "Seed of random series, by default taken from random device and logged")
+        ("threads,u", prog_opts::value<int>(&hftOption(ncores)) -> default_value(std::thread::hardware_concurrency()), "Define number of threads")
     ;
 
     prog_opts::options_description cmdline_options;
@@ -312,7 +543,21 @@ int hft_serial_analyzer_main(int argc, char *argv[])
 
     display_series_distrib(experiment_distrib);
 
-    hft_log(INFO) << "Randomed serial distribution";
+    if (hftOption(monte_carlo_trials) > 0)
+    {
+        if (hftOption(confidence) <= 0.0 || hftOption(confidence) >= 1.0)
+        {
+            hft_log(ERROR) << "Confidence must be in range (0, 1)";
+
+            return 1;
+        }
+
+        monte_carlo(experiment_distrib);
+
+        return 0;
+    }
+
+    hft_log(INFO) << "Randomed serial distribution, random seed [" << hftOption(seed) << "]";
 
     display_series_distrib(generate_series_distrib(generate_random_serial(experiment_series.size())));
 
@@ -14,29 +14,296 @@
 **                                                                    **
 \**********************************************************************/
 
-#include <ctime>
 #include <cstdio>
+#include <cstring>
 
 #include <hft_utils.hpp>
+#include <hft_bin_proto.hpp>
 #include <session_transport.hpp>
 
 #define hft_log(__X__) \
     CLOG(__X__, "transport")
 
-void session_transport::handle_read(const boost::system::error_code &error)
+//
+// Static members initialization.
+//
+
+std::atomic<request_journal *> session_transport::journal_(nullptr);
+std::atomic<std::uint32_t> session_transport::session_counter_(0);
+
+//
+// Completion condition of binary protocol reads: at least
+// „minimum” bytes, but buffer never grows above one frame
+// of maximum size, so frame length is validated before
+// its payload is read.
+//
+
+class transfer_frame
 {
-    if (! error)
+public:
+
+    transfer_frame(size_t minimum, size_t maximum)
+        : minimum_(minimum), maximum_(maximum) {}
+
+    size_t operator()(const boost::system::error_code &error, size_t bytes_transferred) const
     {
-        //
-        // Update information about time when the
-        // request arrived.
-        //
+        if (error || bytes_transferred >= minimum_)
+        {
+            return 0;
+        }
+
+        return maximum_ - bytes_transferred;
+    }
+
+private:
+
+    size_t minimum_;
+    size_t maximum_;
+};
+
+void session_transport::start(void)
+{
+    //
+    // First byte decides about protocol. Whatever was
+    // read above it stays in the buffer for the parser.
+    //
+
+    boost::asio::async_read(socket_, input_buffer_,
+                            transfer_frame(1, sizeof(hft::bin_frame_header) + hft::BIN_PROTO_MAX_PAYLOAD),
+                            boost::bind(&session_transport::handle_handshake, this, _1));
+}
+
+void session_transport::handle_handshake(const boost::system::error_code &error)
+{
+    if (error)
+    {
+        hft_log(WARNING) << "Destroying session because of error: "
+                         << error.message();
+
+        delete this;
+
+        return;
+    }
+
+    const unsigned char *data = boost::asio::buffer_cast<const unsigned char *>(input_buffer_.data());
 
-        time_t t = time(0);
-        struct tm *now = localtime(&t);
+    if (data[0] == hft::BIN_PROTO_MAGIC)
+    {
+        input_buffer_.consume(1);
+        binary_protocol_ = true;
+
+        hft_log(INFO) << "Session switched to binary protocol";
+    }
 
-        request_time_ = boost::posix_time::time_duration(now -> tm_hour, now -> tm_min, now -> tm_sec, 0);
+    read_request();
+}
+
+void session_transport::read_request(void)
+{
+    if (! binary_protocol_)
+    {
+        boost::asio::async_read_until(socket_, input_buffer_, '\n', boost::bind(&session_transport::handle_read, this, _1));
+
+        return;
+    }
+
+    size_t required = sizeof(hft::bin_frame_header);
+
+    if (input_buffer_.size() >= required)
+    {
+        hft::bin_frame_header header;
+
+        std::memcpy(&header, boost::asio::buffer_cast<const void *>(input_buffer_.data()), sizeof(header));
+
+        required += header.length;
+    }
+
+    if (input_buffer_.size() >= required)
+    {
+        handle_binary_read(boost::system::error_code());
+    }
+    else
+    {
+        const size_t max_frame = sizeof(hft::bin_frame_header) + hft::BIN_PROTO_MAX_PAYLOAD;
+
+        if (required > max_frame)
+        {
+            //
+            // Let handle_binary_read reject the frame.
+            //
+
+            handle_binary_read(boost::system::error_code());
+
+            return;
+        }
+
+        boost::asio::async_read(socket_, input_buffer_, transfer_frame(required - input_buffer_.size(), max_frame - input_buffer_.size()),
+                                boost::bind(&session_transport::handle_binary_read, this, _1));
+    }
+}
+
+void session_transport::dispatch_message(const hft::generic_protocol_message &msg, std::ostringstream &response)
+{
+    switch (msg.first)
+    {
+        case hft::tick_message::OPCODE:
+            tick_notify(boost::any_cast<const hft::tick_message &>(msg.second), response);
+            break;
+        case hft::historical_tick_message::OPCODE:
+            historical_tick_notify(boost::any_cast<const hft::historical_tick_message &>(msg.second), response);
+            break;
+        case hft::subscribe_instrument_message::OPCODE:
+            subscribe_notify(boost::any_cast<const hft::subscribe_instrument_message &>(msg.second), response);
+            break;
+        case hft::hci_setup_message::OPCODE:
+            hci_setup_notify(boost::any_cast<const hft::hci_setup_message &>(msg.second), response);
+            break;
+        default:
+            throw std::runtime_error("Transport error");
+    }
+}
+
+//
+// Handles single text protocol request (without trailing
+// newline). Protocol errors are answered, any other
+// exception is left for the transport to handle.
+//
+
+void session_transport::process_text_request(const std::string &line, std::string &response, hft::epoch_usec_type arrival_time)
+{
+    request_time_ = arrival_time;
+
+    std::ostringstream response_buffer;
+
+    try
+    {
+        dispatch_message(hft::req_parse_message(line), response_buffer);
+    }
+    catch (const hft::protocol_violation_error &e)
+    {
+        hft_log(ERROR) << "Protocol violation error: " << e.what()
+                       << ". Client request: „" << line << "”";
 
+        response_buffer << "ERROR;" << e.what();
+    }
+
+    response_buffer << std::endl;
+    response = response_buffer.str();
+
+    request_journal *journal = journal_;
+
+    if (journal != nullptr)
+    {
+        journal -> record(session_id_, hft::JOURNAL_TEXT_PROTOCOL, arrival_time,
+                          line.data(), line.length(), response);
+    }
+}
+
+//
+// Handles single binary frame regardless of the transport
+// it came from. Protocol errors are answered, any other
+// exception is left for the transport to handle.
+//
+
+void session_transport::process_binary_frame(const hft::bin_frame_header &header, const unsigned char *payload,
+                                                 std::string &response, hft::epoch_usec_type arrival_time)
+{
+    request_time_ = arrival_time;
+
+    std::ostringstream response_buffer;
+
+    try
+    {
+        dispatch_message(hft::bin_parse_message(header, payload), response_buffer);
+    }
+    catch (const hft::protocol_violation_error &e)
+    {
+        hft_log(ERROR) << "Protocol violation error: " << e.what()
+                       << ". Client binary request opcode: " << int(header.opcode);
+
+        response_buffer << "ERROR;" << e.what();
+    }
+
+    hft::bin_encode_response(response_buffer.str(), response);
+
+    request_journal *journal = journal_;
+
+    if (journal != nullptr)
+    {
+        std::string frame(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        frame.append(reinterpret_cast<const char *>(payload), header.length);
+
+        journal -> record(session_id_, hft::JOURNAL_BINARY_PROTOCOL, arrival_time,
+                          frame.data(), frame.length(), response);
+    }
+}
+
+void session_transport::handle_binary_read(const boost::system::error_code &error)
+{
+    if (error)
+    {
+        hft_log(WARNING) << "Destroying session because of error: "
+                         << error.message();
+
+        delete this;
+
+        return;
+    }
+
+    hft::bin_frame_header header;
+
+    if (input_buffer_.size() < sizeof(header))
+    {
+        read_request();
+
+        return;
+    }
+
+    std::memcpy(&header, boost::asio::buffer_cast<const void *>(input_buffer_.data()), sizeof(header));
+
+    if (header.length > hft::BIN_PROTO_MAX_PAYLOAD)
+    {
+        hft_log(ERROR) << "Binary frame too long (" << header.length
+                       << " bytes). Going to close the session";
+
+        delete this;
+
+        return;
+    }
+
+    if (input_buffer_.size() < sizeof(header) + header.length)
+    {
+        read_request();
+
+        return;
+    }
+
+    try
+    {
+        response_data_.clear();
+        process_binary_frame(header, boost::asio::buffer_cast<const unsigned char *>(input_buffer_.data()) + sizeof(header),
+                             response_data_, hft::epoch_usec_now());
+    }
+    catch (const std::exception &e)
+    {
+        hft_log(ERROR) << "Error occured: " << e.what()
+                       << ". Going to close the session";
+
+        socket_.close();
+    }
+
+    input_buffer_.consume(sizeof(header) + header.length);
+
+    boost::asio::async_write(socket_,
+                             boost::asio::buffer(response_data_.data(), response_data_.length()),
+                             boost::bind(&session_transport::handle_write, this, boost::asio::placeholders::error));
+}
+
+void session_transport::handle_read(const boost::system::error_code &error)
+{
+    if (! error)
+    {
         //
         // Extract the newline-delimited message from the buffer.
         //
@@ -45,36 +312,10 @@ void session_transport::handle_read(const boost::system::error_code &error)
         std::istream is(&input_buffer_);
         std::getline(is, line);
 
-        std::ostringstream response_buffer;
-
         try
         {
-            hft::generic_protocol_message msg = hft::req_parse_message(line);
-
-            switch (msg.first)
-            {
-                case hft::tick_message::OPCODE:
-                    tick_notify(boost::any_cast<hft::tick_message>(msg.second), response_buffer);
-                    break;
-                case hft::historical_tick_message::OPCODE:
-                    historical_tick_notify(boost::any_cast<hft::historical_tick_message>(msg.second), response_buffer);
-                    break;
-                case hft::subscribe_instrument_message::OPCODE:
-                    subscribe_notify(boost::any_cast<hft::subscribe_instrument_message>(msg.second), response_buffer);
-                    break;
-                case hft::hci_setup_message::OPCODE:
-                    hci_setup_notify(boost::any_cast<hft::hci_setup_message>(msg.second), response_buffer);
-                    break;
-                default:
-                    throw std::runtime_error("Transport error");
-            }
-        }
-        catch (const hft::protocol_violation_error &e)
-        {
-            hft_log(ERROR) << "Protocol violation error: " << e.what()
-                           << ". Client request: „" << line << "”";
-
-            response_buffer << "ERROR;" << e.what();
+            response_data_.clear();
+            process_text_request(line, response_data_, hft::epoch_usec_now());
         }
         catch (const std::exception &e)
         {
@@ -84,9 +325,6 @@ void session_transport::handle_read(const boost::system::error_code &error)
             socket_.close(); // FIXME: Ja bym tu dał: "delete this; return;"
         }
 
-        response_buffer << std::endl;
-        response_data_ = response_buffer.str();
-
         boost::asio::async_write(socket_,
                                  boost::asio::buffer(response_data_.c_str(), response_data_.length()),
                                  boost::bind(&session_transport::handle_write, this, boost::asio::placeholders::error));
@@ -104,7 +342,7 @@ void session_transport::handle_write(const boost::system::error_code& error)
 {
     if (! error)
     {
-        boost::asio::async_read_until(socket_, input_buffer_, '\n', boost::bind(&session_transport::handle_read, this, _1));
+        read_request();
     }
     else
     {
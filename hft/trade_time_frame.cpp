@@ -15,6 +15,8 @@
 \**********************************************************************/
 
 #include <vector>
+#include <algorithm>
+#include <cstring>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/date_time/gregorian/gregorian.hpp>
@@ -31,28 +33,57 @@
 
 #undef TTF_DEBUG
 
-const char *const trade_time_frame::days_[] = { "Monday", "Tuesday", "Wednesday", "Thurstday", "Friday" };
+//
+// Indexed as boost::date_time weekdays (Sunday first).
+//
+
+const char *const trade_time_frame::days_[] = { "Sunday", "Monday", "Tuesday", "Wednesday", "Thurstday", "Friday", "Saturday" };
 
 trade_time_frame::trade_time_frame(const boost::program_options::variables_map &config)
     : enabled_(config["trade_time_frame.enabled"].as<bool>())
 {
     el::Loggers::getLogger("trade_time_frame", true);
 
+    std::memset(week_, 0, sizeof(week_));
+
     if (enabled_)
     {
-        tfr_[MON] = parse_restriction(config["trade_time_frame.Mon"].as<std::string>());
-        tfr_[TUE] = parse_restriction(config["trade_time_frame.Tue"].as<std::string>());
-        tfr_[WED] = parse_restriction(config["trade_time_frame.Wed"].as<std::string>());
-        tfr_[THU] = parse_restriction(config["trade_time_frame.Thu"].as<std::string>());
-        tfr_[FRI] = parse_restriction(config["trade_time_frame.Fri"].as<std::string>());
+        static const char *const day_options[] =
+        {
+            "trade_time_frame.Sun", "trade_time_frame.Mon", "trade_time_frame.Tue",
+            "trade_time_frame.Wed", "trade_time_frame.Thu", "trade_time_frame.Fri",
+            "trade_time_frame.Sat"
+        };
 
-        for (int i = 0; i < 5; i++)
+        for (int i = 0; i < 7; i++)
         {
-            hft_log(INFO) << "Timeframe restriction for [" << days_[i] << "] is ["
-                          << boost::posix_time::to_simple_string(tfr_[i].trade_period_from)
-                          << " - "
-                          << boost::posix_time::to_simple_string(tfr_[i].trade_period_to)
-                          << "].";
+            timeframe_restrictions tfr;
+
+            if (config.count(day_options[i]))
+            {
+                tfr = parse_restrictions(config[day_options[i]].as<std::string>());
+            }
+
+            compile_day(i, tfr);
+
+            if (tfr.empty())
+            {
+                hft_log(INFO) << "No trading on [" << days_[i] << "].";
+            }
+
+            for (auto &r : tfr)
+            {
+                hft_log(INFO) << "Timeframe restriction for [" << days_[i] << "] is ["
+                              << boost::posix_time::to_simple_string(r.trade_period_from)
+                              << " - "
+                              << boost::posix_time::to_simple_string(r.trade_period_to)
+                              << "].";
+            }
+        }
+
+        if (config.count("trade_time_frame.holidays"))
+        {
+            parse_holidays(config["trade_time_frame.holidays"].as<std::string>());
         }
     }
     else
@@ -66,42 +97,157 @@ trade_time_frame::~trade_time_frame(void)
     // Nothing to do.
 }
 
-bool trade_time_frame::can_play(const boost::posix_time::ptime &current_time_point)
+std::int64_t trade_time_frame::to_epoch_minute(const boost::posix_time::ptime &time_point)
+{
+    static const boost::gregorian::date epoch(1970, 1, 1);
+
+    std::int64_t days = time_point.date().day_number() - epoch.day_number();
+
+    return days * MINUTES_PER_DAY + time_point.time_of_day().total_seconds() / 60;
+}
+
+bool trade_time_frame::can_play(hft::epoch_usec_type timestamp) const
 {
     if (! enabled_)
     {
         return true;
     }
 
-    boost::gregorian::date today = current_time_point.date();
-    int dow = today.day_of_week();
+    return can_play_minute(timestamp / hft::USEC_PER_MINUTE);
+}
+
+bool trade_time_frame::can_play_minute(std::int64_t epoch_minute) const
+{
+    if (epoch_minute < 0)
+    {
+        return false;
+    }
+
+    std::int64_t day = epoch_minute / MINUTES_PER_DAY;
+    unsigned int mow = ((day + EPOCH_DAY_OF_WEEK) % 7) * MINUTES_PER_DAY
+                            + epoch_minute % MINUTES_PER_DAY;
 
-    if (dow == boost::date_time::Saturday || dow == boost::date_time::Sunday)
+    if (! minute_of_week_set(mow))
     {
         return false;
     }
 
-    boost::posix_time::time_duration td = current_time_point.time_of_day();
+    return holidays_.empty() || ! std::binary_search(holidays_.begin(), holidays_.end(), day);
+}
+
+bool trade_time_frame::can_play(const boost::posix_time::ptime &current_time_point) const
+{
+    if (! enabled_)
+    {
+        return true;
+    }
 
-    return can_play_today(tfr_[dow-1], td);
+    return can_play_minute(to_epoch_minute(current_time_point));
 }
 
-bool trade_time_frame::can_play(const boost::posix_time::time_duration &td)
+bool trade_time_frame::can_play(const boost::posix_time::time_duration &td) const
 {
     if (! enabled_)
     {
         return true;
     }
 
-    boost::gregorian::date today = boost::gregorian::day_clock::local_day();
-    int dow = today.day_of_week();
+    boost::posix_time::ptime now(boost::gregorian::day_clock::local_day(), td);
+
+    return can_play_minute(to_epoch_minute(now));
+}
+
+//
+// Mark every minute of the day which lies entirely inside any of
+// the given windows. Schedule resolution is one minute, so a window
+// ending at whole minute (e.g. „20:59:00.000”) closes trading at its
+// end. Any end from 23:59:59 on (legacy „23:59:59,99” included) means
+// end of day and keeps the last minute of the day open.
+//
 
-    if (dow == boost::date_time::Saturday || dow == boost::date_time::Sunday)
+void trade_time_frame::compile_day(int dow, const trade_time_frame::timeframe_restrictions &restrictions)
+{
+    static const std::int64_t ms_per_minute = 60000;
+
+    for (auto &r : restrictions)
     {
-        return false;
+        int from = static_cast<int>((r.trade_period_from.total_milliseconds() + ms_per_minute - 1) / ms_per_minute);
+        int to   = static_cast<int>((r.trade_period_to.total_milliseconds() + 1) / ms_per_minute) - 1;
+
+        if (r.trade_period_to.total_seconds() >= MINUTES_PER_DAY*60 - 1)
+        {
+            to = MINUTES_PER_DAY - 1;
+        }
+
+        for (int m = std::max(from, 0); m <= std::min(to, MINUTES_PER_DAY - 1); m++)
+        {
+            unsigned int mow = dow * MINUTES_PER_DAY + m;
+
+            week_[mow >> 6] |= (std::uint64_t(1) << (mow & 63));
+        }
+    }
+}
+
+void trade_time_frame::parse_holidays(std::string holidays)
+{
+    static const boost::gregorian::date epoch(1970, 1, 1);
+    std::vector<std::string> dates;
+
+    boost::trim_if(holidays, boost::is_any_of("\" \t"));
+
+    if (holidays.empty())
+    {
+        return;
+    }
+
+    boost::split(dates, holidays, boost::is_any_of(", \t"), boost::token_compress_on);
+
+    for (auto &d : dates)
+    {
+        try
+        {
+            boost::gregorian::date day = boost::gregorian::from_simple_string(d);
+
+            holidays_.push_back(day.day_number() - epoch.day_number());
+
+            hft_log(INFO) << "No trading on holiday [" << boost::gregorian::to_iso_extended_string(day) << "].";
+        }
+        catch (const std::exception &e)
+        {
+            hft_log(WARNING) << "Ignoring invalid holiday date: [" << d << "].";
+        }
+    }
+
+    std::sort(holidays_.begin(), holidays_.end());
+    holidays_.erase(std::unique(holidays_.begin(), holidays_.end()), holidays_.end());
+}
+
+//
+// Day schedule is a list of windows separated with semicolon
+// or whitespace (comma is already taken by fractional seconds).
+// Empty value or „closed” means no trading on that day.
+//
+
+trade_time_frame::timeframe_restrictions trade_time_frame::parse_restrictions(std::string restrictions)
+{
+    std::vector<std::string> windows;
+    timeframe_restrictions ret;
+
+    boost::trim_if(restrictions, boost::is_any_of("\" \t"));
+
+    if (restrictions.empty() || boost::iequals(restrictions, "closed"))
+    {
+        return ret;
+    }
+
+    boost::split(windows, restrictions, boost::is_any_of("; \t"), boost::token_compress_on);
+
+    for (auto &w : windows)
+    {
+        ret.push_back(parse_restriction(w));
     }
 
-    return can_play_today(tfr_[dow-1], td);
+    return ret;
 }
 
 trade_time_frame::timeframe_restriction trade_time_frame::parse_restriction(std::string restriction)
@@ -165,9 +311,3 @@ trade_time_frame::timeframe_restriction trade_time_frame::parse_restriction(std:
 
     return ret;
 }
-
-bool trade_time_frame::can_play_today(const trade_time_frame::timeframe_restriction &restriction,
-                                          const boost::posix_time::time_duration &td)
-{
-    return (restriction.trade_period_from <= td && restriction.trade_period_to >= td);
-}
@@ -16,11 +16,151 @@
 
 #include <cmath>
 #include <sstream>
+#include <stdexcept>
+#include <algorithm>
 #include <train_stat.hpp>
 
+void train_stat::moments::add(double x)
+{
+    n++;
+
+    double delta = x - mean;
+    mean += delta / static_cast<double>(n);
+    m2 += delta * (x - mean);
+}
+
+void train_stat::moments::merge(const train_stat::moments &other)
+{
+    if (other.n == 0)
+    {
+        return;
+    }
+
+    if (n == 0)
+    {
+        *this = other;
+
+        return;
+    }
+
+    double total = static_cast<double>(n + other.n);
+    double delta = other.mean - mean;
+
+    mean += delta * static_cast<double>(other.n) / total;
+    m2 += other.m2 + delta * delta * static_cast<double>(n) * static_cast<double>(other.n) / total;
+    n += other.n;
+}
+
+train_stat::train_stat(void)
+    : histogram_min_(-1.0), histogram_max_(1.0)
+{
+    clear();
+}
+
+void train_stat::clear(void)
+{
+    n_ = 0;
+    success_ = 0;
+    long_n_ = 0;
+    long_success_ = 0;
+    short_n_ = 0;
+    short_success_ = 0;
+    abs_error_sum_ = 0.0;
+    sqr_error_sum_ = 0.0;
+    long_moments_ = moments();
+    short_moments_ = moments();
+
+    std::fill(histogram_.begin(), histogram_.end(), 0);
+}
+
 void train_stat::store(double network_response, double expected)
 {
-    data_.push_back(std::make_pair(network_response, expected));
+    double e = network_response - expected;
+
+    n_++;
+    abs_error_sum_ += fabs(e);
+    sqr_error_sum_ += e*e;
+
+    if (network_response > 0.0)
+    {
+        long_n_++;
+        long_moments_.add(network_response);
+
+        if (expected > 0.0)
+        {
+            long_success_++;
+            success_++;
+        }
+    }
+    else if (network_response < 0.0)
+    {
+        short_n_++;
+        short_moments_.add(network_response);
+
+        if (expected < 0.0)
+        {
+            short_success_++;
+            success_++;
+        }
+    }
+
+    if (histogram_.size())
+    {
+        double r = (network_response - histogram_min_) / (histogram_max_ - histogram_min_);
+        long bin = static_cast<long>(r * histogram_.size());
+
+        if (bin < 0)
+        {
+            bin = 0;
+        }
+        else if (bin >= static_cast<long>(histogram_.size()))
+        {
+            bin = histogram_.size() - 1;
+        }
+
+        histogram_[bin]++;
+    }
+}
+
+void train_stat::merge(const train_stat &other)
+{
+    n_ += other.n_;
+    success_ += other.success_;
+    long_n_ += other.long_n_;
+    long_success_ += other.long_success_;
+    short_n_ += other.short_n_;
+    short_success_ += other.short_success_;
+    abs_error_sum_ += other.abs_error_sum_;
+    sqr_error_sum_ += other.sqr_error_sum_;
+    long_moments_.merge(other.long_moments_);
+    short_moments_.merge(other.short_moments_);
+
+    if (other.histogram_.size())
+    {
+        if (other.histogram_.size() != histogram_.size() ||
+            other.histogram_min_ != histogram_min_ ||
+            other.histogram_max_ != histogram_max_)
+        {
+            throw std::logic_error("Unable to merge statistics with different histograms");
+        }
+
+        for (size_t i = 0; i < histogram_.size(); i++)
+        {
+            histogram_[i] += other.histogram_[i];
+        }
+    }
+}
+
+void train_stat::enable_histogram(unsigned int bins, double min, double max)
+{
+    if (max <= min)
+    {
+        throw std::logic_error("Invalid histogram range");
+    }
+
+    histogram_min_ = min;
+    histogram_max_ = max;
+    histogram_.assign(bins, 0);
 }
 
 std::string train_stat::generate_report(train_stat::report_type rt) const
@@ -52,14 +192,22 @@ std::string train_stat::generate_report(train_stat::report_type rt) const
     // +----------------------------------------------
     // |   (1/n)·Σ|y-e| ................. 0.2122
     // |   (1/n)·Σ(y-e)² ................ 0.543
+    // |   LONG response mean ± σ ....... 0.4122 ± 0.1310
+    // |   SHORT response mean ± σ ...... -0.3921 ± 0.1201
+    // +----------------------------------------------
+    // | Response histogram:           (if enabled)
+    // +----------------------------------------------
+    // |   [-1.0000, -0.9000) ........... 12
+    // |   ...
     // +----------------------------------------------
     //
 
     std::ostringstream oss;
 
-    unsigned int total_success = get_total_successes();
-    position_type_stats long_info  = get_long_information();
-    position_type_stats short_info = get_short_information();
+    double n = n_ > 0 ? n_ : 1;
+    double average_abs_error = abs_error_sum_ / n;
+    double average_sqr_error = sqr_error_sum_ / n;
+    double bin_width = histogram_.size() ? (histogram_max_ - histogram_min_) / histogram_.size() : 0.0;
 
     switch (rt)
     {
@@ -68,145 +216,95 @@ std::string train_stat::generate_report(train_stat::report_type rt) const
         oss << "+---------------------------------------------\n"
             << "| Total statistics:\n"
             << "+---------------------------------------------\n"
-            << "|   n ............................ " << data_.size() << "\n"
-            << "|   success ...................... " << total_success << "\n"
-            << "|   ratio ........................ " << train_stat::ratio(total_success, data_.size()) << "\n"
-            << "|   pessimistic ratio indicator .. " << train_stat::pessimistic_ratio_indicator(total_success, data_.size()) << "\n"
+            << "|   n ............................ " << n_ << "\n"
+            << "|   success ...................... " << success_ << "\n"
+            << "|   ratio ........................ " << train_stat::ratio(success_, n_) << "\n"
+            << "|   pessimistic ratio indicator .. " << train_stat::pessimistic_ratio_indicator(success_, n_) << "\n"
             << "+---------------------------------------------\n"
             << "| LONG statistics:\n"
             << "+---------------------------------------------\n"
-            << "|   n ............................ " << long_info.second << "\n"
-            << "|   success ...................... " << long_info.first << "\n"
-            << "|   ratio ........................ " << train_stat::ratio(long_info.first, long_info.second) << "\n"
-            << "|   pessimistic ratio indicator .. " << train_stat::pessimistic_ratio_indicator(long_info.first, long_info.second) << "\n"
+            << "|   n ............................ " << long_n_ << "\n"
+            << "|   success ...................... " << long_success_ << "\n"
+            << "|   ratio ........................ " << train_stat::ratio(long_success_, long_n_) << "\n"
+            << "|   pessimistic ratio indicator .. " << train_stat::pessimistic_ratio_indicator(long_success_, long_n_) << "\n"
             << "+---------------------------------------------\n"
             << "| SHORT statistics:\n"
             << "+---------------------------------------------\n"
-            << "|   n ............................ " << short_info.second << "\n"
-            << "|   success ...................... " << short_info.first << "\n"
-            << "|   ratio ........................ " << train_stat::ratio(short_info.first, short_info.second) << "\n"
-            << "|   pessimistic ratio indicator .. " << train_stat::pessimistic_ratio_indicator(short_info.first, short_info.second) << "\n"
+            << "|   n ............................ " << short_n_ << "\n"
+            << "|   success ...................... " << short_success_ << "\n"
+            << "|   ratio ........................ " << train_stat::ratio(short_success_, short_n_) << "\n"
+            << "|   pessimistic ratio indicator .. " << train_stat::pessimistic_ratio_indicator(short_success_, short_n_) << "\n"
             << "+---------------------------------------------\n"
             << "| Additional:\n"
             << "+---------------------------------------------\n"
-            << "|   (1/n)·Σ|y-e| ................. " << get_average_abs_error() << "\n"
-            << "|   (1/n)·Σ(y-e)² ................ " << get_average_sqr_error() << "\n"
+            << "|   (1/n)·Σ|y-e| ................. " << average_abs_error << "\n"
+            << "|   (1/n)·Σ(y-e)² ................ " << average_sqr_error << "\n"
+            << "|   LONG response mean ± σ ....... " << long_moments_.mean << " ± " << sqrt(long_moments_.variance()) << "\n"
+            << "|   SHORT response mean ± σ ...... " << short_moments_.mean << " ± " << sqrt(short_moments_.variance()) << "\n"
             << "+---------------------------------------------";
-        break;
-
-        case JSON:
-
-        oss << "JSON\t{"
-            << "\"n\":" << data_.size()
-            << ",\"success\":" << total_success
-            << ",\"ratio\":" << train_stat::ratio(total_success, data_.size())
-            << ",\"pri\":" << train_stat::pessimistic_ratio_indicator(total_success, data_.size())
-            << ",\"short_n\":" << short_info.second
-            << ",\"short_success\":" << short_info.first
-            << ",\"short_ratio\":" << train_stat::ratio(short_info.first, short_info.second)
-            << ",\"short_pri\":" << train_stat::pessimistic_ratio_indicator(short_info.first, short_info.second)
-            << ",\"long_n\":" << long_info.second
-            << ",\"long_success\":" << long_info.first
-            << ",\"long_ratio\":" << train_stat::ratio(long_info.first, long_info.second)
-            << ",\"long_pri\":" << train_stat::pessimistic_ratio_indicator(long_info.first, long_info.second)
-            << ",\"average_square_error\":" << get_average_sqr_error()
-            << ",\"average_absolute_error\":" << get_average_abs_error()
-            << "}\n";
-        break;
-    }
-
-    return oss.str();
-}
-
-double train_stat::get_pessimistic_ratio_indicator(void) const
-{
-    return train_stat::pessimistic_ratio_indicator(get_total_successes(), data_.size());
-}
-
-unsigned int train_stat::get_total_successes(void) const
-{
-    unsigned int success = 0;
-
-    for (auto &element : data_)
-    {
-        if ((element.first > 0.0 && element.second > 0.0) ||
-            (element.first < 0.0 && element.second < 0.0))
-        {
-            success++;
-        }
-    }
 
-    return success;
-}
-
-train_stat::position_type_stats train_stat::get_long_information(void) const
-{
-    position_type_stats ret;
-    ret.first = 0;
-    ret.second = 0;
-
-    for (auto &element : data_)
-    {
-        if (element.first > 0.0)
+        if (histogram_.size())
         {
-            ret.second++;
+            oss << "\n| Response histogram:\n"
+                << "+---------------------------------------------";
 
-            if (element.second > 0.0)
+            for (size_t i = 0; i < histogram_.size(); i++)
             {
-                ret.first++;
+                oss << "\n|   [" << histogram_min_ + i*bin_width << ", "
+                    << histogram_min_ + (i + 1)*bin_width << ") ... " << histogram_[i];
             }
+
+            oss << "\n+---------------------------------------------";
         }
-    }
 
-    return ret;
-}
+        break;
 
-train_stat::position_type_stats train_stat::get_short_information(void) const
-{
-    position_type_stats ret;
-    ret.first = 0;
-    ret.second = 0;
+        case JSON:
 
-    for (auto &element : data_)
-    {
-        if (element.first < 0.0)
+        oss << "JSON\t{"
+            << "\"n\":" << n_
+            << ",\"success\":" << success_
+            << ",\"ratio\":" << train_stat::ratio(success_, n_)
+            << ",\"pri\":" << train_stat::pessimistic_ratio_indicator(success_, n_)
+            << ",\"short_n\":" << short_n_
+            << ",\"short_success\":" << short_success_
+            << ",\"short_ratio\":" << train_stat::ratio(short_success_, short_n_)
+            << ",\"short_pri\":" << train_stat::pessimistic_ratio_indicator(short_success_, short_n_)
+            << ",\"long_n\":" << long_n_
+            << ",\"long_success\":" << long_success_
+            << ",\"long_ratio\":" << train_stat::ratio(long_success_, long_n_)
+            << ",\"long_pri\":" << train_stat::pessimistic_ratio_indicator(long_success_, long_n_)
+            << ",\"average_square_error\":" << average_sqr_error
+            << ",\"average_absolute_error\":" << average_abs_error
+            << ",\"long_response_mean\":" << long_moments_.mean
+            << ",\"long_response_variance\":" << long_moments_.variance()
+            << ",\"short_response_mean\":" << short_moments_.mean
+            << ",\"short_response_variance\":" << short_moments_.variance();
+
+        if (histogram_.size())
         {
-            ret.second++;
+            oss << ",\"histogram_min\":" << histogram_min_
+                << ",\"histogram_max\":" << histogram_max_
+                << ",\"histogram\":[";
 
-            if (element.second < 0.0)
+            for (size_t i = 0; i < histogram_.size(); i++)
             {
-                ret.first++;
+                oss << (i ? "," : "") << histogram_[i];
             }
-        }
-    }
-
-    return ret;
-}
 
-double train_stat::get_average_abs_error(void) const
-{
-    double v = 0.0;
-    double n = data_.size() > 0 ? data_.size() : 1;
+            oss << "]";
+        }
 
-    for (auto &element : data_)
-    {
-        v += fabs(element.first - element.second);
+        oss << "}\n";
+        break;
     }
 
-    return (v / n);
+    return oss.str();
 }
 
-double train_stat::get_average_sqr_error(void) const
+double train_stat::get_pessimistic_ratio_indicator(void) const
 {
-    double v = 0.0;
-    double n = data_.size() > 0 ? data_.size() : 1;
-
-    for (auto &element : data_)
-    {
-        v += (element.first - element.second)*(element.first - element.second);
-    }
-
-    return (v / n);
+    return train_stat::pessimistic_ratio_indicator(success_, n_);
 }
 
 double train_stat::ratio(unsigned int k, unsigned int n)
@@ -0,0 +1,167 @@
+/**********************************************************************\
+**                                                                    **
+**             -=≡≣ High Frequency Trading System  ≣≡=-              **
+**                                                                    **
+**          Copyright  2017 - 2021 by LLG Ryszard Gradowski          **
+**                       All Rights Reserved.                         **
+**                                                                    **
+**  CAUTION! This application is an intellectual propery              **
+**           of LLG Ryszard Gradowski. This application as            **
+**           well as any part of source code cannot be used,          **
+**           modified and distributed by third party person           **
+**           without prior written permission issued by               **
+**           intellectual property owner.                             **
+**                                                                    **
+\**********************************************************************/
+
+#include <validation_engine.hpp>
+
+validation_engine::validation_engine(const std::string &hftr_file_name,
+                                     const neural_network::layers_architecture &arch,
+                                     unsigned int threads,
+                                     unsigned int histogram_bins,
+                                     hft::activation_accuracy accuracy)
+    : samples_(new hftr_samples(hftr_file_name)), running_(false)
+{
+    create_workers(arch, threads, histogram_bins, accuracy);
+}
+
+validation_engine::validation_engine(std::shared_ptr<const hftr_samples> samples,
+                                     const neural_network::layers_architecture &arch,
+                                     unsigned int threads,
+                                     unsigned int histogram_bins,
+                                     hft::activation_accuracy accuracy)
+    : samples_(samples), running_(false)
+{
+    create_workers(arch, threads, histogram_bins, accuracy);
+}
+
+void validation_engine::create_workers(const neural_network::layers_architecture &arch,
+                                       unsigned int threads,
+                                       unsigned int histogram_bins,
+                                       hft::activation_accuracy accuracy)
+{
+    size_t n = samples_ -> size();
+
+    if (threads == 0)
+    {
+        threads = 1;
+    }
+
+    if (threads > n)
+    {
+        threads = n > 0 ? n : 1;
+    }
+
+    workers_.resize(threads);
+
+    size_t chunk = n / threads;
+    size_t remain = n % threads;
+    size_t first = 0;
+
+    for (size_t i = 0; i < workers_.size(); i++)
+    {
+        worker_data &w = workers_[i];
+
+        w.replica.reset(new basic_artifical_inteligence());
+        w.replica -> set_opt(basic_artifical_inteligence::AI_OPTION_NEVER_HFTR_EXPORT, true);
+        w.replica -> set_opt(basic_artifical_inteligence::AI_OPTION_HFT_MULTICORE, false);
+        w.replica -> set_opt(basic_artifical_inteligence::AI_OPTION_VERBOSE, false);
+        w.nid = w.replica -> add_neural_network(arch, accuracy);
+
+        if (histogram_bins > 0)
+        {
+            w.stat.enable_histogram(histogram_bins);
+        }
+
+        w.first = first;
+        w.last = first + chunk + (i < remain ? 1 : 0);
+        first = w.last;
+    }
+}
+
+validation_engine::~validation_engine(void)
+{
+    if (running_)
+    {
+        try
+        {
+            wait();
+        }
+        catch (...)
+        {
+            // Nobody to report to.
+        }
+    }
+}
+
+void validation_engine::start(const std::string &network_snapshot)
+{
+    if (running_)
+    {
+        wait();
+    }
+
+    snapshot_ = network_snapshot;
+
+    for (auto &w : workers_)
+    {
+        w.stat.clear();
+        w.error = nullptr;
+        w.thread.reset(new std::thread(&validation_engine::thread_funct, this, &w));
+    }
+
+    running_ = true;
+}
+
+train_stat validation_engine::wait(void)
+{
+    if (! running_)
+    {
+        throw exception("Validation not started");
+    }
+
+    for (auto &w : workers_)
+    {
+        w.thread -> join();
+        w.thread.reset();
+    }
+
+    running_ = false;
+
+    for (auto &w : workers_)
+    {
+        if (w.error)
+        {
+            std::rethrow_exception(w.error);
+        }
+    }
+
+    train_stat ret = workers_.at(0).stat;
+
+    for (size_t i = 1; i < workers_.size(); i++)
+    {
+        ret.merge(workers_[i].stat);
+    }
+
+    return ret;
+}
+
+void validation_engine::thread_funct(validation_engine::worker_data *self)
+{
+    try
+    {
+        self -> replica -> load_network_from_buffer(self -> nid, snapshot_);
+
+        for (size_t i = self -> first; i < self -> last; i++)
+        {
+            self -> replica -> import_input_bus(samples_ -> get_pins(i), samples_ -> get_inputs());
+            self -> replica -> fireup_networks();
+            self -> stat.store(self -> replica -> get_network_output(self -> nid), samples_ -> get_expected(i));
+        }
+    }
+    catch (...)
+    {
+        self -> error = std::current_exception();
+    }
+}
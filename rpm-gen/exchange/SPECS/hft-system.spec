@@ -43,6 +43,10 @@ popd
 rm -rf $RPM_BUILD_ROOT
 mkdir -p $RPM_BUILD_ROOT%{_sbindir}
 install -m 755 -p hft/hft $RPM_BUILD_ROOT%{_sbindir}/hft
+mkdir -p $RPM_BUILD_ROOT%{_libdir}
+install -m 755 -p hft/libhftshm.so $RPM_BUILD_ROOT%{_libdir}/libhftshm.so
+mkdir -p $RPM_BUILD_ROOT%{_includedir}
+install -m 644 -p hft/include/hft_shm_client.h $RPM_BUILD_ROOT%{_includedir}/hft_shm_client.h
 mkdir -p $RPM_BUILD_ROOT%{_sysconfdir}/hft
 install -m 644 -p hft/deploy/hftd.conf.default $RPM_BUILD_ROOT%{_sysconfdir}/hft/hftd.conf
 install -m 644 -p hft/deploy/bridges.json  $RPM_BUILD_ROOT%{_sysconfdir}/hft/bridges.json
@@ -95,6 +99,8 @@ rm -rf $RPM_BUILD_ROOT
 %files
 %defattr(-,root,root)
 %{_sbindir}/hft
+%{_libdir}/libhftshm.so
+%{_includedir}/hft_shm_client.h
 %{_sbindir}/caans
 %{_bindir}/hft-manifest-edit
 %{_bindir}/hft-watchdog